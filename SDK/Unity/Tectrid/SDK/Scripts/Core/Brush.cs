@@ -14,7 +14,8 @@ namespace Tectrid
             Flatten,
             Drag,
             Dig,
-            CADDrag
+            CADDrag,
+            Smooth
         };
 
         public Brush(EditableMesh associatedTectridMesh, Type brushType)
@@ -39,6 +40,9 @@ namespace Tectrid
                 case Type.CADDrag:
                     _brush = DLL.BrushCADDrag_Create(associatedTectridMesh.GetInnerPtr());
                     break;
+                case Type.Smooth:
+                    _brush = DLL.BrushSmooth_Create(associatedTectridMesh.GetInnerPtr());
+                    break;
             }
             BrushType = brushType;
         }
@@ -73,6 +77,23 @@ namespace Tectrid
             DLL.Brush_EndStroke(_brush);
         }
 
+        public void SetBatchStrokeSamples(bool batchStrokeSamples)
+        {
+            DLL.Brush_SetBatchStrokeSamples(_brush, batchStrokeSamples);
+        }
+
+        public void SetSmoothIterations(uint nbIterations)
+        {
+            if (BrushType == Type.Smooth)
+                DLL.BrushSmooth_SetIterations(_brush, nbIterations);
+        }
+
+        public void SetSmoothTaubin(bool taubin)
+        {
+            if (BrushType == Type.Smooth)
+                DLL.BrushSmooth_SetTaubin(_brush, taubin);
+        }
+
         private IntPtr _brush;
     }
 }
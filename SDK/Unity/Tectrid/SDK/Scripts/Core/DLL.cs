@@ -55,6 +55,8 @@ namespace Tectrid
 
         [DllImport("TectridSDK")]
         static extern public bool Mesh_GetClosestIntersectionPoint(IntPtr mesh, IntPtr meshRotAndScale3x3Matrix, IntPtr meshPosition, IntPtr ray, IntPtr intersectionPoint, IntPtr intersectionNormal);
+        [DllImport("TectridSDK")]
+        static extern public uint Mesh_IntersectRays(IntPtr mesh, IntPtr meshRotAndScale3x3Matrix, IntPtr meshPosition, IntPtr rays, uint nbRays, IntPtr intersectionPoints, IntPtr intersectionNormals, IntPtr intersectionTriangles);
 
         [DllImport("TectridSDK")]
         static extern public IntPtr BrushDraw_Create(IntPtr mesh);
@@ -69,11 +71,19 @@ namespace Tectrid
         [DllImport("TectridSDK")]
         static extern public IntPtr BrushCADDrag_Create(IntPtr mesh);
         [DllImport("TectridSDK")]
+        static extern public IntPtr BrushSmooth_Create(IntPtr mesh);
+        [DllImport("TectridSDK")]
         static extern public void Brush_StartStroke(IntPtr brush);
         [DllImport("TectridSDK")]
         static extern public void Brush_UpdateStroke(IntPtr brush, IntPtr meshRotAndScale3x3Matrix, IntPtr meshPosition, IntPtr rayOrigin, IntPtr rayDirection, float rayLength, float radius, float strengthRatio);
         [DllImport("TectridSDK")]
         static extern public void Brush_EndStroke(IntPtr brush);
+        [DllImport("TectridSDK")]
+        static extern public void Brush_SetBatchStrokeSamples(IntPtr brush, bool batchStrokeSamples);
+        [DllImport("TectridSDK")]
+        static extern public void BrushSmooth_SetIterations(IntPtr brush, uint nbIterations);
+        [DllImport("TectridSDK")]
+        static extern public void BrushSmooth_SetTaubin(IntPtr brush, bool taubin);
 
         [DllImport("TectridSDK")]
         static extern public IntPtr Brush_Delete(IntPtr brush);
@@ -87,6 +97,18 @@ namespace Tectrid
         static extern public IntPtr Mesh_GetSubMesh(IntPtr mesh, uint index);
         [DllImport("TectridSDK")]
         static extern public bool Mesh_IsSubMeshExist(IntPtr mesh, uint submeshID);
+        [DllImport("TectridSDK")]
+        static extern public void Mesh_SetSubMeshesShareBuffers(IntPtr mesh, bool shareBuffers);
+        [DllImport("TectridSDK")]
+        static extern public void Mesh_SetUseBVH(IntPtr mesh, bool useBVH);
+        [DllImport("TectridSDK")]
+        static extern public void Mesh_SetOctreeLooseness(IntPtr mesh, float looseness);
+        [DllImport("TectridSDK")]
+        static extern public void Mesh_SetOctreeLeafCapacity(IntPtr mesh, uint maxTrianglesPerLeaf);
+        [DllImport("TectridSDK")]
+        static extern public uint Mesh_AutoTuneOctreeLeafCapacity(IntPtr mesh);
+        [DllImport("TectridSDK")]
+        static extern public void Mesh_SetSubMeshesMaxVertices(IntPtr mesh, uint maxVertices);
 
         [DllImport("TectridSDK")]
         static extern public uint SubMesh_GetID(IntPtr subMesh);
@@ -104,6 +126,14 @@ namespace Tectrid
         static extern public void SubMesh_FillVertices(IntPtr subMesh, IntPtr data);
         [DllImport("TectridSDK")]
         static extern public void SubMesh_FillNormals(IntPtr subMesh, IntPtr data);
+        [DllImport("TectridSDK")]
+        static extern public int SubMesh_GetNbDirtyRanges(IntPtr subMesh, uint fromVersionNumber);
+        [DllImport("TectridSDK")]
+        static extern public void SubMesh_GetDirtyRanges(IntPtr subMesh, IntPtr data);
+        [DllImport("TectridSDK")]
+        static extern public void SubMesh_FillVerticesRange(IntPtr subMesh, uint firstVertex, uint nbVertices, IntPtr data);
+        [DllImport("TectridSDK")]
+        static extern public void SubMesh_FillNormalsRange(IntPtr subMesh, uint firstVertex, uint nbVertices, IntPtr data);
 
         // CSG / Boolean meshes
         [DllImport("TectridSDK")]
@@ -50,8 +50,12 @@ namespace Tectrid
             uint curVersionNumber = DLL.SubMesh_GetVersionNumber(_subMesh);
             if (_versionNumber != curVersionNumber)  // Only update data if sub mesh has been updated
             {
+                int nbDirtyRanges = DLL.SubMesh_GetNbDirtyRanges(_subMesh, _versionNumber);
+                if (nbDirtyRanges >= 0)
+                    PatchMeshData(nbDirtyRanges);   // Only some vertices moved
+                else
+                    BuildMeshData();
                 _versionNumber = curVersionNumber;
-                BuildMeshData();
             }
         }
 
@@ -88,6 +92,40 @@ namespace Tectrid
             _mesh.triangles = _triangles;
         }
 
+        private void PatchMeshData(int nbDirtyRanges)
+        {
+            // Dirty ranges are (first vertex, vertex count) pairs
+            int[] dirtyRanges = new int[nbDirtyRanges * 2];
+            GCHandle gcDirtyRanges = GCHandle.Alloc(dirtyRanges, GCHandleType.Pinned);
+            DLL.SubMesh_GetDirtyRanges(_subMesh, gcDirtyRanges.AddrOfPinnedObject());
+            gcDirtyRanges.Free();
+            GCHandle gcVertices = GCHandle.Alloc(_vertices, GCHandleType.Pinned);
+            GCHandle gcNormals = GCHandle.Alloc(_normals, GCHandleType.Pinned);
+            for (int i = 0; i < dirtyRanges.Length; i += 2)
+            {
+                DLL.SubMesh_FillVerticesRange(_subMesh, (uint)dirtyRanges[i], (uint)dirtyRanges[i + 1], gcVertices.AddrOfPinnedObject());
+                DLL.SubMesh_FillNormalsRange(_subMesh, (uint)dirtyRanges[i], (uint)dirtyRanges[i + 1], gcNormals.AddrOfPinnedObject());
+            }
+            gcVertices.Free();
+            gcNormals.Free();
+#if UNITY_2019_3_OR_NEWER
+            // Only upload the dirty ranges, the bounds come from the sub mesh instead of a pass over all the vertices
+            const UnityEngine.Rendering.MeshUpdateFlags updateFlags = UnityEngine.Rendering.MeshUpdateFlags.DontRecalculateBounds | UnityEngine.Rendering.MeshUpdateFlags.DontValidateIndices;
+            for (int i = 0; i < dirtyRanges.Length; i += 2)
+            {
+                _mesh.SetVertices(_vertices, dirtyRanges[i], dirtyRanges[i + 1], updateFlags);
+                _mesh.SetNormals(_normals, dirtyRanges[i], dirtyRanges[i + 1], updateFlags);
+            }
+            Bounds bounds = _mesh.bounds;
+            GetBBox(ref bounds);
+            _mesh.bounds = bounds;
+#else
+            // Partial uploads need Unity 2019.3, re-upload the whole arrays
+            _mesh.vertices = _vertices;
+            _mesh.normals = _normals;
+#endif
+        }
+
         public void SetMaterial(Material material)
         {
             MeshRenderer mr = _gameObject.GetComponent<MeshRenderer>();
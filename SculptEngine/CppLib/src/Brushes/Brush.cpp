@@ -13,6 +13,7 @@ void Brush::StartStroke()
 #endif // DEBUG_BRUSHES
 	_strokeStarted = true;
 	_lastRay.Invalidate();
+	_mesh.ResetOctreeExtractionCounters();	// So that they count this stroke extractions
 	if(SculptEngine::IsMirrorModeActivated() && (_mirroredBrush != nullptr))
 		_mirroredBrush->StartStroke();
 }
@@ -35,10 +36,27 @@ void Brush::EndStroke()
 		_mesh.HandlePendingRemovals();
 #endif // !CLEAN_PENDING_REMOVALS_IMMEDIATELY
 		_mesh.ReBalanceOctree(std::vector<unsigned int>(), std::vector<unsigned int>(), false);
+		_mesh.ShrinkFragmentsBBox();
+		_mesh.ReorderIfFragmented();
 		_mesh.TakeSnapShot();
+		_mesh.GrabScratchArena().Reset();
 	}
 }
 
+void Brush::SetUseFalloffLUT(bool useFalloffLUT)
+{
+	_useFalloffLUT = useFalloffLUT;
+	if(_mirroredBrush != nullptr)
+		_mirroredBrush->SetUseFalloffLUT(useFalloffLUT);
+}
+
+void Brush::SetBatchStrokeSamples(bool batchStrokeSamples)
+{
+	_batchStrokeSamples = batchStrokeSamples;
+	if(_mirroredBrush != nullptr)
+		_mirroredBrush->SetBatchStrokeSamples(batchStrokeSamples);
+}
+
 void Brush::UpdateStroke(Ray const& ray, float radius, float strengthRatio)
 {
 	CommandRecorder::GetInstance().Push(std::unique_ptr<Command>(new CommandUpdateStroke(_type, ray, radius, strengthRatio)));
@@ -69,6 +87,7 @@ void Brush::UpdateStroke(Ray const& ray, float radius, float strengthRatio)
 				Vector3 curDir = _lastRay.GetDirection() + deltaRayDirStep;
 				float curLength = _lastRay.GetLength() + deltaRayLengthStep;				
 				Vector3 curIntersectionPos = intersectionPos;
+				_deferMeshUpdate = _batchStrokeSamples;
 				for(float cursor = step; cursor <= 1.0f; cursor += step)	// Don't start with cursor at zero as we already apply brush at first UpdateStroke call
 				{
 					Vector3 curIntersectionNormal;
@@ -76,8 +95,9 @@ void Brush::UpdateStroke(Ray const& ray, float radius, float strengthRatio)
 					if(_mesh.GetClosestIntersectionPoint(_curRay, curIntersectionPos, &curIntersectionNormal, true))
 					{
 						DoStroke(curIntersectionPos, curIntersectionNormal, radius, strengthRatio);
-						_mesh.RecomputeNormals(true);
-						_mesh.RecomputeFragmentsBBox(false);
+						_mesh.RecomputeNormals(true);	// Next sample lands on the modified surface, and brushes read the normals (moved vertices grow the cells bbox as well)
+						if(!_deferMeshUpdate)
+							_mesh.RecomputeFragmentsBBox(false);
 					}
 #ifdef DEBUG_BRUSHES
 					else
@@ -87,6 +107,19 @@ void Brush::UpdateStroke(Ray const& ray, float radius, float strengthRatio)
 					curDir += deltaRayDirStep;	// Todo: implement a slerp
 					curLength += deltaRayLengthStep;
 				}
+				if(_deferMeshUpdate)
+				{	// Once for all the batched samples
+					_deferMeshUpdate = false;
+					if(_hasDeferredRemovals)
+						HandlePendingRemovals();
+					if(_hasDeferredOctreeUpdate)
+					{
+						_hasDeferredOctreeUpdate = false;
+						_mesh.ReBalanceOctree(std::vector<unsigned int>(), std::vector<unsigned int>(), false);	// Generated geometry is already in the octree, extracts what moved out of its cell then recomputes bboxes
+					}
+					else
+						_mesh.RecomputeFragmentsBBox(false);
+				}
 				/*#ifndef __EMSCRIPTEN__
 				if((_lastIntersection - intersection).Length() > 0.0f)
 				__debugbreak();
@@ -148,24 +181,56 @@ void Brush::DoStroke(Vector3 const& curIntersectionPos, Vector3 const& /*curInte
 	// Insert generated vertices and triangle into the octree
 	if((_mesh.GrabRetessellator().GetGenratedTris().size() != 0) || (_mesh.GrabRetessellator().GetGenratedVtxs().size() != 0))
 	{
-		_mesh.ReBalanceOctree(_mesh.GrabRetessellator().GetGenratedTris(), _mesh.GrabRetessellator().GetGenratedVtxs(), false);
+		if(_deferMeshUpdate)
+		{	// Next samples need to find the new geometry, the rest of the octree update waits for the last batched sample
+			_mesh.InsertInOctree(_mesh.GrabRetessellator().GetGenratedTris(), _mesh.GrabRetessellator().GetGenratedVtxs());
+			_hasDeferredOctreeUpdate = true;
+		}
+		else
+			_mesh.ReBalanceOctree(_mesh.GrabRetessellator().GetGenratedTris(), _mesh.GrabRetessellator().GetGenratedVtxs(), false);
 		_mesh.RecomputeNormals(true);
-		_mesh.RecomputeFragmentsBBox(false);
+		if(!_deferMeshUpdate)
+			_mesh.RecomputeFragmentsBBox(false);
 	}
 	// Handle vertex and triangle removal
 	if(_mesh.GrabRetessellator().WasSomethingMerged())
 	{
+		if(_deferMeshUpdate)
+			_hasDeferredRemovals = true;	// Removed elements stay in the octree until the last batched sample, visitors skip them
+		else
+			HandlePendingRemovals();
+	}
+	_mesh.GrabRetessellator().Reset();
+}
+
+DabJob Brush::PrepareDab(std::vector<unsigned int> const* vtxsIdx, Vector3 const& center, float radius, DAB_FALLOFF falloff)
+{
+	_movedVtxsIdx.clear();
+	DabJob job;
+	job.vertices = &_mesh.GrabVertices();
+	job.vtxsIdx = (vtxsIdx != nullptr) ? vtxsIdx->data() : nullptr;
+	job.nbVtxs = (vtxsIdx != nullptr) ? (unsigned int) vtxsIdx->size() : 0;
+	job.center = center;
+	job.radius = radius;
+	job.falloff = falloff;
+	job.useFalloffLUT = _useFalloffLUT;
+	job.scratch = &_dabScratch;
+	job.movedVtxsIdx = &_movedVtxsIdx;
+	return job;
+}
+
+void Brush::HandlePendingRemovals()
+{
+	_hasDeferredRemovals = false;
 #ifdef CLEAN_PENDING_REMOVALS_IMMEDIATELY
-		_mesh.HandlePendingRemovals();
+	_mesh.HandlePendingRemovals();
 #else
-		// Purge from octree vertices and triangles that were set to be removed and remap the vertices and triangles index of the one that will be moved
-		OctreeVisitorHandlePendingRemovals handlePendingRemovals(_mesh, false);
-		_mesh.GrabOctreeRoot().Traverse(handlePendingRemovals);
-		// Now octree got rid of deleted vertices, now we will be able to recycle them
-		_mesh.TransferPendingRemovesToRecycle();
+	// Purge from octree vertices and triangles that were set to be removed and remap the vertices and triangles index of the one that will be moved
+	OctreeVisitorHandlePendingRemovals handlePendingRemovals(_mesh, false);
+	_mesh.GrabOctreeRoot().ParallelTraverse(handlePendingRemovals);
+	// Now octree got rid of deleted vertices, now we will be able to recycle them
+	_mesh.TransferPendingRemovesToRecycle();
 #endif // !CLEAN_PENDING_REMOVALS_IMMEDIATELY
-	}
-	_mesh.GrabRetessellator().Reset();
 }
 
 #ifdef __EMSCRIPTEN__ 
@@ -177,6 +242,8 @@ EMSCRIPTEN_BINDINGS(Brush)
 	class_<Brush>("Brush")
 		.function("StartStroke", &Brush::StartStroke)
 		.function("UpdateStroke", &Brush::UpdateStroke)
-		.function("EndStroke", &Brush::EndStroke);
+		.function("EndStroke", &Brush::EndStroke)
+		.function("SetBatchStrokeSamples", &Brush::SetBatchStrokeSamples)
+		.function("IsBatchingStrokeSamples", &Brush::IsBatchingStrokeSamples);
 }
 #endif // __EMSCRIPTEN__
\ No newline at end of file
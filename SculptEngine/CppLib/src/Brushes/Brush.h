@@ -3,6 +3,7 @@
 
 #include "Mesh\Mesh.h"
 #include "Math\Math.h"
+#include "DabKernels.h"
 
 //#define DEBUG_BRUSHES
 
@@ -21,7 +22,7 @@ enum BRUSHTYPE: unsigned char
 class Brush
 {
 public:
-	Brush(Mesh& mesh, BRUSHTYPE type): _mesh(mesh), _type(type), _strokeStarted(false) {}
+	Brush(Mesh& mesh, BRUSHTYPE type): _mesh(mesh), _type(type), _useFalloffLUT(false), _batchStrokeSamples(false), _deferMeshUpdate(false), _hasDeferredRemovals(false), _hasDeferredOctreeUpdate(false), _strokeStarted(false) {}
 
 	void StartStroke();
 	virtual void UpdateStroke(Ray const& ray, float radius, float strengthRatio);
@@ -31,10 +32,16 @@ public:
 	Vector3 const& GetLastIntersection() { return _lastIntersectionPos; }
 #endif // BRUSHES_DEBUG_DRAW
 
+	void SetBatchStrokeSamples(bool batchStrokeSamples);	// Time aliasing samples of an UpdateStroke only update normals and insert new geometry in between, octree rebalance, bboxes and pending removals are handled once for all of them
+	bool IsBatchingStrokeSamples() const { return _batchStrokeSamples; }
+	void SetUseFalloffLUT(bool useFalloffLUT);	// Dab falloff read from a precomputed table instead of being evaluated
+
 protected:
 	virtual void DoStroke(Vector3 const& curIntersectionPos, Vector3 const& curIntersectionNormal, float radius, float strengthRatio);
+	DabJob PrepareDab(std::vector<unsigned int> const* vtxsIdx, Vector3 const& center, float radius, DAB_FALLOFF falloff);	// Clears _movedVtxsIdx, that ApplyDab fills. "vtxsIdx" can be null, to be set later
 
 private:
+	void HandlePendingRemovals();
 	virtual float GetEffectRadiusPercentForTimeAliasing() { return 0.3f; }	// Return 0.0 to cancel time aliasing
 	
 protected:
@@ -45,6 +52,13 @@ protected:
 	Vector3 _motionDir;
 	std::unique_ptr<Brush> _mirroredBrush;
 	BRUSHTYPE _type;
+	DabScratch _dabScratch;
+	std::vector<unsigned int> _movedVtxsIdx;
+	bool _useFalloffLUT;
+	bool _batchStrokeSamples;
+	bool _deferMeshUpdate;	// Set while applying batched samples: DoStroke leaves octree rebalance, bboxes and pending removals to UpdateStroke
+	bool _hasDeferredRemovals;
+	bool _hasDeferredOctreeUpdate;
 
 private:
 	bool _strokeStarted;
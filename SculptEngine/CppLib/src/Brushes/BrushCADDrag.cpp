@@ -158,7 +158,7 @@ void BrushCADDrag::SelectFace(unsigned int inputTriIdx, std::vector<unsigned int
 		bool processSurroundings = true;
 		for(unsigned int i = 0; i < 3; ++i)
 		{
-			std::vector<unsigned int> const& trisAround = _mesh.GetTrianglesAroundVertex(triToTreatVtxIdxs[i]);
+			TriangleFan trisAround = _mesh.GetTrianglesAroundVertex(triToTreatVtxIdxs[i]);
 			for(unsigned int triAround : trisAround)
 			{
 				if((triAround != triToTreat) && (smoothGroup[triAround] == curSmoothGroup))
@@ -176,7 +176,7 @@ void BrushCADDrag::SelectFace(unsigned int inputTriIdx, std::vector<unsigned int
 		{
 			for(unsigned int i = 0; i < 3; ++i)
 			{
-				std::vector<unsigned int> const& trisAround = _mesh.GetTrianglesAroundVertex(triToTreatVtxIdxs[i]);
+				TriangleFan trisAround = _mesh.GetTrianglesAroundVertex(triToTreatVtxIdxs[i]);
 				for(unsigned int triAround : trisAround)
 				{
 					if((triAround != triToTreat) && (smoothGroup[triAround] == UNDEFINED_NEW_ID))
@@ -4,9 +4,32 @@
 #include "Math\Plane.h"
 #include "Mesh\ThicknessHandler.h"
 
+namespace
+{
+	// Push vertices down to the plane, along its normal
+	struct DigDisplacement
+	{
+		DigDisplacement(Plane const& plane, float effectRatio) : _plane(plane), _effectRatio(effectRatio) {}
+
+		template <class S>
+		typename S::Float GetTransformValue(typename S::Float ratio, typename S::Float x, typename S::Float y, typename S::Float z) const
+		{
+			Vector3 const& normal = _plane.GetNormal();
+			typename S::Float dot = S::Add(S::Add(S::Mul(S::Set1(normal.x), x), S::Mul(S::Set1(normal.y), y)), S::Mul(S::Set1(normal.z), z));
+			typename S::Float transformValue = S::Mul(S::Mul(ratio, S::Set1(_effectRatio)), S::Sub(S::Set1(_plane.GetDistanceToOrigin()), dot));	// ratio * effectRatio * -distToPlane
+			return S::Min(transformValue, S::Set1(0.0f));
+		}
+		Vector3 const& GetDirection(unsigned int /*vtxIdx*/) const { return _plane.GetNormal(); }
+
+		Plane const& _plane;
+		float _effectRatio;
+	};
+}
+
 void BrushDig::DoStroke(Vector3 const& curIntersectionPos, Vector3 const& curIntersectionNormal, float radius, float strengthRatio)
 {
 	Brush::DoStroke(curIntersectionPos, curIntersectionNormal, radius, strengthRatio);
+	ScratchArena::Scope scratchScope(_mesh.GrabScratchArena());	// Dab temporaries are given back on return
 	// Collect vertices
 	ThicknessHandler thicknessHandler(_mesh);
 	static float selectAngleCosLimit = cosf(100.0f * float(M_PI) / 180.0f);
@@ -15,38 +38,17 @@ void BrushDig::DoStroke(Vector3 const& curIntersectionPos, Vector3 const& curInt
 #else
 	OctreeVisitorCollectVertices collectVertices(_mesh, curIntersectionPos, radius, nullptr, selectAngleCosLimit, true, false, thicknessHandler);
 #endif // !THICKNESS_HANDLER_WIP
-	_mesh.GrabOctreeRoot().Traverse(collectVertices);
+	_mesh.GrabOctreeRoot().ParallelTraverse(collectVertices);
 	// Get average normal and build flatten plane
 	Vector3 averageNormal = collectVertices.ComputeAverageNormal();
 	Plane projectionPlane(curIntersectionPos + averageNormal * -0.5f * radius, averageNormal);
 	// Apply distortion
-	float radiusSquared = sqr(radius);
-	float invRadius = 1.0f / radius;
 	float effectRatio = lerp(0.01f, 0.39f, strengthRatio);
-	std::vector<Vector3>& verticesFullmesh = _mesh.GrabVertices();
-	std::vector<unsigned int> const& verticesIdx = collectVertices.GetVertices();
-	for(unsigned int const& vtxIdx : verticesIdx)
-	{
-		Vector3& vertex = verticesFullmesh[vtxIdx];
-		float distSquared = vertex.DistanceSquared(curIntersectionPos);
-		if(distSquared < radiusSquared)
-		{
-			float distToPlane = projectionPlane.DistanceToVertex(vertex);
-			// Compute and apply position transformation
-			float x = lerp(0.0f, 1.0f, sqrtf(distSquared) * invRadius);
-			float ratio = (cosf(x * float(M_PI)) / 2.0f) + 0.5f;
-			float transformValue = ratio * effectRatio * -distToPlane;
-			if(transformValue < 0.0f)
-			{
-				vertex += projectionPlane.GetNormal() * transformValue;
-				thicknessHandler.AddVertexToMovedList(vtxIdx);
-				// Set vertex and surrounding triangles state to "dirty" regarding normal computing
-				_mesh.SetHasToRecomputeNormal(vtxIdx);
-			}
-		}
-		else
-			ASSERT(false);
-	}
+	ApplyDab(PrepareDab(&collectVertices.GetVertices(), curIntersectionPos, radius, DAB_FALLOFF_COSINE), DigDisplacement(projectionPlane, effectRatio));
+	for(unsigned int const& vtxIdx : _movedVtxsIdx)
+		thicknessHandler.AddVertexToMovedList(vtxIdx);
+	// Set moved vertices and surrounding triangles state to "dirty" regarding normal computing
+	_mesh.SetHasToRecomputeNormals(_movedVtxsIdx);
 	thicknessHandler.ReshapeRegardingThickness(ThicknessHandler::FUSION_MODE_PIERCE);
 }
 
@@ -82,10 +82,11 @@ void BrushDrag::DoStroke(Vector3 const& curIntersectionPos, Vector3 const& curIn
 	float adaptRadius = ComputeRadiusRatioFromAttractorDist(radius) * radius;	// Dragging thinner when attractor gets far
 	_projectionSphereCenter = curIntersectionPos - (curIntersectionNormal * 0.5f * adaptRadius);
 	Brush::DoStroke(_projectionSphereCenter, curIntersectionNormal, adaptRadius, strengthRatio);
+	ScratchArena::Scope scratchScope(_mesh.GrabScratchArena());	// Dab temporaries are given back on return
 	// Collect vertices
 	ThicknessHandler thicknessHandler(_mesh);
 	OctreeVisitorCollectVertices collectVertices(_mesh, _projectionSphereCenter, adaptRadius, nullptr/*&curIntersectionNormal*/, 0.0f, true, false, thicknessHandler);
-	_mesh.GrabOctreeRoot().Traverse(collectVertices);
+	_mesh.GrabOctreeRoot().ParallelTraverse(collectVertices);
 	// Apply distortion
 	auto ApplyDistortion = [&](Vector3& vertex)->bool
 	{
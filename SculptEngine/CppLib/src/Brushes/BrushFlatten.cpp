@@ -3,51 +3,49 @@
 #include "Math\Plane.h"
 #include "Mesh\ThicknessHandler.h"
 
+namespace
+{
+	// Bring vertices onto the plane, from both sides
+	struct FlattenDisplacement
+	{
+		FlattenDisplacement(Plane const& plane, float effectRatio) : _plane(plane), _effectRatio(effectRatio) {}
+
+		template <class S>
+		typename S::Float GetTransformValue(typename S::Float ratio, typename S::Float x, typename S::Float y, typename S::Float z) const
+		{
+			Vector3 const& normal = _plane.GetNormal();
+			typename S::Float dot = S::Add(S::Add(S::Mul(S::Set1(normal.x), x), S::Mul(S::Set1(normal.y), y)), S::Mul(S::Set1(normal.z), z));
+			return S::Mul(S::Mul(ratio, S::Set1(_effectRatio)), S::Sub(S::Set1(_plane.GetDistanceToOrigin()), dot));	// ratio * effectRatio * -distToPlane
+		}
+		Vector3 const& GetDirection(unsigned int /*vtxIdx*/) const { return _plane.GetNormal(); }
+
+		Plane const& _plane;
+		float _effectRatio;
+	};
+}
+
 void BrushFlatten::DoStroke(Vector3 const& curIntersectionPos, Vector3 const& curIntersectionNormal, float radius, float strengthRatio)
 {
 	Brush::DoStroke(curIntersectionPos, curIntersectionNormal, radius, strengthRatio);
+	ScratchArena::Scope scratchScope(_mesh.GrabScratchArena());	// Dab temporaries are given back on return
 	// Collect vertices
 	ThicknessHandler thicknessHandler(_mesh);
 	OctreeVisitorCollectVertices collectVertices(_mesh, curIntersectionPos, radius, &curIntersectionNormal, 0.0f, true, true, thicknessHandler);
-	_mesh.GrabOctreeRoot().Traverse(collectVertices);
+	_mesh.GrabOctreeRoot().ParallelTraverse(collectVertices);
 	// Get average normal and build flatten plane
 	Vector3 averageNormal = collectVertices.ComputeAverageNormal();
 	Vector3 averagePosition = collectVertices.ComputeAveragePosition();
 	Plane projectionPlane(averagePosition, averageNormal);
 	// Apply distortion
-	float radiusSquared = sqr(radius);
-	float invRadius = 1.0f / radius;
 	float effectRatio = lerp(0.1f, 1.0f, strengthRatio);
-	std::vector<Vector3>& verticesFullmesh = _mesh.GrabVertices();
+	FlattenDisplacement flattenDisplacement(projectionPlane, effectRatio);
 	auto ApplyDistorsion = [&](std::vector<unsigned int> const& verticesIdx)
 	{
-		for(unsigned int const& vtxIdx : verticesIdx)
-		{
-			Vector3& vertex = verticesFullmesh[vtxIdx];
-			float distSquared = vertex.DistanceSquared(curIntersectionPos);
-			if(distSquared < radiusSquared)
-			{
-				float distToPlane = projectionPlane.DistanceToVertex(vertex);
-				// Compute and apply position transformation
-				float x = lerp(0.0f, 1.0f, sqrtf(distSquared) * invRadius);
-				//float ratio = 1.0f;
-				//float ratio = (cosf(x * float(M_PI)) / 2.0f) + 0.5f;
-				float ratio = 3 * pow(x, 4.0f) - 4 * pow(x, 3.0f) + 1;
-				//if(Input.GetKey(KeyCode.LeftAlt))
-				//	ratio = -ratio;
-				//vertex += normalsFullMesh[vtxIdx] * ratio * -distToPlane;
-				float transformValue = ratio * effectRatio * -distToPlane;
-				if(transformValue != 0.0f)
-				{
-					vertex += projectionPlane.GetNormal() * transformValue;
-					thicknessHandler.AddVertexToMovedList(vtxIdx);
-					// Set vertex and surrounding triangles state to "dirty" regarding normal computing
-					_mesh.SetHasToRecomputeNormal(vtxIdx);
-				}
-			}
-			else
-				ASSERT(false);
-		}
+		ApplyDab(PrepareDab(&verticesIdx, curIntersectionPos, radius, DAB_FALLOFF_POLYNOMIAL), flattenDisplacement);
+		for(unsigned int const& vtxIdx : _movedVtxsIdx)
+			thicknessHandler.AddVertexToMovedList(vtxIdx);
+		// Set moved vertices and surrounding triangles state to "dirty" regarding normal computing
+		_mesh.SetHasToRecomputeNormals(_movedVtxsIdx);
 	};
 	ApplyDistorsion(collectVertices.GetVertices());
 	ApplyDistorsion(collectVertices.GetRejectedVertices());	// Also flatten reject vertices (the one that are back oriented). This is to provide a consistent transformation: like you flatten a nose, and want the nostrils interior to be involved in the flatten.
@@ -2,46 +2,42 @@
 #include "Mesh\OctreeVisitorCollectVertices.h"
 #include "Mesh\ThicknessHandler.h"
 
+namespace
+{
+	// Push vertices along their own normal
+	struct InflateDisplacement
+	{
+		InflateDisplacement(std::vector<Vector3> const& normals, float radius, float effectRatio) : _normals(normals), _radius(radius), _effectRatio(effectRatio) {}
+
+		template <class S>
+		typename S::Float GetTransformValue(typename S::Float ratio, typename S::Float /*x*/, typename S::Float /*y*/, typename S::Float /*z*/) const
+		{
+			return S::Max(S::Mul(S::Mul(ratio, S::Set1(_radius)), S::Set1(_effectRatio)), S::Set1(0.0f));
+		}
+		Vector3 const& GetDirection(unsigned int vtxIdx) const { return _normals[vtxIdx]; }
+
+		std::vector<Vector3> const& _normals;
+		float _radius;
+		float _effectRatio;
+	};
+}
+
 void BrushInflate::DoStroke(Vector3 const& curIntersectionPos, Vector3 const& curIntersectionNormal, float radius, float strengthRatio)
 {
 	Brush::DoStroke(curIntersectionPos, curIntersectionNormal, radius, strengthRatio);
+	ScratchArena::Scope scratchScope(_mesh.GrabScratchArena());	// Dab temporaries are given back on return
 	// Collect vertices
 	static float selectAngleCosLimit = cosf(100.0f * float(M_PI) / 180.0f);
 	ThicknessHandler thicknessHandler(_mesh);
 	OctreeVisitorCollectVertices collectVertices(_mesh, curIntersectionPos, radius, &curIntersectionNormal, selectAngleCosLimit, true, false, thicknessHandler);
-	_mesh.GrabOctreeRoot().Traverse(collectVertices);
+	_mesh.GrabOctreeRoot().ParallelTraverse(collectVertices);
 	// Apply distortion
-	float radiusSquared = sqr(radius);
-	float invRadius = 1.0f / radius;
 	float effectRatio = lerp(0.01f, 0.17f, strengthRatio);
-	std::vector<Vector3>& verticesFullmesh = _mesh.GrabVertices();
-	std::vector<Vector3> const& normalsFullMesh = _mesh.GetNormals();
-	std::vector<unsigned int> const& verticesIdx = collectVertices.GetVertices();
-	for(unsigned int const& vtxIdx : verticesIdx)
-	{
-		Vector3& vertex = verticesFullmesh[vtxIdx];
-		float distSquared = vertex.DistanceSquared(curIntersectionPos);
-		if(distSquared < radiusSquared)
-		{
-			// Compute and apply position transformation
-			float x = lerp(0.0f, 1.0f, sqrtf(distSquared) * invRadius);
-			float xsquare = x * x;
-			//float ratio = (cosf(x * float(M_PI)) / 2.0f) + 0.5f;
-			float ratio = 3 * xsquare * xsquare - 4 * xsquare * x + 1;
-			//if(Input.GetKey(KeyCode.LeftAlt))
-			//	ratio = -ratio;
-			float transformValue = ratio * radius * effectRatio;
-			if(transformValue > 0.0f)
-			{
-				vertex += normalsFullMesh[vtxIdx] * transformValue;
-				thicknessHandler.AddVertexToMovedList(vtxIdx);
-				// Set vertex and surrounding triangles state to "dirty" regarding normal computing
-				_mesh.SetHasToRecomputeNormal(vtxIdx);
-			}
-		}
-		else
-			ASSERT(false);
-	}
+	ApplyDab(PrepareDab(&collectVertices.GetVertices(), curIntersectionPos, radius, DAB_FALLOFF_POLYNOMIAL), InflateDisplacement(_mesh.GetNormals(), radius, effectRatio));
+	for(unsigned int const& vtxIdx : _movedVtxsIdx)
+		thicknessHandler.AddVertexToMovedList(vtxIdx);
+	// Set moved vertices and surrounding triangles state to "dirty" regarding normal computing
+	_mesh.SetHasToRecomputeNormals(_movedVtxsIdx);
 	thicknessHandler.ReshapeRegardingThickness(ThicknessHandler::FUSION_MODE_MERGE);
 }
 
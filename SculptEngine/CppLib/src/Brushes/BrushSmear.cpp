@@ -1,6 +1,26 @@
 ﻿#include "BrushSmear.h"
 #include "Mesh\OctreeVisitorGetAverageInRange.h"
 
+namespace
+{
+	// Push vertices along the stroke motion
+	struct SmearDisplacement
+	{
+		SmearDisplacement(Vector3 const& effectDisplacement, float radius, float smearRatio) : _effectDisplacement(effectDisplacement), _radius(radius), _smearRatio(smearRatio) {}
+
+		template <class S>
+		typename S::Float GetTransformValue(typename S::Float ratio, typename S::Float /*x*/, typename S::Float /*y*/, typename S::Float /*z*/) const
+		{
+			return S::Max(S::Mul(S::Mul(ratio, S::Set1(_radius)), S::Set1(_smearRatio)), S::Set1(0.0f));
+		}
+		Vector3 const& GetDirection(unsigned int /*vtxIdx*/) const { return _effectDisplacement; }
+
+		Vector3 const& _effectDisplacement;
+		float _radius;
+		float _smearRatio;
+	};
+}
+
 bool BrushSmear::Visitor::HasToVisit(OctreeCell& cell)
 {
 	return _rangeSphere.Intersects(cell.GetContentBBox());
@@ -11,46 +31,28 @@ void BrushSmear::Visitor::VisitEnter(OctreeCell& cell)
 	if(!cell.GetTrianglesIdx().empty() || !cell.GetVerticesIdx().empty())
 	{
 		cell.AddStateFlags(CELL_STATE_HASTO_UPDATE_SUB_MESH | CELL_STATE_HASTO_EXTRACT_OUTOFBOUNDS_GEOM);
-		cell.AddStateFlagsUpToRoot(CELL_STATE_HASTO_RECOMPUTE_BBOX);
-		std::vector<Vector3>& verticesFullmesh = _fullMesh.GrabVertices();
-		std::vector<unsigned int> verticesIdx = cell.GetVerticesIdx();
-		for(unsigned int const& vtxIdx : verticesIdx)
-		{
-			Vector3& vertex = verticesFullmesh[vtxIdx];
-			float distSquared = vertex.DistanceSquared(_rangeSphere.GetCenter());
-			if(distSquared < _radiusSquared)
-			{
-				// Compute and apply position transformation
-				float x = lerp(0.0f, 1.0f, sqrtf(distSquared) * _invRadius);
-				float xsquare = x * x;
-				//float ratio = (cosf(x * float(M_PI)) / 2.0f) + 0.5f;
-				float ratio = 3 * xsquare * xsquare - 4 * xsquare * x + 1;
-				//if(Input.GetKey(KeyCode.LeftAlt))
-				//	ratio = -ratio;
-				float transformValue = ratio * _rangeSphere.GetRadius() * _smearRatio;
-				if(transformValue > 0.0f)
-				{
-					vertex += _effectDisplacement * transformValue;
-					// Set vertex and surrounding triangles state to "dirty" regarding normal computing
-					_fullMesh.SetHasToRecomputeNormal(vtxIdx);
-				}
-			}
-			else
-				ASSERT(false);
-		}
+		cell.AddStateFlagsUpToRoot(CELL_STATE_HASTO_GROW_BBOX);
+		IndexList cellVerticesIdx = cell.GetVerticesIdx();	// Read in place, moving the vertices doesn't change the cell lists
+		_dabJob.vtxsIdx = cellVerticesIdx.begin();
+		_dabJob.nbVtxs = cellVerticesIdx.size();
+		_dabJob.movedVtxsIdx->clear();
+		ApplyDab(_dabJob, SmearDisplacement(_effectDisplacement, _rangeSphere.GetRadius(), _smearRatio));
+		// Set moved vertices and surrounding triangles state to "dirty" regarding normal computing
+		_fullMesh.SetHasToRecomputeNormals(*_dabJob.movedVtxsIdx);
 	}
 }
 
 void BrushSmear::DoStroke(Vector3 const& curIntersectionPos, Vector3 const& curIntersectionNormal, float radius, float strengthRatio)
 {
 	Brush::DoStroke(curIntersectionPos, curIntersectionNormal, radius, strengthRatio);
+	ScratchArena::Scope scratchScope(_mesh.GrabScratchArena());	// Dab temporaries are given back on return
 	Vector3 effectDisplacement = _curRay.GetOrigin() - _lastRay.GetOrigin();
 	if(effectDisplacement.LengthSquared() > 0.0f)
 	{
 		effectDisplacement.Normalize();
 		VisitorGetAverageInRange getAverageVisitor(_mesh, curIntersectionPos, radius);
 		_mesh.GrabOctreeRoot().Traverse(getAverageVisitor);
-		Visitor smear(_mesh, getAverageVisitor.GetAveragePoint(), radius, strengthRatio, effectDisplacement);
+		Visitor smear(_mesh, PrepareDab(nullptr, getAverageVisitor.GetAveragePoint(), radius, DAB_FALLOFF_POLYNOMIAL), strengthRatio, effectDisplacement);
 		_mesh.GrabOctreeRoot().Traverse(smear);
 	}
 }
@@ -9,10 +9,8 @@ class BrushSmear : public Brush
 	class Visitor : public OctreeVisitor
 	{
 	public:
-		Visitor(Mesh& fullMesh, Vector3 const& sourcePoint, float radius, float strengthRatio, Vector3 const& effectDisplacement) : OctreeVisitor(), _fullMesh(fullMesh), _rangeSphere(sourcePoint, radius), _effectDisplacement(effectDisplacement)
+		Visitor(Mesh& fullMesh, DabJob const& dabJob, float strengthRatio, Vector3 const& effectDisplacement) : OctreeVisitor(), _fullMesh(fullMesh), _rangeSphere(dabJob.center, dabJob.radius), _effectDisplacement(effectDisplacement), _dabJob(dabJob)
 		{
-			_radiusSquared = sqr(_rangeSphere.GetRadius());
-			_invRadius = 1.0f / _rangeSphere.GetRadius();
 			_smearRatio = lerp(0.005f, 0.05f, strengthRatio);
 		}
 		virtual bool HasToVisit(OctreeCell& cell);
@@ -22,10 +20,9 @@ class BrushSmear : public Brush
 	private:
 		Mesh& _fullMesh;
 		BSphere _rangeSphere;
-		float _radiusSquared;
 		Vector3 const _effectDisplacement;
-		float _invRadius;
 		float _smearRatio;
+		DabJob _dabJob;
 	};
 
 public:
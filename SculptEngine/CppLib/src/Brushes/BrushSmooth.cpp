@@ -5,55 +5,36 @@
 void BrushSmooth::DoStroke(Vector3 const& curIntersectionPos, Vector3 const& curIntersectionNormal, float radius, float strengthRatio)
 {
 	Brush::DoStroke(curIntersectionPos, curIntersectionNormal, radius, strengthRatio);
+	ScratchArena::Scope scratchScope(_mesh.GrabScratchArena());	// Dab temporaries are given back on return
 	// Collect vertices
 	static float selectAngleCosLimit = cosf(100.0f * float(M_PI) / 180.0f);
 	ThicknessHandler thicknessHandler(_mesh);
 	OctreeVisitorCollectVertices collectVertices(_mesh, curIntersectionPos, radius, nullptr, selectAngleCosLimit, true, false, thicknessHandler);
-	_mesh.GrabOctreeRoot().Traverse(collectVertices);
+	_mesh.GrabOctreeRoot().ParallelTraverse(collectVertices);
 	// Apply distortion
-	std::vector<Vector3> verticesIn = _mesh.GetVertices();
-	std::vector<Vector3>& verticesOut = _mesh.GrabVertices();
 	std::vector<unsigned int> const& verticesIdx = collectVertices.GetVertices();
+	SmoothDab(_mesh, verticesIdx, _nbIterations, _taubin, _smoothScratch);
 	for(unsigned int const& vtxIdx : verticesIdx)
-	{
-		Vector3 averageVertex;
-		unsigned int nbVerticesInvolved = 0;
-		if(1)
-		{
-			for(unsigned int triIdx : _mesh.GetTrianglesAroundVertex(vtxIdx))
-			{
-				unsigned int const* vtxIdxs = &(_mesh.GetTriangles()[triIdx * 3]);
-				for(unsigned int i = 0; i < 3; ++i)
-				{
-					if(vtxIdxs[i] != vtxIdx)
-					{
-						averageVertex += verticesIn[vtxIdxs[i]];
-						nbVerticesInvolved++;
-					}
-				}
-			}
-			verticesOut[vtxIdx] = averageVertex / float(nbVerticesInvolved);
-			thicknessHandler.AddVertexToMovedList(vtxIdx);
-		}
-		else
-		{
-			float sqrLimit = sqr(radius / 10.0f);
-			for(unsigned int const& vtxOtherIdx : verticesIdx)
-			{
-				if(verticesIn[vtxIdx].DistanceSquared(verticesIn[vtxOtherIdx]) < sqrLimit)
-				{
-					averageVertex += verticesIn[vtxOtherIdx];
-					nbVerticesInvolved++;
-				}
-			}
-			verticesOut[vtxIdx] = verticesIn[vtxIdx].Lerp(averageVertex / float(nbVerticesInvolved), 0.5f);
-			thicknessHandler.AddVertexToMovedList(vtxIdx);
-		}
-		_mesh.SetHasToRecomputeNormal(vtxIdx);
-	}
+		thicknessHandler.AddVertexToMovedList(vtxIdx);
+	// Set moved vertices and surrounding triangles state to "dirty" regarding normal computing
+	_mesh.SetHasToRecomputeNormals(verticesIdx);
 	thicknessHandler.ReshapeRegardingThickness(ThicknessHandler::FUSION_MODE_PIERCE);
 }
 
+void BrushSmooth::SetIterations(unsigned int nbIterations)
+{
+	_nbIterations = nbIterations;
+	if(_mirroredBrush != nullptr)
+		static_cast<BrushSmooth*>(_mirroredBrush.get())->SetIterations(nbIterations);
+}
+
+void BrushSmooth::SetTaubin(bool taubin)
+{
+	_taubin = taubin;
+	if(_mirroredBrush != nullptr)
+		static_cast<BrushSmooth*>(_mirroredBrush.get())->SetTaubin(taubin);
+}
+
 #ifdef __EMSCRIPTEN__ 
 #include <emscripten/bind.h>
 using namespace emscripten;
@@ -61,6 +42,10 @@ using namespace emscripten;
 EMSCRIPTEN_BINDINGS(BrushSmooth)
 {
 	class_<BrushSmooth, base<Brush>>("BrushSmooth")
-		.constructor<Mesh&>();
+		.constructor<Mesh&>()
+		.function("SetIterations", &BrushSmooth::SetIterations)
+		.function("GetIterations", &BrushSmooth::GetIterations)
+		.function("SetTaubin", &BrushSmooth::SetTaubin)
+		.function("IsTaubin", &BrushSmooth::IsTaubin);
 }
 #endif // __EMSCRIPTEN__
\ No newline at end of file
@@ -6,16 +6,25 @@
 class BrushSmooth : public Brush
 {
 public:
-	BrushSmooth(Mesh& mesh) : Brush(mesh, BRUSHTYPE_SMOOTH)
+	BrushSmooth(Mesh& mesh) : Brush(mesh, BRUSHTYPE_SMOOTH), _nbIterations(1), _taubin(false)
 	{
 		_mirroredBrush.reset(new BrushSmooth(mesh, true));
 	}
 
+	void SetIterations(unsigned int nbIterations);	// Smoothing iterations per dab
+	unsigned int GetIterations() const { return _nbIterations; }
+	void SetTaubin(bool taubin);	// Taubin smoothing (shrink then inflate steps) instead of the plain Laplacian one, to keep the volume
+	bool IsTaubin() const { return _taubin; }
+
 private:
-	BrushSmooth(Mesh& mesh, bool /*mirroredBrush*/) : Brush(mesh, BRUSHTYPE_SMOOTH) { }
+	BrushSmooth(Mesh& mesh, bool /*mirroredBrush*/) : Brush(mesh, BRUSHTYPE_SMOOTH), _nbIterations(1), _taubin(false) { }
 	virtual float GetEffectRadiusPercentForTimeAliasing() { return 0.0f; }	// Return 0.0 to cancel time aliasing
 
 	virtual void DoStroke(Vector3 const& curIntersectionPos, Vector3 const& curIntersectionNormal, float radius, float strengthRatio);
+
+	SmoothScratch _smoothScratch;	// Kept from dab to dab
+	unsigned int _nbIterations;
+	bool _taubin;
 };
 
 #endif // _BRUSH_SMOOTH_H_
\ No newline at end of file
@@ -0,0 +1,117 @@
+﻿#include "DabKernels.h"
+#include "Mesh\Mesh.h"
+
+namespace
+{
+	const float TAUBIN_LAMBDA = 0.5f;
+	const float TAUBIN_MU = -0.53f;
+
+	struct FalloffLUT
+	{
+		FalloffLUT(DAB_FALLOFF falloff)
+		{
+			for(unsigned int i = 0; i <= DAB_FALLOFF_LUT_SIZE; ++i)
+			{
+				float x = float(i) / float(DAB_FALLOFF_LUT_SIZE);
+				float xSquare = x * x;
+				_values[i] = (falloff == DAB_FALLOFF_POLYNOMIAL) ? (3 * xSquare * xSquare - 4 * xSquare * x + 1) : ((cosf(x * float(M_PI)) / 2.0f) + 0.5f);
+			}
+		}
+
+		float _values[DAB_FALLOFF_LUT_SIZE + 1];
+	};
+}
+
+float const* GetDabFalloffLUT(DAB_FALLOFF falloff)
+{
+	static FalloffLUT const cosineLUT(DAB_FALLOFF_COSINE);
+	static FalloffLUT const polynomialLUT(DAB_FALLOFF_POLYNOMIAL);
+	return (falloff == DAB_FALLOFF_POLYNOMIAL) ? polynomialLUT._values : cosineLUT._values;
+}
+
+void SmoothDab(Mesh& mesh, std::vector<unsigned int> const& vtxsIdx, unsigned int nbIterations, bool taubin, SmoothScratch& scratch)
+{
+	std::vector<Vector3>& vertices = mesh.GrabVertices();
+	std::vector<unsigned int> const& triangles = mesh.GetTriangles();
+	unsigned int nbDabVtxs = (unsigned int) vtxsIdx.size();
+	if((nbDabVtxs == 0) || (nbIterations == 0))
+		return;
+	// Snapshot dab vertices and their one-ring
+	if(scratch.globalToLocal.size() < vertices.size())
+		scratch.globalToLocal.resize(vertices.size(), UNDEFINED_NEW_ID);
+	scratch.localToGlobal.assign(vtxsIdx.begin(), vtxsIdx.end());
+	for(unsigned int i = 0; i < nbDabVtxs; ++i)
+		scratch.globalToLocal[vtxsIdx[i]] = i;
+	scratch.ringsStart.resize(nbDabVtxs + 1);
+	scratch.ringsLocalIdx.clear();
+	for(unsigned int i = 0; i < nbDabVtxs; ++i)
+	{
+		unsigned int vtxIdx = vtxsIdx[i];
+		scratch.ringsStart[i] = (unsigned int) scratch.ringsLocalIdx.size();
+		for(unsigned int triIdx : mesh.GetTrianglesAroundVertex(vtxIdx))
+		{
+			unsigned int const* triVtxsIdx = &(triangles[triIdx * 3]);
+			for(unsigned int j = 0; j < 3; ++j)
+			{
+				unsigned int otherIdx = triVtxsIdx[j];
+				if(otherIdx != vtxIdx)
+				{
+					unsigned int& localIdx = scratch.globalToLocal[otherIdx];
+					if(localIdx == UNDEFINED_NEW_ID)
+					{
+						localIdx = (unsigned int) scratch.localToGlobal.size();
+						scratch.localToGlobal.push_back(otherIdx);
+					}
+					scratch.ringsLocalIdx.push_back(localIdx);
+				}
+			}
+		}
+	}
+	scratch.ringsStart[nbDabVtxs] = (unsigned int) scratch.ringsLocalIdx.size();
+	unsigned int nbSnapshotVtxs = (unsigned int) scratch.localToGlobal.size();
+	for(std::vector<Vector3>& positions : scratch.positions)
+	{
+		positions.resize(nbSnapshotVtxs);
+		for(unsigned int i = 0; i < nbSnapshotVtxs; ++i)
+			positions[i] = vertices[scratch.localToGlobal[i]];
+	}
+	for(unsigned int globalIdx : scratch.localToGlobal)
+		scratch.globalToLocal[globalIdx] = UNDEFINED_NEW_ID;
+	// Iterate, each step moving the dab vertices toward (or away from with a negative weight) the average of their one-ring
+	unsigned int cur = 0;
+	auto Step = [&](float weight)
+	{
+		std::vector<Vector3> const& positionsIn = scratch.positions[cur];
+		std::vector<Vector3>& positionsOut = scratch.positions[1 - cur];
+#pragma omp parallel for
+		for(int i = 0; i < (int) nbDabVtxs; ++i)
+		{
+			unsigned int ringStart = scratch.ringsStart[i];
+			unsigned int ringEnd = scratch.ringsStart[i + 1];
+			if(ringStart == ringEnd)
+			{
+				positionsOut[i] = positionsIn[i];
+				continue;
+			}
+			Vector3 averageVertex;
+			for(unsigned int j = ringStart; j < ringEnd; ++j)
+				averageVertex += positionsIn[scratch.ringsLocalIdx[j]];
+			averageVertex = averageVertex / float(ringEnd - ringStart);
+			positionsOut[i] = (weight == 1.0f) ? averageVertex : positionsIn[i].Lerp(averageVertex, weight);
+		}
+		cur = 1 - cur;
+	};
+	for(unsigned int iteration = 0; iteration < nbIterations; ++iteration)
+	{
+		if(taubin)
+		{
+			Step(TAUBIN_LAMBDA);
+			Step(TAUBIN_MU);
+		}
+		else
+			Step(1.0f);
+	}
+	// Write back dab vertices
+	for(unsigned int i = 0; i < nbDabVtxs; ++i)
+		vertices[vtxsIdx[i]] = scratch.positions[cur][i];
+}
@@ -0,0 +1,203 @@
+﻿#ifndef _DAB_KERNELS_H_
+#define _DAB_KERNELS_H_
+
+#include <vector>
+#include "Math\Vector.h"
+#include "Math\Vector3SoA.h"
+#include "Math\SimdTraits.h"
+
+class Mesh;
+
+// Common layer applying a brush "dab" (one stroke sample) on a set of vertices:
+// vertices are gathered into SoA scratch, falloff and displacement amount are evaluated with SIMD (SSE/AVX/NEON/wasm-simd, with a scalar fallback), then moved vertices are scattered back.
+// Each brush only gives its displacement functor, as a template parameter so there is no virtual call per vertex. A displacement functor provides:
+//	template <class S> typename S::Float GetTransformValue(typename S::Float ratio, typename S::Float x, typename S::Float y, typename S::Float z) const;	// Displacement amount from falloff ratio and vertex position, 0 to leave the vertex unchanged
+//	Vector3 GetDirection(unsigned int vtxIdx) const;	// Displacement direction, only asked for the vertices that move
+
+enum DAB_FALLOFF
+{
+	DAB_FALLOFF_COSINE,	// (cos(x * PI) / 2) + 0.5
+	DAB_FALLOFF_POLYNOMIAL	// 3x^4 - 4x^3 + 1
+};
+
+const unsigned int DAB_FALLOFF_LUT_SIZE = 1024;	// Intervals of the falloff look up tables (sampled on [0, 1], SIZE + 1 values)
+const unsigned int DAB_CHUNK_SIZE = 256 * SIMD_BLOCK_SIZE;	// Vertices per thread task, big dabs are split across threads
+
+float const* GetDabFalloffLUT(DAB_FALLOFF falloff);
+
+inline float SampleDabFalloffLUT(float const* lut, float x)	// x in [0, 1], linear interpolation between samples
+{
+	float pos = x * float(DAB_FALLOFF_LUT_SIZE);
+	unsigned int index = min((unsigned int) pos, DAB_FALLOFF_LUT_SIZE - 1);
+	return lut[index] + ((lut[index + 1] - lut[index]) * (pos - float(index)));
+}
+
+// Kept from dab to dab (by the brush) so that the scratch streams are not reallocated each time
+struct DabScratch
+{
+	Vector3SoA positions;
+	AlignedFloatVector transformValues;
+	std::vector<std::vector<unsigned int>> chunksMovedVtxsIdx;	// Each thread task fills its own list, they are appended in order to the job one
+};
+
+struct DabJob
+{
+	std::vector<Vector3>* vertices;
+	unsigned int const* vtxsIdx;	// Vertices to treat (no duplicates), those outside of the dab sphere are left unchanged
+	unsigned int nbVtxs;
+	Vector3 center;
+	float radius;
+	DAB_FALLOFF falloff;
+	bool useFalloffLUT;
+	DabScratch* scratch;
+	std::vector<unsigned int>* movedVtxsIdx;	// Vertices really moved are appended to it
+};
+
+template <class S>
+typename S::Float EvaluateDabFalloff(DAB_FALLOFF falloff, typename S::Float x)
+{
+	typedef typename S::Float Float;
+	if(falloff == DAB_FALLOFF_POLYNOMIAL)
+	{
+		Float xSquare = S::Mul(x, x);
+		return S::Add(S::Sub(S::Mul(S::Mul(S::Set1(3.0f), xSquare), xSquare), S::Mul(S::Mul(S::Set1(4.0f), xSquare), x)), S::Set1(1.0f));
+	}
+	// cos(x * PI) = -sin((x - 0.5) * PI), the sine being expanded up to a^11 on [-PI/2, PI/2] (error below float precision)
+	Float a = S::Mul(S::Sub(x, S::Set1(0.5f)), S::Set1(float(M_PI)));
+	Float aSquare = S::Mul(a, a);
+	Float sine = S::Set1(-1.0f / 39916800.0f);
+	sine = S::Add(S::Mul(sine, aSquare), S::Set1(1.0f / 362880.0f));
+	sine = S::Add(S::Mul(sine, aSquare), S::Set1(-1.0f / 5040.0f));
+	sine = S::Add(S::Mul(sine, aSquare), S::Set1(1.0f / 120.0f));
+	sine = S::Add(S::Mul(sine, aSquare), S::Set1(-1.0f / 6.0f));
+	sine = S::Add(S::Mul(sine, aSquare), S::Set1(1.0f));
+	sine = S::Mul(sine, a);
+	return S::Sub(S::Set1(0.5f), S::Mul(sine, S::Set1(0.5f)));
+}
+
+// Treats the vertices [begin, end[ of the job, begin being a multiple of SIMD_BLOCK_SIZE
+template <class S, class Displacement>
+void ApplyDabChunkT(DabJob const& job, Displacement const& displacement, unsigned int begin, unsigned int end, std::vector<unsigned int>& movedVtxsIdx)
+{
+	typedef typename S::Float Float;
+	const unsigned int W = S::Width;
+	DabScratch& scratch = *job.scratch;
+	std::vector<Vector3>& vertices = *job.vertices;
+	unsigned int const* vtxsIdx = job.vtxsIdx;
+	// Gather
+	float* xs = scratch.positions.GrabX();
+	float* ys = scratch.positions.GrabY();
+	float* zs = scratch.positions.GrabZ();
+	for(unsigned int i = begin; i < end; ++i)
+	{
+		Vector3 const& vertex = vertices[vtxsIdx[i]];
+		xs[i] = vertex.x;
+		ys[i] = vertex.y;
+		zs[i] = vertex.z;
+	}
+	// Falloff and displacement amount
+	unsigned int paddedEnd = min(((end + SIMD_BLOCK_SIZE - 1) / SIMD_BLOCK_SIZE) * SIMD_BLOCK_SIZE, scratch.positions.PaddedSize());
+	float* transformValues = scratch.transformValues.data();
+	float const* lut = job.useFalloffLUT ? GetDabFalloffLUT(job.falloff) : nullptr;
+	alignas(32) float lanes[W];
+	Float const centerX = S::Set1(job.center.x), centerY = S::Set1(job.center.y), centerZ = S::Set1(job.center.z);
+	Float const radiusSquared = S::Set1(sqr(job.radius));
+	Float const invRadius = S::Set1(1.0f / job.radius);
+	Float const zero = S::Set1(0.0f), one = S::Set1(1.0f);
+	for(unsigned int i = begin; i < paddedEnd; i += W)
+	{
+		Float x = S::Load(xs + i), y = S::Load(ys + i), z = S::Load(zs + i);
+		Float dx = S::Sub(x, centerX), dy = S::Sub(y, centerY), dz = S::Sub(z, centerZ);
+		Float distSquared = S::Add(S::Add(S::Mul(dx, dx), S::Mul(dy, dy)), S::Mul(dz, dz));
+		Float distRatio = S::Max(S::Min(S::Mul(S::Sqrt(distSquared), invRadius), one), zero);
+		Float ratio;
+		if(lut != nullptr)
+		{
+			S::Store(lanes, distRatio);
+			for(unsigned int lane = 0; lane < W; ++lane)
+				lanes[lane] = SampleDabFalloffLUT(lut, lanes[lane]);
+			ratio = S::Load(lanes);
+		}
+		else
+			ratio = EvaluateDabFalloff<S>(job.falloff, distRatio);
+		Float transformValue = displacement.template GetTransformValue<S>(ratio, x, y, z);
+		S::Store(transformValues + i, S::Select(S::CmpLt(distSquared, radiusSquared), transformValue, zero));
+	}
+	// Scatter
+	for(unsigned int i = begin; i < end; ++i)
+	{
+		if(transformValues[i] != 0.0f)
+		{
+			unsigned int vtxIdx = vtxsIdx[i];
+			vertices[vtxIdx] += displacement.GetDirection(vtxIdx) * transformValues[i];
+			movedVtxsIdx.push_back(vtxIdx);
+		}
+	}
+}
+
+template <class S, class Displacement>
+void ApplyDabT(DabJob const& job, Displacement const& displacement)
+{
+	DabScratch& scratch = *job.scratch;
+	unsigned int nbVtxs = job.nbVtxs;
+	scratch.positions.Resize(nbVtxs);
+	scratch.transformValues.resize(scratch.positions.PaddedSize());
+	int nbChunks = int((nbVtxs + DAB_CHUNK_SIZE - 1) / DAB_CHUNK_SIZE);
+	if(nbChunks == 1)
+	{
+		ApplyDabChunkT<S>(job, displacement, 0, nbVtxs, *job.movedVtxsIdx);
+		return;
+	}
+	// Vertices of the job are all different, so chunks never move the same vertex
+	if(scratch.chunksMovedVtxsIdx.size() < (size_t) nbChunks)
+		scratch.chunksMovedVtxsIdx.resize(nbChunks);
+#pragma omp parallel for
+	for(int chunk = 0; chunk < nbChunks; ++chunk)
+	{
+		unsigned int begin = (unsigned int) chunk * DAB_CHUNK_SIZE;
+		std::vector<unsigned int>& chunkMovedVtxsIdx = scratch.chunksMovedVtxsIdx[chunk];
+		chunkMovedVtxsIdx.clear();
+		ApplyDabChunkT<S>(job, displacement, begin, min(begin + DAB_CHUNK_SIZE, nbVtxs), chunkMovedVtxsIdx);
+	}
+	for(int chunk = 0; chunk < nbChunks; ++chunk)
+		job.movedVtxsIdx->insert(job.movedVtxsIdx->end(), scratch.chunksMovedVtxsIdx[chunk].begin(), scratch.chunksMovedVtxsIdx[chunk].end());
+}
+
+template <class Displacement>
+void ApplyDab(DabJob const& job, Displacement const& displacement)
+{
+	if(job.nbVtxs == 0)
+		return;
+	switch(GetSimdKernelType())
+	{
+#ifdef SIMD_AVX
+	case SIMD_KERNEL_AVX: ApplyDabT<SimdAVX>(job, displacement); break;
+#endif // SIMD_AVX
+#ifdef SIMD_SSE
+	case SIMD_KERNEL_SSE: ApplyDabT<SimdSSE>(job, displacement); break;
+#endif // SIMD_SSE
+#ifdef SIMD_NEON
+	case SIMD_KERNEL_NEON: ApplyDabT<SimdNEON>(job, displacement); break;
+#endif // SIMD_NEON
+#ifdef SIMD_WASM
+	case SIMD_KERNEL_WASM: ApplyDabT<SimdWasm>(job, displacement); break;
+#endif // SIMD_WASM
+	default: ApplyDabT<SimdScalar>(job, displacement); break;
+	}
+}
+
+// Laplacian smoothing of a dab, working on a snapshot of the vertices and their one-ring (the mesh is never copied).
+// Iterations are Jacobi ones (every vertex reads the previous iteration positions), so vertices are treated in parallel with the same result whatever the number of threads.
+// With Taubin smoothing each iteration is a shrinking step followed by an inflating one, so the volume is kept.
+struct SmoothScratch
+{
+	std::vector<Vector3> positions[2];	// Snapshot, ping-pong between iterations: the dab vertices first, then their neighbours outside of the dab (that don't move)
+	std::vector<unsigned int> ringsStart;	// Range of each dab vertex in ringsLocalIdx (dab vertices count + 1 values)
+	std::vector<unsigned int> ringsLocalIdx;	// Neighbours in snapshot index, once per surrounding triangle (so the average is weighted as the mesh's one)
+	std::vector<unsigned int> localToGlobal;
+	std::vector<unsigned int> globalToLocal;	// Sized on the mesh vertices, UNDEFINED_NEW_ID except while building the snapshot
+};
+
+void SmoothDab(Mesh& mesh, std::vector<unsigned int> const& vtxsIdx, unsigned int nbIterations, bool taubin, SmoothScratch& scratch);
+
+#endif // _DAB_KERNELS_H_
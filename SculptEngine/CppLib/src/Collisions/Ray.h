@@ -24,6 +24,12 @@ public:
 
 	// Found here: http://gamedev.stackexchange.com/questions/18436/most-efficient-aabb-vs-ray-collision-algorithms/
 	bool Intersects(BBox const& b) const
+	{
+		float entryDistance;
+		return Intersects(b, entryDistance);
+	}
+
+	bool Intersects(BBox const& b, float& entryDistance) const	// "entryDistance" is 0 if the ray starts inside the box
 	{
 		// r.dir is unit direction vector of ray
 		Vector3 dirfrac((GetDirection().x != 0.0f) ? 1.0f / GetDirection().x : 1000000.0f,
@@ -57,7 +63,10 @@ public:
 
 		//colDist = tmin;
 		if(tmin <= GetLength())
+		{
+			entryDistance = max(tmin, 0.0f);
 			return true;
+		}
 		else
 			return false;	// Collide, but too far
 	}
@@ -0,0 +1,54 @@
+﻿#ifndef _ALIGNED_ALLOCATOR_H_
+#define _ALIGNED_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+
+const size_t SIMD_ALIGNMENT = 64;	// Cache line size, also covers SSE (16), AVX (32) and AVX-512 (64) loads
+
+// Minimal std allocator giving "Alignment" aligned blocks, so std::vector can be used for SIMD friendly streams
+template <typename T, size_t Alignment = SIMD_ALIGNMENT>
+class AlignedAllocator
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef T const* const_pointer;
+	typedef T& reference;
+	typedef T const& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template <typename U>
+	struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+	AlignedAllocator() {}
+	template <typename U>
+	AlignedAllocator(AlignedAllocator<U, Alignment> const& /*other*/) {}
+
+	T* allocate(size_t count)
+	{
+		// Over allocate, then store the original pointer just before the aligned block
+		void* rawPtr = malloc(count * sizeof(T) + Alignment + sizeof(void*));
+		if(rawPtr == nullptr)
+			throw std::bad_alloc();
+		uintptr_t alignedAddr = (reinterpret_cast<uintptr_t>(rawPtr) + sizeof(void*) + Alignment - 1) & ~(uintptr_t(Alignment) - 1);
+		reinterpret_cast<void**>(alignedAddr)[-1] = rawPtr;
+		return reinterpret_cast<T*>(alignedAddr);
+	}
+
+	void deallocate(T* ptr, size_t /*count*/)
+	{
+		if(ptr != nullptr)
+			free(reinterpret_cast<void**>(ptr)[-1]);
+	}
+
+	template <typename U>
+	bool operator==(AlignedAllocator<U, Alignment> const& /*other*/) const { return true; }
+	template <typename U>
+	bool operator!=(AlignedAllocator<U, Alignment> const& /*other*/) const { return false; }
+};
+
+#endif // _ALIGNED_ALLOCATOR_H_
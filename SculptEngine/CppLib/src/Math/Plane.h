@@ -25,6 +25,7 @@ public:
 	}
 
 	Vector3 const& GetNormal() const { return _n; }
+	float GetDistanceToOrigin() const { return _d; }	// Signed, along the normal
 
 	void Flip()
 	{
@@ -0,0 +1,55 @@
+﻿#include "SimdTraits.h"
+
+namespace
+{
+	bool forceScalarKernels = false;
+
+	SIMD_KERNEL_TYPE DetectBestSimdKernelType()
+	{
+#if defined(SIMD_AVX)
+	#ifdef _MSC_VER
+		// CPU must support AVX, and the OS must save the YMM registers
+		int cpuInfo[4];
+		__cpuid(cpuInfo, 1);
+		bool osUsesXSave = (cpuInfo[2] & (1 << 27)) != 0;
+		bool cpuHasAvx = (cpuInfo[2] & (1 << 28)) != 0;
+		if(osUsesXSave && cpuHasAvx && ((_xgetbv(0) & 6) == 6))
+			return SIMD_KERNEL_AVX;
+		return SIMD_KERNEL_SSE;
+	#else
+		return SIMD_KERNEL_AVX;	// Compiled with -mavx
+	#endif // _MSC_VER
+#elif defined(SIMD_SSE)
+		return SIMD_KERNEL_SSE;
+#elif defined(SIMD_NEON)
+		return SIMD_KERNEL_NEON;
+#elif defined(SIMD_WASM)
+		return SIMD_KERNEL_WASM;
+#else
+		return SIMD_KERNEL_SCALAR;
+#endif
+	}
+}
+
+SIMD_KERNEL_TYPE GetSimdKernelType()
+{
+	static const SIMD_KERNEL_TYPE bestKernelType = DetectBestSimdKernelType();
+	return forceScalarKernels ? SIMD_KERNEL_SCALAR : bestKernelType;
+}
+
+char const* GetSimdKernelName(SIMD_KERNEL_TYPE type)
+{
+	switch(type)
+	{
+	case SIMD_KERNEL_SSE: return "SSE";
+	case SIMD_KERNEL_AVX: return "AVX";
+	case SIMD_KERNEL_NEON: return "NEON";
+	case SIMD_KERNEL_WASM: return "wasm-simd";
+	default: return "scalar";
+	}
+}
+
+void ForceScalarKernels(bool value)
+{
+	forceScalarKernels = value;
+}
@@ -0,0 +1,188 @@
+﻿#ifndef _SIMD_TRAITS_H_
+#define _SIMD_TRAITS_H_
+
+#include "Math.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE__) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 1))
+	#define SIMD_SSE
+	#include <xmmintrin.h>
+	#if defined(_MSC_VER) || defined(__AVX__)	// MSVC lets use AVX intrinsics without /arch:AVX, other compilers need -mavx
+		#define SIMD_AVX
+		#include <immintrin.h>
+		#ifdef _MSC_VER
+			#include <intrin.h>
+		#endif // _MSC_VER
+	#endif // defined(_MSC_VER) || defined(__AVX__)
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && (defined(__aarch64__) || defined(_M_ARM64))	// vdivq_f32 and vsqrtq_f32 are AArch64 only
+	#define SIMD_NEON
+	#include <arm_neon.h>
+#elif defined(__wasm_simd128__)	// em++ with -msimd128
+	#define SIMD_WASM
+	#include <wasm_simd128.h>
+#endif
+
+enum SIMD_KERNEL_TYPE
+{
+	SIMD_KERNEL_SCALAR,
+	SIMD_KERNEL_SSE,
+	SIMD_KERNEL_AVX,
+	SIMD_KERNEL_NEON,
+	SIMD_KERNEL_WASM
+};
+
+SIMD_KERNEL_TYPE GetSimdKernelType();	// Best kernel for the running CPU (or scalar if forced)
+char const* GetSimdKernelName(SIMD_KERNEL_TYPE type);
+void ForceScalarKernels(bool value);	// To compare the SIMD results against the scalar ones
+
+// Each "SIMD traits" gives the same small set of operations, on a register of "Width" floats.
+// Comparisons give a "Mask" (all bits set in the lanes where the test is true), "MoveMask" packs it into one bit per lane.
+// Min and Max behave as Math.h min() and max(), NaNs included (the first operand is returned only if the comparison holds).
+// Kernels are written once as templates on these traits, then dispatched on GetSimdKernelType().
+
+struct SimdScalar
+{
+	typedef float Float;
+	typedef bool Mask;
+	static const unsigned int Width = 1;
+	static Float Load(float const* ptr) { return *ptr; }
+	static void Store(float* ptr, Float value) { *ptr = value; }
+	static Float Set1(float value) { return value; }
+	static Float Add(Float a, Float b) { return a + b; }
+	static Float Sub(Float a, Float b) { return a - b; }
+	static Float Mul(Float a, Float b) { return a * b; }
+	static Float Div(Float a, Float b) { return a / b; }
+	static Float Sqrt(Float a) { return sqrtf(a); }
+	static Float Min(Float a, Float b) { return min(a, b); }
+	static Float Max(Float a, Float b) { return max(a, b); }
+	static Float SelectIfNotZero(Float test, Float ifNotZero, Float ifZero) { return (test != 0.0f) ? ifNotZero : ifZero; }
+	static Float Select(Mask mask, Float ifTrue, Float ifFalse) { return mask ? ifTrue : ifFalse; }
+	static Mask CmpLt(Float a, Float b) { return a < b; }
+	static Mask CmpLe(Float a, Float b) { return a <= b; }
+	static Mask CmpGt(Float a, Float b) { return a > b; }
+	static Mask And(Mask a, Mask b) { return a && b; }
+	static Mask Or(Mask a, Mask b) { return a || b; }
+	static Mask AndNot(Mask a, Mask b) { return !a && b; }	// (not a) and b
+	static unsigned int MoveMask(Mask mask) { return mask ? 1 : 0; }
+};
+
+#ifdef SIMD_SSE
+struct SimdSSE
+{
+	typedef __m128 Float;
+	typedef __m128 Mask;
+	static const unsigned int Width = 4;
+	static Float Load(float const* ptr) { return _mm_load_ps(ptr); }
+	static void Store(float* ptr, Float value) { _mm_store_ps(ptr, value); }
+	static Float Set1(float value) { return _mm_set1_ps(value); }
+	static Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+	static Float Sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+	static Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+	static Float Div(Float a, Float b) { return _mm_div_ps(a, b); }
+	static Float Sqrt(Float a) { return _mm_sqrt_ps(a); }
+	static Float Min(Float a, Float b) { return _mm_min_ps(a, b); }
+	static Float Max(Float a, Float b) { return _mm_max_ps(a, b); }
+	static Float SelectIfNotZero(Float test, Float ifNotZero, Float ifZero)
+	{
+		Float mask = _mm_cmpneq_ps(test, _mm_setzero_ps());
+		return _mm_or_ps(_mm_and_ps(mask, ifNotZero), _mm_andnot_ps(mask, ifZero));
+	}
+	static Float Select(Mask mask, Float ifTrue, Float ifFalse) { return _mm_or_ps(_mm_and_ps(mask, ifTrue), _mm_andnot_ps(mask, ifFalse)); }
+	static Mask CmpLt(Float a, Float b) { return _mm_cmplt_ps(a, b); }
+	static Mask CmpLe(Float a, Float b) { return _mm_cmple_ps(a, b); }
+	static Mask CmpGt(Float a, Float b) { return _mm_cmpgt_ps(a, b); }
+	static Mask And(Mask a, Mask b) { return _mm_and_ps(a, b); }
+	static Mask Or(Mask a, Mask b) { return _mm_or_ps(a, b); }
+	static Mask AndNot(Mask a, Mask b) { return _mm_andnot_ps(a, b); }
+	static unsigned int MoveMask(Mask mask) { return (unsigned int) _mm_movemask_ps(mask); }
+};
+#endif // SIMD_SSE
+
+#ifdef SIMD_AVX
+struct SimdAVX
+{
+	typedef __m256 Float;
+	typedef __m256 Mask;
+	static const unsigned int Width = 8;
+	static Float Load(float const* ptr) { return _mm256_load_ps(ptr); }
+	static void Store(float* ptr, Float value) { _mm256_store_ps(ptr, value); }
+	static Float Set1(float value) { return _mm256_set1_ps(value); }
+	static Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+	static Float Sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+	static Float Mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+	static Float Div(Float a, Float b) { return _mm256_div_ps(a, b); }
+	static Float Sqrt(Float a) { return _mm256_sqrt_ps(a); }
+	static Float Min(Float a, Float b) { return _mm256_min_ps(a, b); }
+	static Float Max(Float a, Float b) { return _mm256_max_ps(a, b); }
+	static Float SelectIfNotZero(Float test, Float ifNotZero, Float ifZero) { return _mm256_blendv_ps(ifZero, ifNotZero, _mm256_cmp_ps(test, _mm256_setzero_ps(), _CMP_NEQ_UQ)); }
+	static Float Select(Mask mask, Float ifTrue, Float ifFalse) { return _mm256_blendv_ps(ifFalse, ifTrue, mask); }
+	static Mask CmpLt(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static Mask CmpLe(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+	static Mask CmpGt(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static Mask And(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+	static Mask Or(Mask a, Mask b) { return _mm256_or_ps(a, b); }
+	static Mask AndNot(Mask a, Mask b) { return _mm256_andnot_ps(a, b); }
+	static unsigned int MoveMask(Mask mask) { return (unsigned int) _mm256_movemask_ps(mask); }
+};
+#endif // SIMD_AVX
+
+#ifdef SIMD_NEON
+struct SimdNEON
+{
+	typedef float32x4_t Float;
+	typedef uint32x4_t Mask;
+	static const unsigned int Width = 4;
+	static Float Load(float const* ptr) { return vld1q_f32(ptr); }
+	static void Store(float* ptr, Float value) { vst1q_f32(ptr, value); }
+	static Float Set1(float value) { return vdupq_n_f32(value); }
+	static Float Add(Float a, Float b) { return vaddq_f32(a, b); }
+	static Float Sub(Float a, Float b) { return vsubq_f32(a, b); }
+	static Float Mul(Float a, Float b) { return vmulq_f32(a, b); }
+	static Float Div(Float a, Float b) { return vdivq_f32(a, b); }
+	static Float Sqrt(Float a) { return vsqrtq_f32(a); }
+	static Float Min(Float a, Float b) { return vbslq_f32(vcltq_f32(a, b), a, b); }	// Not vminq_f32, that propagates NaNs
+	static Float Max(Float a, Float b) { return vbslq_f32(vcgtq_f32(a, b), a, b); }
+	static Float SelectIfNotZero(Float test, Float ifNotZero, Float ifZero) { return vbslq_f32(vceqq_f32(test, vdupq_n_f32(0.0f)), ifZero, ifNotZero); }
+	static Float Select(Mask mask, Float ifTrue, Float ifFalse) { return vbslq_f32(mask, ifTrue, ifFalse); }
+	static Mask CmpLt(Float a, Float b) { return vcltq_f32(a, b); }
+	static Mask CmpLe(Float a, Float b) { return vcleq_f32(a, b); }
+	static Mask CmpGt(Float a, Float b) { return vcgtq_f32(a, b); }
+	static Mask And(Mask a, Mask b) { return vandq_u32(a, b); }
+	static Mask Or(Mask a, Mask b) { return vorrq_u32(a, b); }
+	static Mask AndNot(Mask a, Mask b) { return vbicq_u32(b, a); }
+	static unsigned int MoveMask(Mask mask)
+	{
+		uint32x4_t bits = vshrq_n_u32(mask, 31);
+		return vgetq_lane_u32(bits, 0) | (vgetq_lane_u32(bits, 1) << 1) | (vgetq_lane_u32(bits, 2) << 2) | (vgetq_lane_u32(bits, 3) << 3);
+	}
+};
+#endif // SIMD_NEON
+
+#ifdef SIMD_WASM
+struct SimdWasm
+{
+	typedef v128_t Float;
+	typedef v128_t Mask;
+	static const unsigned int Width = 4;
+	static Float Load(float const* ptr) { return wasm_v128_load(ptr); }
+	static void Store(float* ptr, Float value) { wasm_v128_store(ptr, value); }
+	static Float Set1(float value) { return wasm_f32x4_splat(value); }
+	static Float Add(Float a, Float b) { return wasm_f32x4_add(a, b); }
+	static Float Sub(Float a, Float b) { return wasm_f32x4_sub(a, b); }
+	static Float Mul(Float a, Float b) { return wasm_f32x4_mul(a, b); }
+	static Float Div(Float a, Float b) { return wasm_f32x4_div(a, b); }
+	static Float Sqrt(Float a) { return wasm_f32x4_sqrt(a); }
+	static Float Min(Float a, Float b) { return wasm_v128_bitselect(a, b, wasm_f32x4_lt(a, b)); }	// Not wasm_f32x4_min, that propagates NaNs
+	static Float Max(Float a, Float b) { return wasm_v128_bitselect(a, b, wasm_f32x4_gt(a, b)); }
+	static Float SelectIfNotZero(Float test, Float ifNotZero, Float ifZero) { return wasm_v128_bitselect(ifNotZero, ifZero, wasm_f32x4_ne(test, wasm_f32x4_splat(0.0f))); }
+	static Float Select(Mask mask, Float ifTrue, Float ifFalse) { return wasm_v128_bitselect(ifTrue, ifFalse, mask); }
+	static Mask CmpLt(Float a, Float b) { return wasm_f32x4_lt(a, b); }
+	static Mask CmpLe(Float a, Float b) { return wasm_f32x4_le(a, b); }
+	static Mask CmpGt(Float a, Float b) { return wasm_f32x4_gt(a, b); }
+	static Mask And(Mask a, Mask b) { return wasm_v128_and(a, b); }
+	static Mask Or(Mask a, Mask b) { return wasm_v128_or(a, b); }
+	static Mask AndNot(Mask a, Mask b) { return wasm_v128_andnot(b, a); }
+	static unsigned int MoveMask(Mask mask) { return (unsigned int) wasm_i32x4_bitmask(mask); }
+};
+#endif // SIMD_WASM
+
+#endif // _SIMD_TRAITS_H_
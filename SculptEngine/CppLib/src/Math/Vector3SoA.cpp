@@ -0,0 +1,63 @@
+﻿#include "Vector3SoA.h"
+
+void Vector3SoA::LoadFrom(std::vector<Vector3> const& aos)
+{
+	unsigned int nbElems = (unsigned int) aos.size();
+	Resize(nbElems);
+	float* x = _x.data();
+	float* y = _y.data();
+	float* z = _z.data();
+	for(unsigned int i = 0; i < nbElems; ++i)
+	{
+		Vector3 const& v = aos[i];
+		x[i] = v.x;
+		y[i] = v.y;
+		z[i] = v.z;
+	}
+}
+
+void Vector3SoA::Gather(std::vector<Vector3> const& aos, std::vector<unsigned int> const& indices)
+{
+	unsigned int nbElems = (unsigned int) indices.size();
+	Resize(nbElems);
+	float* x = _x.data();
+	float* y = _y.data();
+	float* z = _z.data();
+	for(unsigned int i = 0; i < nbElems; ++i)
+	{
+		Vector3 const& v = aos[indices[i]];
+		x[i] = v.x;
+		y[i] = v.y;
+		z[i] = v.z;
+	}
+}
+
+void Vector3SoA::StoreTo(std::vector<Vector3>& aos) const
+{
+	aos.resize(_size);
+	float const* x = _x.data();
+	float const* y = _y.data();
+	float const* z = _z.data();
+	for(unsigned int i = 0; i < _size; ++i)
+	{
+		Vector3& v = aos[i];
+		v.x = x[i];
+		v.y = y[i];
+		v.z = z[i];
+	}
+}
+
+void Vector3SoA::Scatter(std::vector<Vector3>& aos, std::vector<unsigned int> const& indices) const
+{
+	ASSERT(indices.size() == _size);
+	float const* x = _x.data();
+	float const* y = _y.data();
+	float const* z = _z.data();
+	for(unsigned int i = 0; i < _size; ++i)
+	{
+		Vector3& v = aos[indices[i]];
+		v.x = x[i];
+		v.y = y[i];
+		v.z = z[i];
+	}
+}
@@ -0,0 +1,63 @@
+﻿#ifndef _VECTOR3_SOA_H_
+#define _VECTOR3_SOA_H_
+
+#include <vector>
+#include "AlignedAllocator.h"
+#include "Vector.h"
+
+const unsigned int SIMD_BLOCK_SIZE = (unsigned int) (SIMD_ALIGNMENT / sizeof(float));	// Floats per aligned block (16), streams are padded to a multiple of it
+
+typedef std::vector<float, AlignedAllocator<float>> AlignedFloatVector;
+
+// Structure of arrays storage of Vector3 (x[], y[], z[]), each stream being aligned and padded on SIMD_BLOCK_SIZE,
+// so that kernels can process full aligned blocks without any tail handling
+class Vector3SoA
+{
+public:
+	Vector3SoA(): _size(0) {}
+
+	unsigned int Size() const { return _size; }
+	unsigned int PaddedSize() const { return (unsigned int) _x.size(); }
+	bool IsEmpty() const { return _size == 0; }
+
+	void Resize(unsigned int size)
+	{
+		_size = size;
+		unsigned int paddedSize = ((size + SIMD_BLOCK_SIZE - 1) / SIMD_BLOCK_SIZE) * SIMD_BLOCK_SIZE;
+		_x.resize(paddedSize, 0.0f);
+		_y.resize(paddedSize, 0.0f);
+		_z.resize(paddedSize, 0.0f);
+	}
+
+	void Clear()
+	{
+		_size = 0;
+		_x.clear();
+		_y.clear();
+		_z.clear();
+	}
+
+	Vector3 Get(unsigned int index) const { ASSERT(index < _size); return Vector3(_x[index], _y[index], _z[index]); }
+	void Set(unsigned int index, Vector3 const& value) { ASSERT(index < _size); _x[index] = value.x; _y[index] = value.y; _z[index] = value.z; }
+
+	float const* GetX() const { return _x.data(); }
+	float const* GetY() const { return _y.data(); }
+	float const* GetZ() const { return _z.data(); }
+	float* GrabX() { return _x.data(); }
+	float* GrabY() { return _y.data(); }
+	float* GrabZ() { return _z.data(); }
+
+	// AoS <-> SoA conversions
+	void LoadFrom(std::vector<Vector3> const& aos);	// Resize to aos size and copy everything
+	void Gather(std::vector<Vector3> const& aos, std::vector<unsigned int> const& indices);	// Resize to indices size, element i being aos[indices[i]]
+	void StoreTo(std::vector<Vector3>& aos) const;
+	void Scatter(std::vector<Vector3>& aos, std::vector<unsigned int> const& indices) const;	// Reverse operation of Gather
+
+private:
+	unsigned int _size;
+	AlignedFloatVector _x;
+	AlignedFloatVector _y;
+	AlignedFloatVector _z;
+};
+
+#endif // _VECTOR3_SOA_H_
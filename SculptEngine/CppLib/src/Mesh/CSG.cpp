@@ -1,7 +1,6 @@
 #include "CSG.h"
 #include "Mesh.h"
 #include "Collisions\TriangleToTriangle.h"
-#include "OctreeVisitorGetIntersection.h"
 #include "OctreeVisitorRetessellateInRange.h"
 
 bool Csg::DetectOctreeBBoxIntersection::HasToVisit(OctreeCell& cell)
@@ -103,13 +102,13 @@ bool Csg::ComputeCSGOperation(CSG_OPERATION operation, bool recenter)
 	std::vector<Vector3> const& verticesSecondMesh = _secondMesh.GetVertices();
 	for(auto collidePair : gatherCollidingCells.GetColliderToCollidingCells())
 	{
-		std::vector<unsigned int> const& cellFirstMeshTriIdx = collidePair.first->GetTrianglesIdx();
+		IndexList cellFirstMeshTriIdx = collidePair.first->GetTrianglesIdx();
 		for(unsigned int triIdxFirst : cellFirstMeshTriIdx)
 		{
 			BSphere const& triSphereFirst = _firstMesh.GetTrisBSphere()[triIdxFirst];
 			for(OctreeCell const* cell : collidePair.second)
 			{
-				std::vector<unsigned int> const& cellSecondMeshTriIdx = cell->GetTrianglesIdx();
+				IndexList cellSecondMeshTriIdx = cell->GetTrianglesIdx();
 				for(unsigned int triIdxSecond : cellSecondMeshTriIdx)
 				{
 					BSphere const& triSphereSecond = _secondMesh.GetTrisBSphere()[triIdxSecond];
@@ -380,12 +379,14 @@ void Csg::InvalidateInsideMeshPart(Mesh& mesh, Mesh& otherMesh, std::vector<unsi
 				if(edgeLength > EPSILON)
 				{
 					Ray ray(a, edge / edgeLength, edgeLength);
-					VisitorGetIntersection getIntersection(otherMesh, ray, false, true);
-					otherMesh.GrabOctreeRoot().Traverse(getIntersection);
-					if(getIntersection.GetIntersectionDists().size() == 1)	// 0: no col, >1: the ray traversed the mesh
+					std::vector<float> intersectionDists;
+					std::vector<unsigned int> intersectionTris;
+					otherMesh.GetAllIntersections(ray, false, true, intersectionDists, intersectionTris);
+					if(intersectionDists.size() == 1)	// 0: no col, >1: the ray traversed the mesh
 					{
+						Vector3 const& intersectionNormal = otherMesh.GetTrisNormal()[intersectionTris[0]];
 						unsigned int vtxIdxInside;
-						if(edge.Dot(getIntersection.GetIntersectionNormal(0)) > 0.0f)
+						if(edge.Dot(intersectionNormal) > 0.0f)
 							vtxIdxInside = vtxIdxA;	// a is inside the other mesh 
 						else
 							vtxIdxInside = vtxIdxB;	// b is inside the other mesh 
@@ -398,14 +399,15 @@ void Csg::InvalidateInsideMeshPart(Mesh& mesh, Mesh& otherMesh, std::vector<unsi
 								Vector3 edgeCheck = a - b;
 								float edgeCheckLength = edgeCheck.Length();
 								Ray rayCheck(b, edgeCheck / edgeCheckLength, edgeCheckLength);
-								VisitorGetIntersection getIntersectionCheck(otherMesh, rayCheck, false, true);
-								otherMesh.GrabOctreeRoot().Traverse(getIntersectionCheck);
-								if(getIntersectionCheck.GetIntersectionDists().size() != 1)
+								std::vector<float> intersectionCheckDists;
+								std::vector<unsigned int> intersectionCheckTris;
+								otherMesh.GetAllIntersections(rayCheck, false, true, intersectionCheckDists, intersectionCheckTris);
+								if(intersectionCheckDists.size() != 1)
 								{	// Check failed
 									ASSERT(false);
 									return false;
 								}
-								if(getIntersection.GetIntersectionNormal(0) != getIntersectionCheck.GetIntersectionNormal(0))
+								if(intersectionNormal != otherMesh.GetTrisNormal()[intersectionCheckTris[0]])
 								{	// Check failed
 									ASSERT(false);
 									return false;
@@ -418,7 +420,7 @@ void Csg::InvalidateInsideMeshPart(Mesh& mesh, Mesh& otherMesh, std::vector<unsi
 						{
 							unsigned int vtxIdxToInvalidate = verticesToInvalidate.back();
 							verticesToInvalidate.pop_back();
-							std::vector<unsigned int> const& trisToInvalidate = mesh.GetTrianglesAroundVertex(vtxIdxToInvalidate);
+							TriangleFan trisToInvalidate = mesh.GetTrianglesAroundVertex(vtxIdxToInvalidate);
 							for(unsigned int triIdxToInvalidate : trisToInvalidate)
 							{
 								if(!mesh.IsTriangleToBeRemoved(triIdxToInvalidate))
@@ -1178,20 +1180,7 @@ void Csg::RebuildMeshFromCsg(bool recenter)
 			{
 				if(vtxsIdx[i] != vtxIdx)
 				{	// Test that an edge is only shared by two triangles
-					std::vector<unsigned int> const& triAroundA = _resultMesh.GetTrianglesAroundVertex(vtxIdx);
-					std::vector<unsigned int> const& triAroundB = _resultMesh.GetTrianglesAroundVertex(vtxsIdx[i]);
-					unsigned int nbSharedTriangles = 0;
-					for(unsigned int triIdxA : triAroundA)		// Todo : O(n), of course optimize this
-					{
-						for(unsigned int triIdxB : triAroundB)
-						{
-							if(triIdxA == triIdxB)
-							{	// triangle common to vertex A and B
-								++nbSharedTriangles;
-								break;
-							}
-						}
-					}
+					unsigned int nbSharedTriangles = _resultMesh.CountTrianglesAroundEdge(triIdx, vtxIdx, vtxsIdx[i], false);
 					if(nbSharedTriangles != 2)	//  Should be always the case on a manifold closed mesh
 						return false;
 				}
@@ -1256,7 +1245,7 @@ void Csg::RebuildMeshFromCsg(bool recenter)
 		Vector3Double projPointOnSegment = (AToBDir * dot) + A;
 		return (Other - projPointOnSegment).Length();
 	};
-	auto TestTriangles = [&](std::vector<unsigned int> const& triangles, unsigned int vtxToTreatIdx)	// Will update bestVertexResult and bestEdgeResult
+	auto TestTriangles = [&](IndexList triangles, unsigned int vtxToTreatIdx)	// Will update bestVertexResult and bestEdgeResult
 	{
 		for(unsigned int i = 0; (bestVertexResult.distance != 0.0f) && (bestEdgeResult.distance != 0.0f) && (i < triangles.size()); ++i)
 		{
@@ -0,0 +1,50 @@
+﻿#include "IndexListsPool.h"
+#include <string.h>
+
+void IndexListsPool::Append(unsigned int listIdx, unsigned int const* indices, unsigned int nbIndices)
+{
+	if(nbIndices == 0)
+		return;
+	unsigned int newCount = _lists[listIdx]._count + nbIndices;
+	if(newCount > _lists[listIdx]._capacity)
+	{	// Relocate the list at the end of the buffer, with some slack for the next edits
+		unsigned int newCapacity = newCount + (newCount / 4) + 4;
+		unsigned int newOffset = (unsigned int) _data.size();
+		_data.resize(_data.size() + newCapacity);
+		ListEntry& list = _lists[listIdx];
+		if(list._count != 0)
+			memcpy(_data.data() + newOffset, _data.data() + list._offset, list._count * sizeof(unsigned int));
+		_reservedSlots += newCapacity - list._capacity;
+		list._offset = newOffset;
+		list._capacity = newCapacity;
+	}
+	ListEntry& list = _lists[listIdx];
+	memcpy(_data.data() + list._offset + list._count, indices, nbIndices * sizeof(unsigned int));
+	list._count = newCount;
+}
+
+void IndexListsPool::Release(unsigned int listIdx)
+{
+	ListEntry& list = _lists[listIdx];
+	_reservedSlots -= list._capacity;
+	list = ListEntry();
+}
+
+void IndexListsPool::Compact()
+{
+	size_t nbSlots = 0;
+	for(ListEntry const& list : _lists)
+		nbSlots += list._count;
+	std::vector<unsigned int> data(nbSlots);
+	unsigned int offset = 0;
+	for(ListEntry& list : _lists)
+	{
+		if(list._count != 0)
+			memcpy(data.data() + offset, _data.data() + list._offset, list._count * sizeof(unsigned int));
+		list._offset = offset;
+		list._capacity = list._count;
+		offset += list._count;
+	}
+	_data.swap(data);
+	_reservedSlots = nbSlots;
+}
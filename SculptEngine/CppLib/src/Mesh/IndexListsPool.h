@@ -0,0 +1,71 @@
+﻿#ifndef _INDEX_LISTS_POOL_H_
+#define _INDEX_LISTS_POOL_H_
+
+#include <vector>
+#include "SculptEngine.h"
+
+// Read only view on a list of indices, with a std::vector like read interface. It doesn't follow the list if it is relocated: get it again once the list content changed
+class IndexList
+{
+public:
+	IndexList(unsigned int const* data, unsigned int count) : _data(data), _count(count) {}
+	IndexList(std::vector<unsigned int> const& indices) : _data(indices.data()), _count((unsigned int) indices.size()) {}
+
+	unsigned int size() const { return _count; }
+	bool empty() const { return _count == 0; }
+	unsigned int operator[](unsigned int index) const { ASSERT(index < _count); return _data[index]; }
+	unsigned int const* begin() const { return _data; }
+	unsigned int const* end() const { return _data + _count; }
+
+private:
+	unsigned int const* _data;
+	unsigned int _count;
+};
+
+// Many small index lists sharing one buffer, instead of one heap block per list.
+// A list that outgrows its capacity is relocated at the end of the buffer (its old slots are lost until next compaction).
+// Lists can be shrunk concurrently (each one only touches its own slots), growing them has to be done by one thread at a time.
+class IndexListsPool
+{
+public:
+	IndexListsPool() : _reservedSlots(0) {}
+
+	unsigned int AddList() { _lists.push_back(ListEntry()); return (unsigned int) _lists.size() - 1; }
+	unsigned int GetListsCount() const { return (unsigned int) _lists.size(); }
+
+	IndexList GetList(unsigned int listIdx) const { ListEntry const& list = _lists[listIdx]; return IndexList(_data.data() + list._offset, list._count); }
+	unsigned int GetCount(unsigned int listIdx) const { return _lists[listIdx]._count; }
+	unsigned int* GrabData(unsigned int listIdx) { return _data.data() + _lists[listIdx]._offset; }
+
+	void Append(unsigned int listIdx, std::vector<unsigned int> const& indices) { Append(listIdx, indices.data(), (unsigned int) indices.size()); }
+	void Append(unsigned int listIdx, unsigned int const* indices, unsigned int nbIndices);
+	void RemoveAt(unsigned int listIdx, unsigned int position)	// Last element takes the place of the removed one
+	{
+		ListEntry& list = _lists[listIdx];
+		ASSERT(position < list._count);
+		unsigned int* data = _data.data() + list._offset;
+		data[position] = data[--list._count];
+	}
+	void Shrink(unsigned int listIdx, unsigned int newCount) { ASSERT(newCount <= _lists[listIdx]._count); _lists[listIdx]._count = newCount; }
+	void Release(unsigned int listIdx);	// Empty the list and give its slots back
+
+	// Memory related
+	bool HasToCompact() const { return _reservedSlots < _data.size() / 2; }	// More than half of the slots are lost
+	void Compact();
+	size_t GetMemoryUsage() const { return _lists.capacity() * sizeof(ListEntry) + _data.capacity() * sizeof(unsigned int); }
+
+private:
+	struct ListEntry
+	{
+		ListEntry() : _offset(0), _count(0), _capacity(0) {}
+		unsigned int _offset;
+		unsigned int _count;
+		unsigned int _capacity;
+	};
+
+	std::vector<ListEntry> _lists;
+	std::vector<unsigned int> _data;
+	size_t _reservedSlots;	// Slots owned by lists (the remaining being lost)
+};
+
+#endif // _INDEX_LISTS_POOL_H_
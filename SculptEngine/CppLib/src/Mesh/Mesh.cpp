@@ -1,14 +1,20 @@
 ﻿#include "Mesh.h"
+#include "NormalKernels.h"
+#include "RayKernels.h"
 #include "SubMesh.h"
 #include <float.h>
 #include <time.h>
+#include <chrono>
 #include <map>
 #include "OctreeVisitorGetIntersection.h"
+#include "OctreeVisitorGetClosestIntersection.h"
+#include "OctreeVisitorGetPacketClosestIntersections.h"
 #include "OctreeVisitorRecomputeBBox.h"
 #include "OctreeVisitorExtractOutOfCellsBoundGeom.h"
 #include "OctreeVisitorPurgeEmptyCell.h"
 #include "OctreeVisitorHandlePendingRemovals.h"
 #include "OctreeVisitorRetessellateInRange.h"
+#include "OctreeVisitorGetAverageInRange.h"
 #include "Loop.h"
 #include "..\SculptEngine.h"
 
@@ -30,8 +36,14 @@ void VisitorGetOctreeVertexIntersection::VisitEnter(OctreeCell& cell)
 //#define DEBUG_ALWAYS_REBUILD_ALL_NORMALS
 const float MINIMUM_MESH_SIDE_LENGTH = 100.0f;	// Ten centimeter
 const unsigned int MAXIMUM_UNDO_COUNT = 10; // Limit the maximum snapshot stored, to avoid using too much memory
-
-Mesh::Mesh(std::vector<unsigned int>& triangles, std::vector<Vector3>& vertices, int id, bool freeInputBuffers, bool rescale, bool recenter, bool buildHardEdges, bool weldVertices) : _id(id), _subMeshesVisitor(nullptr), _snapshotNextPos(0), _IsOpen(false), _IsManifold(true), _retessellator(nullptr)
+const float DEFAULT_REORDER_THRESHOLD = 0.25f;	// Reorder once a quarter of the vertices and triangles got out of their cell range
+const float DEFAULT_OCTREE_LOOSENESS = 1.0f;	// Strict octree
+const unsigned int DEFAULT_OCTREE_LEAF_CAPACITY = 1000;
+const unsigned int AUTO_TUNE_RAYS_COUNT = 4096;
+const unsigned int AUTO_TUNE_RANGES_COUNT = 1024;
+const float AUTO_TUNE_RANGE_RADIUS_RATIO = 0.02f;	// Of the mesh bbox diagonal, about a brush size
+
+Mesh::Mesh(std::vector<unsigned int>& triangles, std::vector<Vector3>& vertices, int id, bool freeInputBuffers, bool rescale, bool recenter, bool buildHardEdges, bool weldVertices) : _octreeLooseness(DEFAULT_OCTREE_LOOSENESS), _octreeLeafCapacity(DEFAULT_OCTREE_LEAF_CAPACITY), _nbOctreeExtractedTris(0), _nbOctreeExtractedVtxs(0), _subMeshesVisitor(nullptr), _nbScatteredElements(0), _reorderThreshold(DEFAULT_REORDER_THRESHOLD), _id(id), _snapshotNextPos(0), _IsOpen(false), _IsManifold(true), _retessellator(nullptr)
 {
 	if(SculptEngine::HasExpired())
 		return;
@@ -79,6 +91,9 @@ Mesh::Mesh(Mesh const& otherMesh, bool copySnapshots, bool copyOctree):
 	_trisNewIdx(otherMesh._trisNewIdx),
 	_trisNormal(otherMesh._trisNormal),
 	_trisBSphere(otherMesh._trisBSphere),
+	_trisTwin(otherMesh._trisTwin),
+	_trisIdxToUpdateTwin(otherMesh._trisIdxToUpdateTwin),
+	_trisOctreeCell(otherMesh._trisOctreeCell.size(), UNDEFINED_CELL_IDX),
 	_vtxsIdxToRecomputeNormalOn(otherMesh._vtxsIdxToRecomputeNormalOn),
 	_trisIdxToRecomputeNormalOn(otherMesh._trisIdxToRecomputeNormalOn),
 #ifndef CLEAN_PENDING_REMOVALS_IMMEDIATELY
@@ -87,6 +102,13 @@ Mesh::Mesh(Mesh const& otherMesh, bool copySnapshots, bool copyOctree):
 	_vtxsIdxToRecycle(otherMesh._vtxsIdxToRecycle),
 	_trisIdxToRecycle(otherMesh._trisIdxToRecycle),
 #endif // !CLEAN_PENDING_REMOVALS_IMMEDIATELY
+	_octreeLooseness(otherMesh._octreeLooseness),
+	_octreeLeafCapacity(otherMesh._octreeLeafCapacity),
+	_nbOctreeExtractedTris(otherMesh._nbOctreeExtractedTris),
+	_nbOctreeExtractedVtxs(otherMesh._nbOctreeExtractedVtxs),
+	_vtxsIdxToUpdateInSubMesh(otherMesh._vtxsIdxToUpdateInSubMesh),
+	_nbScatteredElements(otherMesh._nbScatteredElements),
+	_reorderThreshold(otherMesh._reorderThreshold),
 	_id(otherMesh._id),
 	_IsOpen(otherMesh._IsOpen),
 	_IsManifold(otherMesh._IsManifold),
@@ -101,7 +123,14 @@ Mesh::Mesh(Mesh const& otherMesh, bool copySnapshots, bool copyOctree):
 	}
 	// Octree cloning
 	if(copyOctree)
-		_octreeRoot.reset(new OctreeCell(*otherMesh._octreeRoot, nullptr));
+	{
+		_octree.reset(new Octree(*otherMesh._octree));
+		_trisOctreeCell = otherMesh._trisOctreeCell;	// Cells are referenced by index, still valid in the copy
+		if(otherMesh._bvh != nullptr)
+			_bvh.reset(new TrianglesBVH(*otherMesh._bvh));
+	}
+	else if(otherMesh._bvh != nullptr)
+		_bvh.reset(new TrianglesBVH());	// Will be built along with the octree
 	// Submeshes
 	if(otherMesh._subMeshesVisitor != nullptr)
 		_subMeshesVisitor.reset(new VisitorBuildAndCollectSubMeshes(*this, *otherMesh._subMeshesVisitor));
@@ -109,16 +138,18 @@ Mesh::Mesh(Mesh const& otherMesh, bool copySnapshots, bool copyOctree):
 
 void Mesh::RebuildMeshData(bool rescale, bool recenter, bool buildHardEdges)
 {
+	if(_subMeshesVisitor != nullptr)
+		_subMeshesVisitor->SetHasToRebuildAll();	// Sub meshes refer to the previous data
 	// Build for each vertex the list of the surrounding triangles
-	_vtxToTriAround.clear();
-	_vtxToTriAround.resize(_vertices.size());
+#ifdef PROFILE_INFO
+	clock_t begin = clock();
+#endif // PROFILE_INFO
+	_vtxToTriAround.Build(_triangles, (unsigned int) _vertices.size());
 	unsigned int triCount = (unsigned int) _triangles.size() / 3;
-	for(unsigned int triIdx = 0; triIdx < triCount; ++triIdx)
-	{
-		unsigned int const* vtxsIdx = &(_triangles[triIdx * 3]);
-		for(int i = 0; i < 3; ++i)
-			AddTriangleAroundVertex(vtxsIdx[i], triIdx);
-	}
+#ifdef PROFILE_INFO
+	clock_t end = clock();
+	printf("Triangles around vertices built in %f (%d KB)\n", double(end - begin) / CLOCKS_PER_SEC, (int) (_vtxToTriAround.GetMemoryUsage() / 1024));
+#endif // PROFILE_INFO
 	// Create vertices state flag array
 	_vtxsState.clear();
 	_vtxsState.resize(_vertices.size());
@@ -148,11 +179,18 @@ void Mesh::RebuildMeshData(bool rescale, bool recenter, bool buildHardEdges)
 	// Create triangles bsphere array
 	_trisBSphere.clear();
 	_trisBSphere.resize(_trisState.size());
+	// Create triangles twin array
+	BuildTrisTwin();
+	// Create triangles octree cell array (filled when building the octree)
+	_trisOctreeCell.clear();
+	_trisOctreeCell.resize(_trisState.size(), UNDEFINED_CELL_IDX);
 	// Reserve our reduced compute normals buffer
 	_vtxsIdxToRecomputeNormalOn.clear();
 	_vtxsIdxToRecomputeNormalOn.reserve(_vtxsNormal.size());
 	_trisIdxToRecomputeNormalOn.clear();
 	_trisIdxToRecomputeNormalOn.reserve(_trisNormal.size());
+	// Vertex flags were reset
+	_vtxsIdxToUpdateInSubMesh.clear();
 #ifndef CLEAN_PENDING_REMOVALS_IMMEDIATELY
 	// Reserve our pending Remove buffer
 	_vtxsIdxToRemove.clear();
@@ -207,7 +245,10 @@ void Mesh::RebuildMeshData(bool rescale, bool recenter, bool buildHardEdges)
 	}
 	// Build octree
 	if(bbox.IsValid())
+	{
 		BuildOctree(bbox);
+		ReorderPerCell();
+	}
 	printf("triangle count %d, vertex count %d\n", (int) _triangles.size() / 3, (int) _vertices.size());
 }
 
@@ -219,44 +260,229 @@ bool Mesh::GetClosestIntersectionPoint(Ray const& ray, Vector3& point, Vector3*
 
 bool Mesh::GetClosestIntersectionPointAndTriangle(Ray const& ray, Vector3& point, unsigned int* triangle, Vector3* normal, bool cullBackFace)
 {
-	if(_octreeRoot == nullptr)
+	if(_octree == nullptr)
 		return false;
 	// Get triangle we intersect with
 	DEBUG_intersectionPoints.clear();
 
-	VisitorGetIntersection getIntersection(*this, ray, cullBackFace, false);
-	GrabOctreeRoot().Traverse(getIntersection);
-	std::vector<float> const& intersectionDists = getIntersection.GetIntersectionDists();
-	std::vector<unsigned int> const& intersectionTriangles = getIntersection.GetIntersectionTriangles();
-	ASSERT(intersectionDists.size() == intersectionTriangles.size());
+	unsigned int closestTriangle;
+	float closestDist;
+	if(GetClosestIntersection(ray, cullBackFace, closestTriangle, closestDist))
+	{
+		if(triangle != nullptr)
+			*triangle = closestTriangle;
+		if(normal != nullptr)
+			*normal = _trisNormal[closestTriangle];
+		point = ray.GetOrigin() + ray.GetDirection() * closestDist;
+		return true;
+	}
+
+	point.ResetToZero();
+	return false;
+}
 
-	// Get Closest intersection
-	if(intersectionDists.size() > 0)
+bool Mesh::GetClosestIntersection(Ray const& ray, bool cullBackFace, unsigned int& closestTriangle, float& closestDist)
+{
+	if(_bvh != nullptr)
 	{
-		float closestDist = FLT_MAX;
-		for(size_t i = 0; i < intersectionDists.size(); ++i)
+		if(_bvh->HasToUpdate())
+			_bvh->Update(*this);
+		return _bvh->GetClosestIntersection(*this, ray, cullBackFace, closestTriangle, closestDist);
+	}
+	VisitorGetClosestIntersection getClosestIntersection(*this, ray, cullBackFace);
+	GrabOctreeRoot().TraverseFrontToBack(getClosestIntersection);
+	closestTriangle = getClosestIntersection.GetClosestTriangle();
+	closestDist = getClosestIntersection.GetClosestDist();
+	return getClosestIntersection.HasIntersection();
+}
+
+void Mesh::IntersectRays(Ray const* rays, unsigned int nbRays, RayHit* hits, bool cullBackFace)
+{
+	if(_octree == nullptr)
+	{
+		for(unsigned int rayIdx = 0; rayIdx < nbRays; ++rayIdx)
+		{
+			hits[rayIdx].hasHit = false;
+			hits[rayIdx].point.ResetToZero();
+		}
+		return;
+	}
+	if((_bvh != nullptr) && _bvh->HasToUpdate())
+		_bvh->Update(*this);
+	unsigned int packetTrisIdx[RAY_PACKET_SIZE];
+	float packetDistances[RAY_PACKET_SIZE];
+	for(unsigned int packetStart = 0; packetStart < nbRays; packetStart += RAY_PACKET_SIZE)
+	{
+		Ray const* packetRays = rays + packetStart;
+		unsigned int packetSize = min(RAY_PACKET_SIZE, nbRays - packetStart);
+		if(_bvh != nullptr)
+			_bvh->GetPacketClosestIntersections(*this, packetRays, packetSize, cullBackFace, packetTrisIdx, packetDistances);
+		else
 		{
-			if(closestDist > intersectionDists[i])
+			VisitorGetPacketClosestIntersections getClosestIntersections(*this, packetRays, packetSize, cullBackFace);
+			GrabOctreeRoot().TraverseFrontToBack(getClosestIntersections);
+			for(unsigned int i = 0; i < packetSize; ++i)
 			{
-				closestDist = intersectionDists[i];
-				if(triangle != nullptr)
-					*triangle = intersectionTriangles[i];
-				if(normal != nullptr)
-					*normal = _trisNormal[intersectionTriangles[i]];
+				packetTrisIdx[i] = getClosestIntersections.GetClosestTriangle(i);
+				packetDistances[i] = getClosestIntersections.GetClosestDist(i);
 			}
 		}
-		point = ray.GetOrigin() + ray.GetDirection() * closestDist;
-		return true;
+		for(unsigned int i = 0; i < packetSize; ++i)
+		{
+			RayHit& hit = hits[packetStart + i];
+			hit.hasHit = packetTrisIdx[i] != UNDEFINED_NEW_ID;
+			hit.triangle = packetTrisIdx[i];
+			hit.distance = packetDistances[i];
+			if(hit.hasHit)
+			{
+				hit.normal = _trisNormal[hit.triangle];
+				hit.point = packetRays[i].GetOrigin() + packetRays[i].GetDirection() * hit.distance;
+			}
+			else
+				hit.point.ResetToZero();
+		}
 	}
+}
 
-	point.ResetToZero();
-	return false;
+void Mesh::IntersectRays(std::vector<Ray> const& rays, std::vector<RayHit>& hits, bool cullBackFace)
+{
+	hits.resize(rays.size());
+	if(!rays.empty())
+		IntersectRays(rays.data(), (unsigned int) rays.size(), hits.data(), cullBackFace);
+}
+
+void Mesh::GetAllIntersections(Ray const& ray, bool cullBackFace, bool intersectTriToRemove, std::vector<float>& intersectionDists, std::vector<unsigned int>& intersectionTriangles)
+{
+	if(_octree == nullptr)
+		return;
+	if(_bvh != nullptr)
+	{
+		if(_bvh->HasToUpdate())
+			_bvh->Update(*this);
+		_bvh->GetIntersections(*this, ray, cullBackFace, intersectTriToRemove, intersectionDists, intersectionTriangles);
+	}
+	else
+	{
+		ScratchArena::Scope scratchScope(_scratchArena);
+		VisitorGetIntersection getIntersection(*this, ray, cullBackFace, intersectTriToRemove);
+		GrabOctreeRoot().Traverse(getIntersection);
+		intersectionDists.insert(intersectionDists.end(), getIntersection.GetIntersectionDists().begin(), getIntersection.GetIntersectionDists().end());
+		intersectionTriangles.insert(intersectionTriangles.end(), getIntersection.GetIntersectionTriangles().begin(), getIntersection.GetIntersectionTriangles().end());
+	}
+}
+
+void Mesh::SetUseBVH(bool useBVH)
+{
+	if(useBVH == IsUsingBVH())
+		return;
+	if(useBVH)
+	{
+		_bvh.reset(new TrianglesBVH());
+		if(_octree != nullptr)
+			_bvh->Build(*this);
+	}
+	else
+		_bvh.reset();
+}
+
+void Mesh::SetOctreeLooseness(float looseness)
+{
+	ASSERT(looseness >= 1.0f);
+	if(looseness == _octreeLooseness)
+		return;
+	_octreeLooseness = looseness;
+	if(_octree != nullptr)
+	{
+		_octree->SetLooseness(looseness);
+		ReBalanceOctree(std::vector<unsigned int>(), std::vector<unsigned int>(), true);	// Place again what doesn't fit the new bounds
+	}
+}
+
+void Mesh::SetOctreeLeafCapacity(unsigned int maxTrianglesPerLeaf)
+{
+	ASSERT(maxTrianglesPerLeaf > 0);
+	if(maxTrianglesPerLeaf == _octreeLeafCapacity)
+		return;
+	_octreeLeafCapacity = maxTrianglesPerLeaf;
+	if(_octree != nullptr)
+	{
+		BuildOctree(GetBBox());
+		ReorderPerCell();
+	}
+}
+
+unsigned int Mesh::AutoTuneOctreeLeafCapacity()
+{
+	if(_octree == nullptr)
+		return _octreeLeafCapacity;
+	// Queries standing for the sculpting ones: rays toward the mesh (picking) and small spheres around vertices (brushes), the same for each capacity
+	BBox const bbox = GetBBox();
+	Vector3 const center = bbox.Center();
+	float const radius = bbox.Size().Length() * 0.5f;
+	unsigned int seed = 1;
+	auto Random = [&seed]() { seed = seed * 1664525u + 1013904223u; return float(seed >> 8) / float(1 << 24); };	// Own generator, not to disturb rand() users
+	std::vector<Ray> rays(AUTO_TUNE_RAYS_COUNT);
+	for(Ray& ray : rays)
+	{
+		Vector3 origin = center + Vector3(Random() - 0.5f, Random() - 0.5f, Random() - 0.5f).Normalized() * (radius * 2.0f);
+		Vector3 target = bbox.Min() + Vector3(Random() * bbox.Size().x, Random() * bbox.Size().y, Random() * bbox.Size().z);
+		ray = Ray(origin, (target - origin).Normalized(), radius * 4.0f);
+	}
+	std::vector<unsigned int> rangeCenters;
+	rangeCenters.reserve(AUTO_TUNE_RANGES_COUNT);
+	while((rangeCenters.size() < AUTO_TUNE_RANGES_COUNT) && !_vertices.empty())
+	{
+		unsigned int vtxIdx = min((unsigned int) (Random() * _vertices.size()), (unsigned int) _vertices.size() - 1);
+		if(!IsVertexToBeRemoved(vtxIdx))
+			rangeCenters.push_back(vtxIdx);
+	}
+	float const rangeRadius = radius * 2.0f * AUTO_TUNE_RANGE_RADIUS_RATIO;
+	// Time each capacity (leaves are never split into several sub meshes, so don't go over what a sub mesh can hold)
+	std::unique_ptr<TrianglesBVH> bvh(std::move(_bvh));	// Rays have to go through the octree, and the BVH doesn't need to be built again each time
+	unsigned int const capacities[] = { 125, 250, 500, 1000, 2000, 4000 };
+	unsigned int subMeshesMaxVertices = GetSubMeshesMaxVertices();
+	unsigned int bestCapacity = _octreeLeafCapacity;
+	double bestTime = DBL_MAX;
+	for(unsigned int capacity : capacities)
+	{
+		if((subMeshesMaxVertices != 0) && (capacity * 3 > subMeshesMaxVertices))
+			break;
+		_octreeLeafCapacity = capacity;
+		BuildOctree(bbox);
+		auto begin = std::chrono::steady_clock::now();
+		for(Ray const& ray : rays)
+		{
+			unsigned int closestTriangle;
+			float closestDist;
+			GetClosestIntersection(ray, true, closestTriangle, closestDist);
+		}
+		for(unsigned int vtxIdx : rangeCenters)
+		{
+			VisitorGetAverageInRange getAverageInRange(*this, _vertices[vtxIdx], rangeRadius);
+			GrabOctreeRoot().Traverse(getAverageInRange);
+		}
+		double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+#ifdef PROFILE_INFO
+		printf("Octree leaf capacity %d: queries in %f\n", capacity, time);
+#endif // PROFILE_INFO
+		if(time < bestTime)
+		{
+			bestTime = time;
+			bestCapacity = capacity;
+		}
+	}
+	_bvh = std::move(bvh);
+	// Keep the best one
+	_octreeLeafCapacity = bestCapacity;
+	BuildOctree(bbox);
+	ReorderPerCell();
+	return bestCapacity;
 }
 
 BBox const& Mesh::GetBBox() const
 {
-	if(_octreeRoot != nullptr)
-		return _octreeRoot->GetContentBBox();
+	if(_octree != nullptr)
+		return _octree->GetRoot().GetContentBBox();
 	else
 	{
 		static BBox emptyBBox(Vector3(-0.5f, -0.5f, -0.5f), Vector3(0.5f, 0.5f, 0.5f));
@@ -264,34 +490,90 @@ BBox const& Mesh::GetBBox() const
 	}
 }
 
+void Mesh::UpdateSubMeshes()
+{
+	GrabSubMeshesVisitor().SelectSubMeshesCells(GrabOctreeRoot());
+	// Flag the cells holding the triangles around modified vertices, so the sub meshes visitor doesn't have to scan clean cells
+	for(unsigned int vtxIdx : _vtxsIdxToUpdateInSubMesh)
+	{
+		for(unsigned int triIdx : _vtxToTriAround[vtxIdx])
+		{
+			unsigned int cellIdx = _trisOctreeCell[triIdx];
+			if((cellIdx != UNDEFINED_CELL_IDX) && !IsTriangleToBeRemoved(triIdx))
+				_octree->GrabCell(cellIdx).AddStateFlags(CELL_STATE_HASTO_PATCH_SUB_MESH);
+		}
+	}
+	GrabOctreeRoot().ParallelTraverse(GrabSubMeshesVisitor());
+}
+
+void Mesh::SetSubMeshesShareBuffers(bool shareBuffers)
+{
+	if(shareBuffers == AreSubMeshesSharingBuffers())
+		return;
+	GrabSubMeshesVisitor().SetShareFullMeshBuffers(shareBuffers);
+	if(shareBuffers)
+		ReorderPerCell();	// Make sub meshes windows as small as possible
+}
+
 void Mesh::RecomputeFragmentsBBox(bool forceAllCellRecomputing)
 {
 	VisitorRecomputeBBox recomputeBbox(*this, forceAllCellRecomputing);
-	GrabOctreeRoot().Traverse(recomputeBbox);
+	GrabOctreeRoot().ParallelTraverse(recomputeBbox);
+}
+
+void Mesh::ShrinkFragmentsBBox()
+{
+	if(_octree == nullptr)
+		return;
+	VisitorRecomputeBBox shrinkBbox(*this, false, true);
+	GrabOctreeRoot().ParallelTraverse(shrinkBbox);
+}
+
+void Mesh::GrowCellsContentBBox(std::vector<unsigned int> const& vtxsIdx)
+{
+	if(_octree == nullptr)
+		return;
+	for(unsigned int vtxIdx : vtxsIdx)
+	{
+		if(IsVertexToBeRemoved(vtxIdx))
+			continue;
+		Vector3 const& vertex = _vertices[vtxIdx];
+		for(unsigned int triIdx : _vtxToTriAround[vtxIdx])
+		{
+			unsigned int cellIdx = _trisOctreeCell[triIdx];
+			if((cellIdx != UNDEFINED_CELL_IDX) && !IsTriangleToBeRemoved(triIdx))
+				_octree->GrabCell(cellIdx).GrowContentBBox(vertex);
+		}
+	}
 }
 
 void Mesh::ReBalanceOctree(std::vector<unsigned int> const& additionalTrisToInsert, std::vector<unsigned int> const& additionalVtxsToInsert, bool extractFromAllCells)
 {
-	if(_octreeRoot == nullptr)
+	if(_octree == nullptr)
 		return;
 	// Extract out of cells bound triangles and vertices
 	VisitorExtractOutOfCellsBoundGeom extractOutOfBounds(*this, extractFromAllCells);
-	GrabOctreeRoot().Traverse(extractOutOfBounds);
+	GrabOctreeRoot().ParallelTraverse(extractOutOfBounds);
+	_nbOctreeExtractedTris += (unsigned int) extractOutOfBounds.GetExtractedTris().size();
+	_nbOctreeExtractedVtxs += (unsigned int) extractOutOfBounds.GetExtractedVtxs().size();
 	// Insert them back into the octree
 	if((additionalTrisToInsert.size() > 0) || (additionalVtxsToInsert.size() > 0))
 	{
-		std::vector<unsigned int> allTriToInsert;
+		ScratchArena::Scope scratchScope(_scratchArena);
+		std::vector<unsigned int>& allTriToInsert = _scratchArena.GrabIndexBuffer();
 		allTriToInsert.reserve(extractOutOfBounds.GetExtractedTris().size() + additionalTrisToInsert.size());
 		allTriToInsert.insert(allTriToInsert.end(), extractOutOfBounds.GetExtractedTris().begin(), extractOutOfBounds.GetExtractedTris().end());
 		allTriToInsert.insert(allTriToInsert.end(), additionalTrisToInsert.begin(), additionalTrisToInsert.end());
-		std::vector<unsigned int> allVtxsToInsert;
+		std::vector<unsigned int>& allVtxsToInsert = _scratchArena.GrabIndexBuffer();
 		allVtxsToInsert.reserve(extractOutOfBounds.GetExtractedVtxs().size() + additionalVtxsToInsert.size());
 		allVtxsToInsert.insert(allVtxsToInsert.end(), extractOutOfBounds.GetExtractedVtxs().begin(), extractOutOfBounds.GetExtractedVtxs().end());
 		allVtxsToInsert.insert(allVtxsToInsert.end(), additionalVtxsToInsert.begin(), additionalVtxsToInsert.end());
-		GrabOctreeRoot().Insert(*this, allTriToInsert, allVtxsToInsert);
+		_octree->Insert(*this, allTriToInsert, allVtxsToInsert);
 	}
 	else
-		GrabOctreeRoot().Insert(*this, extractOutOfBounds.GetExtractedTris(), extractOutOfBounds.GetExtractedVtxs());
+		_octree->Insert(*this, extractOutOfBounds.GetExtractedTris(), extractOutOfBounds.GetExtractedVtxs());
+	if(_bvh != nullptr)
+		_bvh->AddTrianglesToInsert(additionalTrisToInsert);
 	// Purge empty cells
 	VisitorPurgeEmptyCell purgeEmptyCell;
 	GrabOctreeRoot().Traverse(purgeEmptyCell);
@@ -299,6 +581,15 @@ void Mesh::ReBalanceOctree(std::vector<unsigned int> const& additionalTrisToInse
 	RecomputeFragmentsBBox(extractFromAllCells);
 }
 
+void Mesh::InsertInOctree(std::vector<unsigned int> const& trisToInsert, std::vector<unsigned int> const& vtxsToInsert)
+{
+	if(_octree == nullptr)
+		return;
+	_octree->Insert(*this, trisToInsert, vtxsToInsert, true);
+	if(_bvh != nullptr)
+		_bvh->AddTrianglesToInsert(trisToInsert);
+}
+
 void Mesh::HandlePendingRemovals()
 {	// Will actually remove vertices and triangles that were tagged as "remove pending" and will pack again vertices and triangles data
 #ifdef THICKNESS_HANDLER_WIP
@@ -320,6 +611,7 @@ void Mesh::HandlePendingRemovals()
 				}
 				_vtxsNewIdx[j] = i;	// Note: all new ids are stored at the end of the array, thus we won't have to clear the data, it will be done during the pop_backs
 				--backPosOfMovedElement;
+				++_nbScatteredElements;
 			}
 			else
 				--backPosOfMovedElement;	// Element to remove is already at the end of the array, we won't have to move anything for that element
@@ -330,6 +622,7 @@ void Mesh::HandlePendingRemovals()
 	{
 		if(TestStateFlags(_trisState[i], TRI_STATE_PENDING_REMOVE))
 		{
+			SetTriangleTwinToUpdate(i);	// Some are still in the fans (see CSG), their twins have to be relinked without them
 			if((unsigned int) i < backPosOfMovedElement)
 			{
 				unsigned int j;
@@ -340,17 +633,20 @@ void Mesh::HandlePendingRemovals()
 				}
 				_trisNewIdx[j] = i;	// Note: all new ids are stored at the end of the array, thus we won't have to clear the data, it will be done during the pop_backs
 				--backPosOfMovedElement;
+				++_nbScatteredElements;
 			}
 			else
 				--backPosOfMovedElement;	// Element to remove is already at the end of the array, we won't have to move anything for that element
 		}
 	}
 	// Purge from octree vertices and triangles that were set to be removed and remap the vertices and triangles index of the one that will be moved
-	if(_octreeRoot != nullptr)
+	if(_octree != nullptr)
 	{
 		OctreeVisitorHandlePendingRemovals handlePendingRemovals(*this, true);
-		_octreeRoot->Traverse(handlePendingRemovals);
+		GrabOctreeRoot().ParallelTraverse(handlePendingRemovals);
 	}
+	if(_bvh != nullptr)
+		_bvh->RemapIndices(*this);
 	// Do the same on the retessellate component
 	GrabRetessellator().HandlePendingRemovals();
 	// Update in the same way _vtxToTriAround data
@@ -358,15 +654,15 @@ void Mesh::HandlePendingRemovals()
 	{
 		if(TestStateFlags(_vtxsState[vtxIdx], VTX_STATE_PENDING_REMOVE) == false)
 		{
-			std::vector<unsigned int>& trianglesIdx = _vtxToTriAround[vtxIdx];
-			for(unsigned int i = 0; i < trianglesIdx.size();)
+			unsigned int* trianglesIdx = _vtxToTriAround.GrabData(vtxIdx);
+			unsigned int nbTriangles = _vtxToTriAround.GetCount(vtxIdx);
+			for(unsigned int i = 0; i < nbTriangles;)
 			{
 				unsigned int& triIdx = trianglesIdx[i];
 				if(TestStateFlags(_trisState[triIdx], TRI_STATE_PENDING_REMOVE))
 				{	// Remove element
-					triIdx = trianglesIdx.back();
-					trianglesIdx.pop_back();
-					ASSERT(trianglesIdx.size() > 2);	// Must be the case on a manifold mesh
+					triIdx = trianglesIdx[--nbTriangles];
+					ASSERT(nbTriangles > 2);	// Must be the case on a manifold mesh
 				}
 				else
 				{
@@ -375,6 +671,7 @@ void Mesh::HandlePendingRemovals()
 					++i;
 				}
 			}
+			_vtxToTriAround.Shrink(vtxIdx, nbTriangles);
 		}
 	}
 	// Update _triangles data
@@ -388,6 +685,30 @@ void Mesh::HandlePendingRemovals()
 		else
 			ASSERT((TestStateFlags(_vtxsState[vtxIdx], VTX_STATE_PENDING_REMOVE) == false) || TestStateFlags(_trisState[i / 3], TRI_STATE_PENDING_REMOVE));	// Should never happen: when someone removes a vertex he should relink the affected triangles to a new vertex
 	}
+	// Update _trisTwin data, twins of the removed triangles are relinked by UpdateTrisTwin once the removal is done
+	for(unsigned int& twinIdx : _trisTwin)
+	{
+		if(TestStateFlags(_trisState[twinIdx], TRI_STATE_PENDING_REMOVE))
+			twinIdx = UNDEFINED_NEW_ID;
+		else if(TriHasToMove(twinIdx))
+			twinIdx = GetNewTriIdx(twinIdx);	// Remap element
+	}
+	// Update _trisIdxToUpdateTwin data
+	for(unsigned int i = 0; i < _trisIdxToUpdateTwin.size();)
+	{
+		unsigned int& triIdx = _trisIdxToUpdateTwin[i];
+		if(TestStateFlags(_trisState[triIdx], TRI_STATE_PENDING_REMOVE))
+		{	// Remove element
+			triIdx = _trisIdxToUpdateTwin.back();
+			_trisIdxToUpdateTwin.pop_back();
+		}
+		else
+		{
+			if(TriHasToMove(triIdx))
+				triIdx = GetNewTriIdx(triIdx);	// Remap element
+			++i;
+		}
+	}
 	// Update _trisIdxToRecomputeNormalOn data
 	for(unsigned int i = 0; i < _trisIdxToRecomputeNormalOn.size();)
 	{
@@ -420,6 +741,31 @@ void Mesh::HandlePendingRemovals()
 			++i;
 		}
 	}
+	// Shared sub meshes are windows on our buffers: cells using moved vertices have to check their sub mesh
+	if((_subMeshesVisitor != nullptr) && _subMeshesVisitor->IsSharingFullMeshBuffers())
+	{
+		for(unsigned int vtxIdx = 0; vtxIdx < _vtxsNewIdx.size(); ++vtxIdx)
+		{
+			if(VtxHasToMove(vtxIdx))
+				SetVertexToUpdateInSubMesh(vtxIdx);
+		}
+	}
+	// Update _vtxsIdxToUpdateInSubMesh data
+	for(unsigned int i = 0; i < _vtxsIdxToUpdateInSubMesh.size();)
+	{
+		unsigned int& vtxIdx = _vtxsIdxToUpdateInSubMesh[i];
+		if(TestStateFlags(_vtxsState[vtxIdx], VTX_STATE_PENDING_REMOVE))
+		{	// Remove element
+			vtxIdx = _vtxsIdxToUpdateInSubMesh.back();
+			_vtxsIdxToUpdateInSubMesh.pop_back();
+		}
+		else
+		{	
+			if(VtxHasToMove(vtxIdx))
+				vtxIdx = GetNewVtxIdx(vtxIdx);	// Remap element
+			++i;
+		}
+	}
 	// Now do the main vertices and triangles data removal
 	for(signed int i = (signed int) _vtxsState.size() - 1; i >= 0; --i)
 	{
@@ -429,8 +775,9 @@ void Mesh::HandlePendingRemovals()
 			_vertices.pop_back();
 			_vtxsNormal[i] = _vtxsNormal.back();
 			_vtxsNormal.pop_back();
-			_vtxToTriAround[i] = _vtxToTriAround.back();
-			_vtxToTriAround.pop_back();
+			if((unsigned int) i != _vtxToTriAround.size() - 1)
+				_vtxToTriAround.MoveVertex(_vtxToTriAround.size() - 1, i);
+			_vtxToTriAround.PopBackVertex();
 			_vtxsState[i] = _vtxsState.back();
 			_vtxsState.pop_back();
 			_vtxsNewIdx.pop_back();
@@ -450,16 +797,28 @@ void Mesh::HandlePendingRemovals()
 			_trisNormal.pop_back();
 			_trisBSphere[i] = _trisBSphere.back();
 			_trisBSphere.pop_back();
+			for(signed int j = 2; j >= 0; --j)
+			{
+				_trisTwin[i * 3 + j] = _trisTwin.back();
+				_trisTwin.pop_back();
+			}
+			_trisOctreeCell[i] = _trisOctreeCell.back();
+			_trisOctreeCell.pop_back();
 			_trisState[i] = _trisState.back();
 			_trisState.pop_back();
 			_trisNewIdx.pop_back();
 		}
 	}
+	// Lists relocated during the stroke(s) left holes behind them
+	if(_vtxToTriAround.HasToCompact())
+		_vtxToTriAround.Compact();
+	// Relink the twins of the removed triangles
+	UpdateTrisTwin();
 	// Purge empty cells
-	if(_octreeRoot != nullptr)
+	if(_octree != nullptr)
 	{
 		VisitorPurgeEmptyCell purgeEmptyCell;
-		_octreeRoot->Traverse(purgeEmptyCell);
+		GrabOctreeRoot().Traverse(purgeEmptyCell);
 	}
 #ifndef CLEAN_PENDING_REMOVALS_IMMEDIATELY
 	// Clear our pending Remove buffer
@@ -470,6 +829,133 @@ void Mesh::HandlePendingRemovals()
 #endif // !CLEAN_PENDING_REMOVALS_IMMEDIATELY
 }
 
+// Gather array elements in the given order (newOrder[newIdx] = oldIdx), "stride" elements per index
+template<typename T> static void ReorderArray(std::vector<T>& array, std::vector<unsigned int> const& newOrder, unsigned int stride = 1)
+{
+	std::vector<T> reorderedArray;
+	reorderedArray.reserve(array.size());
+	for(unsigned int oldIdx : newOrder)
+		reorderedArray.insert(reorderedArray.end(), array.begin() + oldIdx * stride, array.begin() + (oldIdx + 1) * stride);
+	array.swap(reorderedArray);
+}
+
+// Fill "newIdx" from "newOrder" (elements missing from it are kept at the end), elements that don't move get UNDEFINED_NEW_ID
+static void ComputeNewIdx(std::vector<unsigned int>& newOrder, std::vector<unsigned int>& newIdx)
+{
+	ASSERT(newOrder.size() <= newIdx.size());
+	for(unsigned int idx = 0; idx < newOrder.size(); ++idx)
+	{
+		ASSERT(newIdx[newOrder[idx]] == UNDEFINED_NEW_ID);	// An element is held by only one cell
+		newIdx[newOrder[idx]] = idx;
+	}
+	for(unsigned int oldIdx = 0; oldIdx < newIdx.size(); ++oldIdx)
+	{
+		if(newIdx[oldIdx] == UNDEFINED_NEW_ID)
+		{	// Not held by the octree, keep it at the end
+			newIdx[oldIdx] = (unsigned int) newOrder.size();
+			newOrder.push_back(oldIdx);
+		}
+	}
+	for(unsigned int oldIdx = 0; oldIdx < newIdx.size(); ++oldIdx)
+	{
+		if(newIdx[oldIdx] == oldIdx)
+			newIdx[oldIdx] = UNDEFINED_NEW_ID;	// Doesn't move
+	}
+}
+
+void Mesh::ReorderPerCell()
+{	// Each octree leaf vertices and triangles become contiguous in our buffers: neighbour elements end up close in memory
+	if(_octree == nullptr)
+		return;
+#ifndef CLEAN_PENDING_REMOVALS_IMMEDIATELY
+	ASSERT(_vtxsIdxToRemove.empty() && _vtxsIdxToRecycle.empty() && _trisIdxToRemove.empty() && _trisIdxToRecycle.empty());
+#endif // !CLEAN_PENDING_REMOVALS_IMMEDIATELY
+	ASSERT((_retessellator == nullptr) || _retessellator->IsReset());
+#ifdef PROFILE_INFO
+	clock_t begin = clock();
+#endif // PROFILE_INFO
+	// Compute new order
+	std::vector<unsigned int> vtxsNewOrder;
+	std::vector<unsigned int> trisNewOrder;
+	vtxsNewOrder.reserve(_vertices.size());
+	trisNewOrder.reserve(_trisState.size());
+	GrabOctreeRoot().CollectIndices(vtxsNewOrder, trisNewOrder);
+	ComputeNewIdx(vtxsNewOrder, _vtxsNewIdx);
+	ComputeNewIdx(trisNewOrder, _trisNewIdx);
+	UpdateTrisTwin();	// So that only the twin table has to be remapped
+	// Remap indices in the octree and the sub meshes (only a renumbering, cells content doesn't change)
+	GrabOctreeRoot().RemapIndices(*this);
+	if(_bvh != nullptr)
+		_bvh->RemapIndices(*this);
+	if(_subMeshesVisitor != nullptr)
+		_subMeshesVisitor->RemapFullMeshVerticesIdx();
+	// Remap indices in our data
+	for(unsigned int& vtxIdx : _triangles)
+	{
+		if(VtxHasToMove(vtxIdx))
+			vtxIdx = GetNewVtxIdx(vtxIdx);
+	}
+	for(unsigned int vtxIdx = 0; vtxIdx < _vtxToTriAround.size(); ++vtxIdx)
+	{
+		unsigned int* trianglesIdx = _vtxToTriAround.GrabData(vtxIdx);
+		unsigned int nbTriangles = _vtxToTriAround.GetCount(vtxIdx);
+		for(unsigned int i = 0; i < nbTriangles; ++i)
+		{
+			if(TriHasToMove(trianglesIdx[i]))
+				trianglesIdx[i] = GetNewTriIdx(trianglesIdx[i]);
+		}
+	}
+	for(unsigned int& twinIdx : _trisTwin)
+	{
+		if(TriHasToMove(twinIdx))
+			twinIdx = GetNewTriIdx(twinIdx);
+	}
+	for(unsigned int& triIdx : _trisIdxToRecomputeNormalOn)
+	{
+		if(TriHasToMove(triIdx))
+			triIdx = GetNewTriIdx(triIdx);
+	}
+	for(unsigned int& vtxIdx : _vtxsIdxToRecomputeNormalOn)
+	{
+		if(VtxHasToMove(vtxIdx))
+			vtxIdx = GetNewVtxIdx(vtxIdx);
+	}
+	for(unsigned int& vtxIdx : _vtxsIdxToUpdateInSubMesh)
+	{
+		if(VtxHasToMove(vtxIdx))
+			vtxIdx = GetNewVtxIdx(vtxIdx);
+	}
+	// Move vertices data
+	ReorderArray(_vertices, vtxsNewOrder);
+	ReorderArray(_vtxsNormal, vtxsNewOrder);
+	ReorderArray(_vtxsState, vtxsNewOrder);
+	_vtxToTriAround.Reorder(vtxsNewOrder);
+	// Move triangles data
+	ReorderArray(_triangles, trisNewOrder, 3);
+	ReorderArray(_trisTwin, trisNewOrder, 3);
+	ReorderArray(_trisState, trisNewOrder);
+	ReorderArray(_trisNormal, trisNewOrder);
+	ReorderArray(_trisBSphere, trisNewOrder);
+	ReorderArray(_trisOctreeCell, trisNewOrder);
+	for(unsigned int& newIdx : _vtxsNewIdx)
+		newIdx = UNDEFINED_NEW_ID;
+	for(unsigned int& newIdx : _trisNewIdx)
+		newIdx = UNDEFINED_NEW_ID;
+	_nbScatteredElements = 0;
+#ifdef PROFILE_INFO
+	clock_t end = clock();
+	printf("Vertices and triangles reordered in %f\n", double(end - begin) / CLOCKS_PER_SEC);
+#endif // PROFILE_INFO
+}
+
+void Mesh::ReorderIfFragmented()
+{
+	if(AreSubMeshesSharingBuffers() && GrabSubMeshesVisitor().IsSharedBuffersFragmented())
+		ReorderPerCell();	// Sub meshes windows grew too much
+	else if((_reorderThreshold > 0.0f) && (_nbScatteredElements > (_vertices.size() + _trisState.size()) * _reorderThreshold))
+		ReorderPerCell();
+}
+
 void Mesh::RecomputeNormals(bool forceReducedCompute, bool authorizeAutoSmooth)
 {
 #ifdef DEBUG_ALWAYS_REBUILD_ALL_NORMALS
@@ -516,152 +1002,133 @@ void Mesh::RecomputeNormals(bool forceReducedCompute, bool authorizeAutoSmooth)
 	// Empty reduced normal computing vectors
 	_vtxsIdxToRecomputeNormalOn.clear();
 	_trisIdxToRecomputeNormalOn.clear();
+	if(_bvh != nullptr)
+		_bvh->SetHasToRefitAll();
 	return;
 #else
 	if((_vtxsIdxToRecomputeNormalOn.size() == 0) && (forceReducedCompute == false))	// Full recompute of the normals' mesh
 	{
-		// Reset vertices normal
-#pragma omp parallel for
-		for(int i = 0; i < _vertices.size(); ++i)
-			_vtxsNormal[i].ResetToZero();
-
-		// Build triangles and vertices normal
+		// Build triangles normal (and bsphere), vectorized
+		TrisNormalJob trisNormalJob = { _vertices.data(), _triangles.data(), nullptr, (unsigned int) _trisState.size(), SculptEngine::IsTriangleOrientationInverted(), _trisNormal.data(), _trisBSphere.data() };
+		ComputeTrianglesNormalAndBSphere(trisNormalJob);
 #pragma omp parallel for
 		for(int i = 0; i < _trisState.size(); ++i)
-		{
-			// Compute triangles normal
-			unsigned char& triState = _trisState[i];
-			unsigned int const* vtxsIdx = &(_triangles[i * 3]);
-
-			Vector3& vtx1 = _vertices[vtxsIdx[0]];
-			Vector3& vtx2 = _vertices[vtxsIdx[1]];
-			Vector3& vtx3 = _vertices[vtxsIdx[2]];
+			ClearStateFlags(_trisState[i], TRI_STATE_HAS_TO_RECOMPUTE_NORMAL);
 
-			Vector3 p1p2 = vtx2 - vtx1;
-			Vector3 p1p3 = vtx3 - vtx1;
-
-			Vector3& triNormal = _trisNormal[i];
-			triNormal = p1p2.Cross(p1p3);
-			float triNormalLength = triNormal.Length();
-			if(triNormalLength != 0.0f)
-			{
-				triNormal /= triNormalLength;
-				if(SculptEngine::IsTriangleOrientationInverted())
-					triNormal.Negate();
-			}
-
-			// (Also compute triangle bsphere)
-			_trisBSphere[i].BuildFromTriangle(vtx1, vtx2, vtx3);
-
-			// sum normal on triangle vertices
-			_vtxsNormal[vtxsIdx[0]] += triNormal;
-			_vtxsNormal[vtxsIdx[1]] += triNormal;
-			_vtxsNormal[vtxsIdx[2]] += triNormal;
-
-			ClearStateFlags(triState, TRI_STATE_HAS_TO_RECOMPUTE_NORMAL);
-		}
-
-		// Normalize vertices normal
+		// Build vertices normal: each vertex gathers the normals of its surrounding triangles, so threads never write to the same vertex
+		// and the summing order only depends on _vtxToTriAround (result is the same whatever the number of threads)
 #pragma omp parallel for
 		for(int i = 0; i < _vertices.size(); ++i)
 		{
-			if (_vtxsNormal[i].LengthSquared() == 0.0f)	// Todo: remove this, we shouldn't end up with null vtx normals
+			Vector3& vtxNormal = _vtxsNormal[i];
+			TriangleFan triArround = _vtxToTriAround[i];
+			vtxNormal.ResetToZero();
+			for(unsigned int triIdx : triArround)
+				vtxNormal += _trisNormal[triIdx];
+			if (vtxNormal.LengthSquared() == 0.0f)	// Todo: remove this, we shouldn't end up with null vtx normals
 			{
-				if (!_vtxToTriAround[i].empty())
-					_vtxsNormal[i] = _trisNormal[_vtxToTriAround[i][0]];
+				if (!triArround.empty())
+					vtxNormal = _trisNormal[triArround[0]];
 				else
-					_vtxsNormal[i] = Vector3(1.0f, 0.0f, 0.0f);
+					vtxNormal = Vector3(1.0f, 0.0f, 0.0f);
 			}
-			_vtxsNormal[i].Normalize();
+			vtxNormal.Normalize();
 			ClearStateFlags(_vtxsState[i], VTX_STATE_HAS_TO_RECOMPUTE_NORMAL);
 		}
+		if(_bvh != nullptr)
+			_bvh->SetHasToRefitAll();
 	}
 	else // Reduced recompute of the normals' mesh
 	{
-		// Update triangles normal
-#pragma omp parallel for
-		for(int i = 0; i < _trisIdxToRecomputeNormalOn.size(); ++i)
+		// Collect triangles that really have to update their normal (the list may contain duplicates)
+		std::vector<unsigned int> trisIdxToCompute;
+		trisIdxToCompute.reserve(_trisIdxToRecomputeNormalOn.size());
+		for(unsigned int triIdx : _trisIdxToRecomputeNormalOn)
 		{
-			unsigned int const& triIdx = _trisIdxToRecomputeNormalOn[i];
-			// Compute triangles normal
 			unsigned char& triState = _trisState[triIdx];
 			if(TestStateFlags(triState, TRI_STATE_HAS_TO_RECOMPUTE_NORMAL))
 			{
-				unsigned int const* vtxsIdx = &(_triangles[triIdx * 3]);
-
+#ifdef _DEBUG
 				// If a triangle has to recompute its normal, its vertices must have been set the same way
+				unsigned int const* vtxsIdx = &(_triangles[triIdx * 3]);
 				ASSERT(TestStateFlags(_vtxsState[vtxsIdx[0]], VTX_STATE_HAS_TO_RECOMPUTE_NORMAL));
 				ASSERT(TestStateFlags(_vtxsState[vtxsIdx[1]], VTX_STATE_HAS_TO_RECOMPUTE_NORMAL));
 				ASSERT(TestStateFlags(_vtxsState[vtxsIdx[2]], VTX_STATE_HAS_TO_RECOMPUTE_NORMAL));
+#endif // _DEBUG
+				trisIdxToCompute.push_back(triIdx);
+				ClearStateFlags(triState, TRI_STATE_HAS_TO_RECOMPUTE_NORMAL);
+			}
+		}
 
-				Vector3& vtx1 = _vertices[vtxsIdx[0]];
-				Vector3& vtx2 = _vertices[vtxsIdx[1]];
-				Vector3& vtx3 = _vertices[vtxsIdx[2]];
-
-				Vector3 p1p2 = vtx2 - vtx1;
-				Vector3 p1p3 = vtx3 - vtx1;
-
-				Vector3& triNormal = _trisNormal[triIdx];
-				triNormal = p1p2.Cross(p1p3);
-				float triNormalLength = triNormal.Length();
-				if(triNormalLength != 0.0f)
-				{
-					triNormal /= triNormalLength;
-					if(SculptEngine::IsTriangleOrientationInverted())
-						triNormal.Negate();
-				}
-
-				// (Also compute triangle bsphere)
-				_trisBSphere[triIdx].BuildFromTriangle(vtx1, vtx2, vtx3);
+		// Update triangles normal (and bsphere), vectorized
+		TrisNormalJob trisNormalJob = { _vertices.data(), _triangles.data(), trisIdxToCompute.data(), (unsigned int) trisIdxToCompute.size(), SculptEngine::IsTriangleOrientationInverted(), _trisNormal.data(), _trisBSphere.data() };
+		ComputeTrianglesNormalAndBSphere(trisNormalJob);
 
-				ClearStateFlags(triState, TRI_STATE_HAS_TO_RECOMPUTE_NORMAL);
+		// Collect vertices that really have to update their normal (here too, the list may contain duplicates)
+		std::vector<unsigned int> vtxsIdxToCompute;
+		vtxsIdxToCompute.reserve(_vtxsIdxToRecomputeNormalOn.size());
+		for(unsigned int vtxIdx : _vtxsIdxToRecomputeNormalOn)
+		{
+			unsigned char& vtxState = _vtxsState[vtxIdx];
+			if(TestStateFlags(vtxState, VTX_STATE_HAS_TO_RECOMPUTE_NORMAL))
+			{
+				vtxsIdxToCompute.push_back(vtxIdx);
+				ClearStateFlags(vtxState, VTX_STATE_HAS_TO_RECOMPUTE_NORMAL);
 			}
 		}
 
-		// Update vertices normal
+		// Update vertices normal (gathered from the surrounding triangles, each vertex being treated by only one thread)
 		bool autoSmooth = authorizeAutoSmooth && HasToDoAnEmergencyAutoSmooth();
+		std::vector<Vector3> smoothedVertices;
+		if(autoSmooth)
+			smoothedVertices.resize(vtxsIdxToCompute.size());	// Smoothed positions are applied once all vertices are treated, so that every vertex reads its neighbours unmodified
 #pragma omp parallel for
-		for(int i = 0; i < _vtxsIdxToRecomputeNormalOn.size(); ++i)
+		for(int i = 0; i < vtxsIdxToCompute.size(); ++i)
 		{
-			unsigned int const& vtxIdx = _vtxsIdxToRecomputeNormalOn[i];
-			unsigned char& vtxState = _vtxsState[vtxIdx];
-			if(TestStateFlags(vtxState, VTX_STATE_HAS_TO_RECOMPUTE_NORMAL))
+			unsigned int const& vtxIdx = vtxsIdxToCompute[i];
+			Vector3& vtxNormal = _vtxsNormal[vtxIdx];
+			TriangleFan triArround = _vtxToTriAround[vtxIdx];
+			if(triArround.empty() == false)
 			{
-				Vector3& vtxNormal = _vtxsNormal[vtxIdx];
-				std::vector<unsigned int> const& triArround = _vtxToTriAround[vtxIdx];
-				if(triArround.empty() == false)
-				{
-					vtxNormal = _trisNormal[triArround[0]];
-					// Sum normal from all surrounding faces
-					for(unsigned int j = 1; j < (unsigned int) triArround.size(); ++j)
-						vtxNormal += _trisNormal[triArround[j]];
-
-					if(autoSmooth)
-					{	// AutoSmooth, still experimental
-						Vector3 averageVertex;
-						unsigned int nbVerticesInvolved = 0;
-						for(unsigned int triIdx : _vtxToTriAround[vtxIdx])
+				vtxNormal = _trisNormal[triArround[0]];
+				// Sum normal from all surrounding faces
+				for(unsigned int j = 1; j < (unsigned int) triArround.size(); ++j)
+					vtxNormal += _trisNormal[triArround[j]];
+
+				if(autoSmooth)
+				{	// AutoSmooth, still experimental
+					Vector3 averageVertex;
+					unsigned int nbVerticesInvolved = 0;
+					for(unsigned int triIdx : _vtxToTriAround[vtxIdx])
+					{
+						unsigned int const* vtxIdxs = &(_triangles[triIdx * 3]);
+						for(unsigned int k = 0; k < 3; ++k)
 						{
-							unsigned int const* vtxIdxs = &(_triangles[triIdx * 3]);
-							for(unsigned int k = 0; k < 3; ++k)
+							if(vtxIdxs[k] != vtxIdx)
 							{
-								if(vtxIdxs[k] != vtxIdx)
-								{
-									averageVertex += _vertices[vtxIdxs[k]];
-									nbVerticesInvolved++;
-								}
+								averageVertex += _vertices[vtxIdxs[k]];
+								nbVerticesInvolved++;
 							}
 						}
-						_vertices[vtxIdx] = averageVertex / float(nbVerticesInvolved);
 					}
-
-					if(vtxNormal.LengthSquared() == 0.0f)	// Todo: remove this, we shouldn't end up with null vtx normals
-						vtxNormal = _trisNormal[triArround[0]];
-					vtxNormal.Normalize();
+					smoothedVertices[i] = averageVertex / float(nbVerticesInvolved);
 				}
-				ClearStateFlags(vtxState, VTX_STATE_HAS_TO_RECOMPUTE_NORMAL);
+
+				if(vtxNormal.LengthSquared() == 0.0f)	// Todo: remove this, we shouldn't end up with null vtx normals
+					vtxNormal = _trisNormal[triArround[0]];
+				vtxNormal.Normalize();
 			}
+			else if(autoSmooth)
+				smoothedVertices[i] = _vertices[vtxIdx];
+		}
+		if(autoSmooth)
+		{
+			for(unsigned int i = 0; i < vtxsIdxToCompute.size(); ++i)
+				_vertices[vtxsIdxToCompute[i]] = smoothedVertices[i];
 		}
+		GrowCellsContentBBox(vtxsIdxToCompute);
+		if(_bvh != nullptr)
+			_bvh->SetVerticesMoved(*this, vtxsIdxToCompute);
 	}
 	// Empty reduced normal computing vectors
 	_vtxsIdxToRecomputeNormalOn.clear();
@@ -687,7 +1154,7 @@ void Mesh::ProcessHardEdges(std::vector<unsigned int>* createdTriangles, std::ve
 	const unsigned int TRI_TO_TREAT = UNDEFINED_NEW_ID - 1;
 	for(unsigned int i = 0; i < _vertices.size(); ++i)
 	{
-		std::vector<unsigned int> const& trisAround = _vtxToTriAround[i];
+		TriangleFan trisAround = _vtxToTriAround[i];
 		if(trisAround.size() >= 2)
 		{
 			Vector3 refNormal = _trisNormal[trisAround[0]];
@@ -748,7 +1215,7 @@ void Mesh::ProcessHardEdges(std::vector<unsigned int>* createdTriangles, std::ve
 				bool processSurroundings = true;
 				for(unsigned int i = 0; i < 3; ++i)
 				{
-					std::vector<unsigned int> const& trisAround = _vtxToTriAround[triToTreatVtxIdxs[i]];
+					TriangleFan trisAround = _vtxToTriAround[triToTreatVtxIdxs[i]];
 					for(unsigned int triAround : trisAround)
 					{
 						if((triAround != triToTreat) && (smoothGroup[triAround] == curSmoothGroup))
@@ -763,7 +1230,7 @@ void Mesh::ProcessHardEdges(std::vector<unsigned int>* createdTriangles, std::ve
 				{
 					for(unsigned int i = 0; i < 3; ++i)
 					{
-						std::vector<unsigned int> const& trisAround = _vtxToTriAround[triToTreatVtxIdxs[i]];
+						TriangleFan trisAround = _vtxToTriAround[triToTreatVtxIdxs[i]];
 						for(unsigned int triAround : trisAround)
 						{
 							if((triAround != triToTreat) && (smoothGroup[triAround] == TRI_TO_TREAT))
@@ -822,25 +1289,13 @@ void Mesh::ProcessHardEdges(std::vector<unsigned int>* createdTriangles, std::ve
 									{	// Check if the triangles touching edge vtxIdxsTriAround[j] <-> vtxToTreat are on the curSmoothGroup
 										unsigned int idxA = vtxToTreat;
 										unsigned int idxB = vtxIdxsTriAround[j];
-										std::vector<unsigned int> const& triAroundA = _vtxToTriAround[idxA];
-										std::vector<unsigned int> const& triAroundB = _vtxToTriAround[idxB];
-										bool limitEdgeTreated = false;
-										for(unsigned int triIdxA : triAroundA)		// Todo : O(n), of course optimize this
+										for(unsigned int triIdxA : _vtxToTriAround[idxA])
 										{
-											for(unsigned int triIdxB : triAroundB)
-											{
-												if(triIdxA == triIdxB)
-												{	// triangle common to vertex A and B
-													if((smoothGroup[triIdxA] != curSmoothGroup))
-													{	// Edge on the smooth group limit
-														++genTriangles;
-														limitEdgeTreated = true;
-													}
-													break;
-												}
-											}
-											if(limitEdgeTreated)
+											if(TriangleHasVertex(triIdxA, idxB) && (smoothGroup[triIdxA] != curSmoothGroup))
+											{	// triangle common to vertex A and B, edge on the smooth group limit
+												++genTriangles;
 												break;
+											}
 										}
 									}
 								}
@@ -867,48 +1322,36 @@ void Mesh::ProcessHardEdges(std::vector<unsigned int>* createdTriangles, std::ve
 										{	// Check if the triangles touching edge vtxIdxsTriAround[j] <-> vtxToTreat are on the curSmoothGroup
 											unsigned int idxA = vtxToTreat;
 											unsigned int idxB = vtxIdxsTriAround[j];
-											std::vector<unsigned int> const& triAroundA = _vtxToTriAround[idxA];
-											std::vector<unsigned int> const& triAroundB = _vtxToTriAround[idxB];
-											bool limitEdgeTreated = false;
-											for(unsigned int triIdxA : triAroundA)		// Todo : O(n), of course optimize this
-											{
-												for(unsigned int triIdxB : triAroundB)
-												{
-													if(triIdxA == triIdxB)
-													{	// triangle common to vertex A and B
-														if((smoothGroup[triIdxA] != curSmoothGroup))
-														{	// Edge on the smooth group limit
-															Vector3 nullNorm;
-															bool revertTri = false;
-															unsigned int* vtxIdxsTriA = &(_triangles[triIdxA * 3]);
-															if(vtxIdxsTriA[0] == idxA)
-																revertTri = vtxIdxsTriA[2] == idxB;
-															else if(vtxIdxsTriA[1] == idxA)
-																revertTri = vtxIdxsTriA[0] == idxB;
-															else //if(vtxIdxsTriA[2] == idxA)
-															{
-																ASSERT(vtxIdxsTriA[2] == idxA);
-																revertTri = vtxIdxsTriA[1] == idxB;
-															}
-															unsigned int newTriIDx = UNDEFINED_NEW_ID;
-															if(revertTri)
-																newTriIDx = AddTriangle(idxA, idxB, newVtx, nullNorm, true);
-															else
-																newTriIDx = AddTriangle(newVtx, idxB, idxA, nullNorm, true);
-															AddTriangleAroundVertex(idxA, newTriIDx);
-															AddTriangleAroundVertex(idxB, newTriIDx);
-															AddTriangleAroundVertex(newVtx, newTriIDx);
-															if(createdTriangles != nullptr)
-																createdTriangles->push_back(newTriIDx);
-															ASSERT(smoothGroup.size() == newTriIDx);
-															smoothGroup.push_back(0);	// Degenerated triangle, so smooth group 0
-															limitEdgeTreated = true;
-														}
-														break;
+											for(unsigned int triIdxA : _vtxToTriAround[idxA])
+											{	// Scan the fan rather than walking the twins: triAround is being relinked to newVtx
+												if(TriangleHasVertex(triIdxA, idxB) && (smoothGroup[triIdxA] != curSmoothGroup))
+												{	// triangle common to vertex A and B, edge on the smooth group limit
+													Vector3 nullNorm;
+													bool revertTri = false;
+													unsigned int* vtxIdxsTriA = &(_triangles[triIdxA * 3]);
+													if(vtxIdxsTriA[0] == idxA)
+														revertTri = vtxIdxsTriA[2] == idxB;
+													else if(vtxIdxsTriA[1] == idxA)
+														revertTri = vtxIdxsTriA[0] == idxB;
+													else //if(vtxIdxsTriA[2] == idxA)
+													{
+														ASSERT(vtxIdxsTriA[2] == idxA);
+														revertTri = vtxIdxsTriA[1] == idxB;
 													}
-												}
-												if(limitEdgeTreated)
+													unsigned int newTriIDx = UNDEFINED_NEW_ID;
+													if(revertTri)
+														newTriIDx = AddTriangle(idxA, idxB, newVtx, nullNorm, true);
+													else
+														newTriIDx = AddTriangle(newVtx, idxB, idxA, nullNorm, true);
+													AddTriangleAroundVertex(idxA, newTriIDx);
+													AddTriangleAroundVertex(idxB, newTriIDx);
+													AddTriangleAroundVertex(newVtx, newTriIDx);
+													if(createdTriangles != nullptr)
+														createdTriangles->push_back(newTriIDx);
+													ASSERT(smoothGroup.size() == newTriIDx);
+													smoothGroup.push_back(0);	// Degenerated triangle, so smooth group 0
 													break;
+												}
 											}
 										}
 										else
@@ -942,6 +1385,128 @@ void Mesh::ProcessHardEdges(std::vector<unsigned int>* createdTriangles, std::ve
 #endif // MESH_CONSISTENCY_CHECK
 }
 
+unsigned int Mesh::GetEdgeNumber(unsigned int triIdx, unsigned int edgeVtx1, unsigned int edgeVtx2) const
+{
+	unsigned int const* vtxsIdx = &(_triangles[triIdx * 3]);
+	for(unsigned int i = 0; i < 3; ++i)
+	{
+		unsigned int vtxA = vtxsIdx[i];
+		unsigned int vtxB = vtxsIdx[(i + 1) % 3];
+		if(((vtxA == edgeVtx1) && (vtxB == edgeVtx2)) || ((vtxA == edgeVtx2) && (vtxB == edgeVtx1)))
+			return i;
+	}
+	return 3;	// Not an edge of this triangle
+}
+
+unsigned int Mesh::GetNextTriangleAroundEdge(unsigned int triIdx, unsigned int edgeVtx1, unsigned int edgeVtx2) const
+{
+	unsigned int edgeNumber = GetEdgeNumber(triIdx, edgeVtx1, edgeVtx2);
+	ASSERT(edgeNumber < 3);	// Triangle edited but not relinked in the fans yet
+	if(edgeNumber < 3)
+		return _trisTwin[triIdx * 3 + edgeNumber];
+	return UNDEFINED_NEW_ID;
+}
+
+void Mesh::LinkTrianglesAroundEdge(unsigned int triIdx, unsigned int edgeVtx1, unsigned int edgeVtx2)
+{	// Chain in a ring the triangles found around the edge in the smallest of the two vertex fans
+	auto SetNextTriangle = [&](unsigned int triAround, unsigned int nextTriIdx)
+	{
+		unsigned int const* vtxsIdx = &(_triangles[triAround * 3]);
+		for(unsigned int i = 0; i < 3; ++i)
+		{
+			unsigned int vtxA = vtxsIdx[i];
+			unsigned int vtxB = vtxsIdx[(i + 1) % 3];
+			if(((vtxA == edgeVtx1) && (vtxB == edgeVtx2)) || ((vtxA == edgeVtx2) && (vtxB == edgeVtx1)))
+				_trisTwin[triAround * 3 + i] = nextTriIdx;
+		}
+	};
+	bool triIdxLinked = false;
+	if(edgeVtx1 != edgeVtx2)
+	{
+		unsigned int fanVtx = edgeVtx1;
+		unsigned int otherVtx = edgeVtx2;
+		if(_vtxToTriAround.GetCount(edgeVtx2) < _vtxToTriAround.GetCount(edgeVtx1))
+			std::swap(fanVtx, otherVtx);
+		unsigned int firstTriIdx = UNDEFINED_NEW_ID;
+		unsigned int prevTriIdx = UNDEFINED_NEW_ID;
+		for(unsigned int triAround : _vtxToTriAround[fanVtx])
+		{
+			if(!TriangleHasVertex(triAround, otherVtx) || !TriangleHasVertex(triAround, fanVtx))
+				continue;	// Not around the edge (or edited and about to leave the fan)
+			if(prevTriIdx == UNDEFINED_NEW_ID)
+				firstTriIdx = triAround;
+			else
+				SetNextTriangle(prevTriIdx, triAround);
+			prevTriIdx = triAround;
+			triIdxLinked |= triAround == triIdx;
+		}
+		if(prevTriIdx != UNDEFINED_NEW_ID)
+			SetNextTriangle(prevTriIdx, firstTriIdx);	// Close the ring
+	}
+	if(!triIdxLinked)
+		SetNextTriangle(triIdx, triIdx);	// Not in the fans (yet), alone around the edge
+}
+
+void Mesh::UpdateTrisTwin()
+{
+	for(unsigned int triIdx : _trisIdxToUpdateTwin)
+	{
+		ClearStateFlags(_trisState[triIdx], TRI_STATE_HAS_TO_UPDATE_TWIN);
+		unsigned int const* vtxsIdx = &(_triangles[triIdx * 3]);
+		for(unsigned int i = 0; i < 3; ++i)
+			LinkTrianglesAroundEdge(triIdx, vtxsIdx[i], vtxsIdx[(i + 1) % 3]);
+	}
+	_trisIdxToUpdateTwin.clear();
+}
+
+void Mesh::BuildTrisTwin()
+{
+	_trisTwin.clear();
+	_trisTwin.resize(_triangles.size(), UNDEFINED_NEW_ID);
+	_trisIdxToUpdateTwin.clear();
+	for(unsigned int triIdx = 0; triIdx < _trisState.size(); ++triIdx)
+	{
+		unsigned int const* vtxsIdx = &(_triangles[triIdx * 3]);
+		for(unsigned int i = 0; i < 3; ++i)
+		{
+			if(_trisTwin[triIdx * 3 + i] == UNDEFINED_NEW_ID)
+				LinkTrianglesAroundEdge(triIdx, vtxsIdx[i], vtxsIdx[(i + 1) % 3]);	// Fills the whole ring
+		}
+	}
+}
+
+unsigned int Mesh::GetTriangleAcrossEdge(unsigned int triIdx, unsigned int edgeVtx1, unsigned int edgeVtx2)
+{
+	UpdateTrisTwin();
+	for(unsigned int triAround = GetNextTriangleAroundEdge(triIdx, edgeVtx1, edgeVtx2); (triAround != triIdx) && (triAround != UNDEFINED_NEW_ID); triAround = GetNextTriangleAroundEdge(triAround, edgeVtx1, edgeVtx2))
+	{
+		if(!TestStateFlags(_trisState[triAround], TRI_STATE_PENDING_REMOVE))
+			return triAround;
+	}
+	return UNDEFINED_NEW_ID;
+}
+
+void Mesh::GetTrianglesAroundEdge(unsigned int triIdx, unsigned int edgeVtx1, unsigned int edgeVtx2, std::vector<unsigned int>& triangles)
+{
+	UpdateTrisTwin();
+	triangles.clear();
+	triangles.push_back(triIdx);
+	for(unsigned int triAround = GetNextTriangleAroundEdge(triIdx, edgeVtx1, edgeVtx2); (triAround != triIdx) && (triAround != UNDEFINED_NEW_ID); triAround = GetNextTriangleAroundEdge(triAround, edgeVtx1, edgeVtx2))
+		triangles.push_back(triAround);
+}
+
+unsigned int Mesh::CountTrianglesAroundEdge(unsigned int triIdx, unsigned int edgeVtx1, unsigned int edgeVtx2, bool skipTrianglesToBeRemoved)
+{
+	UpdateTrisTwin();
+	unsigned int count = (skipTrianglesToBeRemoved && TestStateFlags(_trisState[triIdx], TRI_STATE_PENDING_REMOVE)) ? 0 : 1;
+	for(unsigned int triAround = GetNextTriangleAroundEdge(triIdx, edgeVtx1, edgeVtx2); (triAround != triIdx) && (triAround != UNDEFINED_NEW_ID); triAround = GetNextTriangleAroundEdge(triAround, edgeVtx1, edgeVtx2))
+	{
+		if(!skipTrianglesToBeRemoved || !TestStateFlags(_trisState[triAround], TRI_STATE_PENDING_REMOVE))
+			++count;
+	}
+	return count;
+}
+
 void Mesh::SetHasToRecomputeNormal(unsigned int vertexIndex)
 {
 #ifdef MESH_CONSISTENCY_CHECK
@@ -953,10 +1518,11 @@ void Mesh::SetHasToRecomputeNormal(unsigned int vertexIndex)
 	if(!TestStateFlags(vtxState, VTX_STATE_HAS_TO_RECOMPUTE_NORMAL))
 	{
 		_vtxsIdxToRecomputeNormalOn.push_back(vertexIndex);
-		AddStateFlags(vtxState, VTX_STATE_HAS_TO_RECOMPUTE_NORMAL | VTX_STATE_HAS_TO_RECOMPUTE_SUB_MESH);
+		AddStateFlags(vtxState, VTX_STATE_HAS_TO_RECOMPUTE_NORMAL);
+		SetVertexToUpdateInSubMesh(vertexIndex);
 	}
 	// Even if the vertex was already flagged to recompute normal, run on its surrounding triangles. As this vertex could have been flagged when handling surrounding triangles before this one
-	std::vector<unsigned int> const& triArround = _vtxToTriAround[vertexIndex];
+	TriangleFan triArround = _vtxToTriAround[vertexIndex];
 	for(unsigned int const& triIdx : triArround)
 	{
 		unsigned char& trisState = _trisState[triIdx];
@@ -973,7 +1539,8 @@ void Mesh::SetHasToRecomputeNormal(unsigned int vertexIndex)
 				ASSERT(!TestStateFlags(triVtxState, VTX_STATE_PENDING_REMOVE));
 				if(!TestStateFlags(triVtxState, VTX_STATE_HAS_TO_RECOMPUTE_NORMAL))
 				{
-					AddStateFlags(triVtxState, VTX_STATE_HAS_TO_RECOMPUTE_NORMAL | VTX_STATE_HAS_TO_RECOMPUTE_SUB_MESH);
+					AddStateFlags(triVtxState, VTX_STATE_HAS_TO_RECOMPUTE_NORMAL);
+					SetVertexToUpdateInSubMesh(triVtxIdx);
 					_vtxsIdxToRecomputeNormalOn.push_back(triVtxIdx);
 				}
 			}
@@ -981,6 +1548,70 @@ void Mesh::SetHasToRecomputeNormal(unsigned int vertexIndex)
 	}
 }
 
+void Mesh::SetHasToRecomputeNormals(std::vector<unsigned int> const& vtxsIdx)
+{
+	const unsigned int blockSize = 4096;	// Vertices per thread task
+	int nbBlocks = int((vtxsIdx.size() + blockSize - 1) / blockSize);
+	if(nbBlocks <= 1)
+	{
+		for(unsigned int vtxIdx : vtxsIdx)
+			SetHasToRecomputeNormal(vtxIdx);
+		return;
+	}
+	// Threads only read the states: each one collects in its own list the surrounding triangles not flagged yet (a triangle can be in several lists)
+	std::vector<std::vector<unsigned int>> blocksTrisIdx(nbBlocks);
+#pragma omp parallel for
+	for(int block = 0; block < nbBlocks; ++block)
+	{
+		std::vector<unsigned int>& trisIdx = blocksTrisIdx[block];
+		unsigned int end = min((unsigned int) (block + 1) * blockSize, (unsigned int) vtxsIdx.size());
+		for(unsigned int i = (unsigned int) block * blockSize; i < end; ++i)
+		{
+			TriangleFan triArround = _vtxToTriAround[vtxsIdx[i]];
+			for(unsigned int const& triIdx : triArround)
+			{
+				if(!TestStateFlags(_trisState[triIdx], TRI_STATE_HAS_TO_RECOMPUTE_NORMAL))
+					trisIdx.push_back(triIdx);
+			}
+		}
+	}
+	// Then lists are merged, setting the flags
+	auto FlagVertex = [&](unsigned int vtxIdx)
+	{
+		unsigned char& vtxState = _vtxsState[vtxIdx];
+		ASSERT(!TestStateFlags(vtxState, VTX_STATE_PENDING_REMOVE));
+		if(!TestStateFlags(vtxState, VTX_STATE_HAS_TO_RECOMPUTE_NORMAL))
+		{
+			AddStateFlags(vtxState, VTX_STATE_HAS_TO_RECOMPUTE_NORMAL);
+			SetVertexToUpdateInSubMesh(vtxIdx);
+			_vtxsIdxToRecomputeNormalOn.push_back(vtxIdx);
+		}
+	};
+	for(unsigned int vtxIdx : vtxsIdx)
+	{
+#ifdef MESH_CONSISTENCY_CHECK
+		CheckVertexIsCorrect(vtxIdx);
+#endif // MESH_CONSISTENCY_CHECK
+		FlagVertex(vtxIdx);
+	}
+	for(std::vector<unsigned int> const& trisIdx : blocksTrisIdx)
+	{
+		for(unsigned int triIdx : trisIdx)
+		{
+			unsigned char& trisState = _trisState[triIdx];
+			ASSERT(!TestStateFlags(trisState, TRI_STATE_PENDING_REMOVE));
+			if(!TestStateFlags(trisState, TRI_STATE_HAS_TO_RECOMPUTE_NORMAL))
+			{
+				AddStateFlags(trisState, TRI_STATE_HAS_TO_RECOMPUTE_NORMAL);
+				_trisIdxToRecomputeNormalOn.push_back(triIdx);
+				unsigned int const* triVtxsIdx = &(_triangles[triIdx * 3]);
+				for(int i = 0; i < 3; ++i)
+					FlagVertex(triVtxsIdx[i]);
+			}
+		}
+	}
+}
+
 void Mesh::BuildOctree(BBox bbox)
 {
 #ifdef PROFILE_INFO
@@ -996,17 +1627,13 @@ void Mesh::BuildOctree(BBox bbox)
 	}
 	bbox.Scale(10.0f);
 
-	std::vector<unsigned int> trianglesToInsert;
-	trianglesToInsert.resize(_trisState.size());
-	for(int i = 0; i < trianglesToInsert.size(); ++i)
-		trianglesToInsert[i] = i;
-	std::vector<unsigned int> verticesToInsert;
-	verticesToInsert.resize(_vtxsState.size());
-	for(int i = 0; i < verticesToInsert.size(); ++i)
-		verticesToInsert[i] = i;
-	_octreeRoot.reset(new OctreeCell(bbox, nullptr));
-	_octreeRoot->Insert(*this, trianglesToInsert, verticesToInsert);
+	_trisOctreeCell.clear();
+	_trisOctreeCell.resize(_trisState.size(), UNDEFINED_CELL_IDX);
+	_octree.reset(new Octree(bbox, _octreeLooseness, _octreeLeafCapacity));
+	_octree->BulkInsert(*this);
 	RecomputeFragmentsBBox(true);
+	if(_bvh != nullptr)
+		_bvh->Build(*this);
 
 #ifdef PROFILE_INFO
 	clock_t end = clock();
@@ -1101,21 +1728,7 @@ void Mesh::TagAndCollectOpenEdgesVertices(LoopBuilder *loopBuilder)
 					unsigned int otherVtxIdx = vtxsIdx[i];
 					if((otherVtxIdx != vtxIdx) && !TestStateFlags(_vtxsState[otherVtxIdx], VTX_STATE_ALREADY_TREATED))
 					{	// Test that an edge is only shared by two triangles
-						std::vector<unsigned int> const& triAroundA = _vtxToTriAround[vtxIdx];
-						std::vector<unsigned int> const& triAroundB = _vtxToTriAround[otherVtxIdx];
-						unsigned int nbSharedTriangles = 0;
-						for(unsigned int triIdxA : triAroundA)		// Todo : O(n), of course optimize this
-						{
-							for(unsigned int triIdxB : triAroundB)
-							{
-								if(triIdxA == triIdxB)
-								{	// Triangle common to vertex A and B
-									if(TestStateFlags(_trisState[triIdxA], TRI_STATE_PENDING_REMOVE) == false)
-										++nbSharedTriangles;
-									break;
-								}
-							}
-						}
+						unsigned int nbSharedTriangles = CountTrianglesAroundEdge(triIdx, vtxIdx, otherVtxIdx, true);
 						if(nbSharedTriangles == 1)
 						{
 							_IsOpen = true;
@@ -1139,21 +1752,7 @@ void Mesh::CheckTriangleIsCorrect(unsigned int triIdx, bool testFlateness)
 {
 	auto TestEdge = [&](unsigned int a, unsigned int b)
 	{	// Test that an edge is only shared by two triangles
-		std::vector<unsigned int> const& triAroundA = _vtxToTriAround[a];
-		std::vector<unsigned int> const& triAroundB = _vtxToTriAround[b];
-		unsigned int nbSharedTriangles = 0;
-		for(unsigned int triIdxA : triAroundA)		// Todo : O(n), of course optimize this
-		{
-			for(unsigned int triIdxB : triAroundB)
-			{
-				if(triIdxA == triIdxB)
-				{	// triangle common to vertex A and B
-					if(TestStateFlags(_trisState[triIdxA], TRI_STATE_PENDING_REMOVE) == false)
-						++nbSharedTriangles;
-					break;
-				}
-			}
-		}
+		unsigned int nbSharedTriangles = CountTrianglesAroundEdge(triIdx, a, b, true);
 		ASSERT((nbSharedTriangles == 2) || ((nbSharedTriangles == 1) && IsVertexOnOpenEdge(a) && IsVertexOnOpenEdge(b)));	//  Should be always the case on a manifold mesh
 	};
 	if(!consistencyCheckOn)
@@ -1208,21 +1807,7 @@ void Mesh::CheckVertexIsCorrect(unsigned int vtxIdx)
 				found = true;
 			else
 			{	// Test that an edge is only shared by two triangles
-				std::vector<unsigned int> const& triAroundA = _vtxToTriAround[vtxIdx];
-				std::vector<unsigned int> const& triAroundB = _vtxToTriAround[vtxsIdx[i]];
-				unsigned int nbSharedTriangles = 0;
-				for(unsigned int triIdxA : triAroundA)		// Todo : O(n), of course optimize this
-				{
-					for(unsigned int triIdxB : triAroundB)
-					{
-						if(triIdxA == triIdxB)
-						{	// triangle common to vertex A and B
-							if(TestStateFlags(_trisState[triIdxA], TRI_STATE_PENDING_REMOVE) == false)
-								++nbSharedTriangles;
-							break;
-						}
-					}
-				}
+				unsigned int nbSharedTriangles = CountTrianglesAroundEdge(triIdx, vtxIdx, vtxsIdx[i], true);
 				ASSERT((nbSharedTriangles == 2) || ((nbSharedTriangles == 1) && IsVertexOnOpenEdge(vtxIdx) && IsVertexOnOpenEdge(vtxsIdx[i])));	//  Should be always the case on a manifold mesh
 			}
 		}
@@ -1349,8 +1934,8 @@ void Mesh::Transform(Matrix3 const& rotAndScale, Vector3 const& position)
 		rotAndScale.Transform(triNrm);
 	for(BSphere& triBSphere : _trisBSphere)
 		triBSphere.Transform(rotAndScale, position);
-	if(_octreeRoot != nullptr)
-		_octreeRoot.reset(nullptr);	// Clear old octree
+	if(_octree != nullptr)
+		_octree.reset(nullptr);	// Clear old octree
 	// Compute bbox
 	BBox bbox;
 	for(Vector3 const& vertex : _vertices)
@@ -1392,7 +1977,7 @@ bool Mesh::CSGMerge(Mesh& otherMesh, Matrix3 const& rotAndScale, Vector3 const&
 	printf("Start CSG operation...\n");
 	clock_t begin = clock();
 #endif // PROFILE_INFO
-	if((_octreeRoot == nullptr) || (otherMesh._octreeRoot == nullptr))
+	if((_octree == nullptr) || (otherMesh._octree == nullptr))
 		return false;
 	// Clone othermesh because CSG/transform operation will spoil it a bit
 	Mesh otherMeshCopy(otherMesh, false, false);
@@ -1414,7 +1999,7 @@ bool Mesh::CSGSubtract(Mesh& otherMesh, Matrix3 const& rotAndScale, Vector3 cons
 	printf("Start CSG operation...\n");
 	clock_t begin = clock();
 #endif // PROFILE_INFO
-	if((_octreeRoot == nullptr) || (otherMesh._octreeRoot == nullptr))
+	if((_octree == nullptr) || (otherMesh._octree == nullptr))
 		return false;
 	// Clone othermesh because CSG/transform operation will spoil it a bit
 	Mesh otherMeshCopy(otherMesh, false, false);
@@ -1436,7 +2021,7 @@ bool Mesh::CSGIntersect(Mesh& otherMesh, Matrix3 const& rotAndScale, Vector3 con
 	printf("Start CSG operation...\n");
 	clock_t begin = clock();
 #endif // PROFILE_INFO
-	if((_octreeRoot == nullptr) || (otherMesh._octreeRoot == nullptr))
+	if((_octree == nullptr) || (otherMesh._octree == nullptr))
 		return false;
 	// Clone othermesh because CSG/transform operation will spoil it a bit
 	Mesh otherMeshCopy(otherMesh, false, false);
@@ -1574,27 +2159,18 @@ void Mesh::DetectAndTreatDegeneratedEdgeAroundVertex(unsigned int vtxToTestIdx,
 		Vector3 b = _vertices[degenEdgeVtx2];
 		Vector3 delta = b - a;
 		// Get affected triangles, this will be a merge between triangles around "a" and "b"
-		std::vector<unsigned int> const& triAroundA = GetTrianglesAroundVertex(degenEdgeVtx1);
-		std::vector<unsigned int> const& triAroundB = GetTrianglesAroundVertex(degenEdgeVtx2);
+		TriangleFan triAroundA = GetTrianglesAroundVertex(degenEdgeVtx1);
+		TriangleFan triAroundB = GetTrianglesAroundVertex(degenEdgeVtx2);
 		// Collect triangle in common between A and B
 		std::vector<unsigned int> affectedTriAroundA;
 		std::vector<unsigned int> affectedTriAroundB;
 		std::vector<unsigned int> triToRemove;
 		affectedTriAroundA.reserve(triAroundA.size());
 		affectedTriAroundB.reserve(triAroundB.size());
-		affectedTriAroundA = triAroundA;
+		affectedTriAroundA.assign(triAroundA.begin(), triAroundA.end());
 		for(unsigned int triIdxB : triAroundB)
 		{
-			bool alreadyExist = false;
-			for(unsigned int triIdxA : triAroundA)		// Todo : O(n), of course optimize this
-			{
-				if(triIdxA == triIdxB)
-				{
-					alreadyExist = true;
-					break;
-				}
-			}
-			if(alreadyExist)
+			if(TriangleHasVertex(triIdxB, degenEdgeVtx1))
 			{
 				triToRemove.push_back(triIdxB);	// Remove the triangles that both share vertices "a" and "b"
 												// Remove from affectedTri
@@ -1650,7 +2226,7 @@ void Mesh::DetectAndTreatDegeneratedEdgeAroundVertex(unsigned int vtxToTestIdx,
 		if(IsVertexToBeRemoved(degenEdgeVtx1) == false)	// The vertex could be tagged to be removed: This happens if all resulting edges and triangles were degenerated.
 			SetHasToRecomputeNormal(degenEdgeVtx1);
 	};
-	std::vector<unsigned int> const& triAround = GetTrianglesAroundVertex(vtxToTestIdx);
+	TriangleFan triAround = GetTrianglesAroundVertex(vtxToTestIdx);
 	unsigned int newVerticesBefore = (unsigned int) retNewVerticesIdx.size();
 	// Try to find degenerated edge: an edge that link more than two triangles.
 	std::map<unsigned int, unsigned int> triVerticesOccurences;
@@ -1756,7 +2332,7 @@ void Mesh::DetectAndTreatDegeneratedEdgeAroundVertex(unsigned int vtxToTestIdx,
 					if((vtxsTagIdx[i] != degenEdgeVtx1) && (vtxsTagIdx[i] != degenEdgeVtx2))	// Vertex that doesn't belong to the degenerated edge
 					{
 						// Run through triangles around the vertex 
-						std::vector<unsigned int> const& triTagAround = GetTrianglesAroundVertex(vtxsTagIdx[i]);
+						TriangleFan triTagAround = GetTrianglesAroundVertex(vtxsTagIdx[i]);
 						for(unsigned int triTagAroundIdx : triTagAround)
 						{
 							// If the triangle has one of its vertex that belong to the degenrated edge, we can select it
@@ -1796,7 +2372,7 @@ void Mesh::DetectAndTreatDegeneratedEdgeAroundVertex(unsigned int vtxToTestIdx,
 					if((vtxsTagIdx[i] != degenEdgeVtx1) && (vtxsTagIdx[i] != degenEdgeVtx2))	// Vertex that doesn't belong to the degenerated edge
 					{
 						// Run through triangles around the vertex 
-						std::vector<unsigned int> const& triTagAround = GetTrianglesAroundVertex(vtxsTagIdx[i]);
+						TriangleFan triTagAround = GetTrianglesAroundVertex(vtxsTagIdx[i]);
 						for(unsigned int triTagAroundIdx : triTagAround)
 						{
 							// If the triangle has one of its vertex that belong to the degenrated edge, we can select it
@@ -2020,7 +2596,7 @@ void Mesh::DetectAndTreatDegeneratedEdgeAroundVertex(unsigned int vtxToTestIdx,
 				if((vtxsTagIdx[i] != degenEdgeVtx1) && (vtxsTagIdx[i] != degenEdgeVtx2))	// Vertex that doesn't belong to the degenerated edge
 				{
 					// Run through triangles around the vertex 
-					std::vector<unsigned int> const& triTagAround = GetTrianglesAroundVertex(vtxsTagIdx[i]);
+					TriangleFan triTagAround = GetTrianglesAroundVertex(vtxsTagIdx[i]);
 					for(unsigned int triTagAroundIdx : triTagAround)
 					{
 						// If the triangle has one of its vertex that belong to the degenrated edge, we can select it
@@ -2060,7 +2636,7 @@ void Mesh::DetectAndTreatDegeneratedEdgeAroundVertex(unsigned int vtxToTestIdx,
 				if((vtxsTagIdx[i] != degenEdgeVtx1) && (vtxsTagIdx[i] != degenEdgeVtx2))	// Vertex that doesn't belong to the degenerated edge
 				{
 					// Run through triangles around the vertex 
-					std::vector<unsigned int> const& triTagAround = GetTrianglesAroundVertex(vtxsTagIdx[i]);
+					TriangleFan triTagAround = GetTrianglesAroundVertex(vtxsTagIdx[i]);
 					for(unsigned int triTagAroundIdx : triTagAround)
 					{
 						// If the triangle has one of its vertex that belong to the degenrated edge, we can select it
@@ -2197,7 +2773,7 @@ void Mesh::DetectAndRemoveDegeneratedTrianglesAroundVertex(unsigned int vtxToTes
 {
 	if(IsVertexToBeRemoved(vtxToTestIdx))
 		return;
-	std::vector<unsigned int> const& triAroundVertex = GetTrianglesAroundVertex(vtxToTestIdx);
+	TriangleFan triAroundVertex = GetTrianglesAroundVertex(vtxToTestIdx);
 	// Find and remove triangles that have the same vertices index
 	for(int i = 0; i < (int) triAroundVertex.size(); ++i)
 	{
@@ -2250,7 +2826,7 @@ void Mesh::DetectAndRemoveDegeneratedTrianglesAroundVertex(unsigned int vtxToTes
 				if(vtxsTagIdx[i] != vtxToTestIdx)
 				{
 					// Run through triangles around the vertex 
-					std::vector<unsigned int> const& triTagAround = GetTrianglesAroundVertex(vtxsTagIdx[i]);
+					TriangleFan triTagAround = GetTrianglesAroundVertex(vtxsTagIdx[i]);
 					for(unsigned int triTagAroundIdx : triTagAround)
 					{
 						// If the triangle has one of its vertex that is the vertex we are working on, we can select it
@@ -2314,8 +2890,8 @@ void Mesh::DetectAndRemoveDegeneratedTrianglesAroundVertex(unsigned int vtxToTes
 
 void Mesh::DetectAndRemoveDegeneratedQuadsAroundEdge(unsigned int edgeVtx1Idx, unsigned int edgeVtx2Idx)
 {	// Detect rwo quads facing one another (with nothing else around the edge), and delete it (note: will also remove 4 triangles pyramids... side effect, but usefull, so I keep it like that)
-	std::vector<unsigned int> const& triAroundVtx1 = GetTrianglesAroundVertex(edgeVtx1Idx);
-	std::vector<unsigned int> const& triAroundVtx2 = GetTrianglesAroundVertex(edgeVtx2Idx);
+	TriangleFan triAroundVtx1 = GetTrianglesAroundVertex(edgeVtx1Idx);
+	TriangleFan triAroundVtx2 = GetTrianglesAroundVertex(edgeVtx2Idx);
 	if((triAroundVtx1.size() > 4) || (triAroundVtx2.size() > 4))
 		return;
 	std::set<unsigned int> allTrianglesAround;
@@ -2351,20 +2927,7 @@ bool Mesh::CheckVertexIsClosed(unsigned int vtxIdx) // Returns true if the verte
 		{
 			if(vtxsIdx[i] != vtxIdx)
 			{	// Test that an edge is only shared by two triangles
-				std::vector<unsigned int> const& triAroundA = _vtxToTriAround[vtxIdx];
-				std::vector<unsigned int> const& triAroundB = _vtxToTriAround[vtxsIdx[i]];
-				unsigned int nbSharedTriangles = 0;
-				for(unsigned int triIdxA : triAroundA)		// Todo : O(n), of course optimize this
-				{
-					for(unsigned int triIdxB : triAroundB)
-					{
-						if(triIdxA == triIdxB)
-						{	// triangle common to vertex A and B
-							++nbSharedTriangles;
-							break;
-						}
-					}
-				}
+				unsigned int nbSharedTriangles = CountTrianglesAroundEdge(triIdx, vtxIdx, vtxsIdx[i], false);
 				if(nbSharedTriangles != 2)	//  Should be always the case on a manifold closed mesh
 					return false;
 			}
@@ -2479,11 +3042,20 @@ using namespace emscripten;
 EMSCRIPTEN_BINDINGS(Mesh)
 {
 	register_vector<BBox>("BBoxVector");
+	value_object<RayHit>("RayHit")
+		.field("hasHit", &RayHit::hasHit)
+		.field("triangle", &RayHit::triangle)
+		.field("distance", &RayHit::distance)
+		.field("point", &RayHit::point)
+		.field("normal", &RayHit::normal);
+	register_vector<Ray>("RayVector");
+	register_vector<RayHit>("RayHitVector");
 	class_<Mesh>("Mesh")
 		.function("Triangles", &Mesh::Triangles)
 		.function("Vertices", &Mesh::Vertices)
 		.function("Normals", &Mesh::Normals)
 		.function("GetClosestIntersectionPoint", &Mesh::GetClosestIntersectionPoint, allow_raw_pointers())
+		.function("IntersectRays", select_overload<void(std::vector<Ray> const&, std::vector<RayHit>&, bool)>(&Mesh::IntersectRays))
 		.function("GetFragmentsBBox", &Mesh::GetFragmentsBBox)
 		.function("GetBBox", &Mesh::GetBBox)
 		.function("IsManifold", &Mesh::IsManifold)
@@ -2497,6 +3069,17 @@ EMSCRIPTEN_BINDINGS(Mesh)
 		.function("GetSubMeshCount", &Mesh::GetSubMeshCount)
 		.function("GetSubMesh", &Mesh::GrabSubMesh, allow_raw_pointers())
 		.function("IsSubMeshExist", &Mesh::IsSubMeshExist)
-		.function("UpdateSubMeshes", &Mesh::UpdateSubMeshes);
+		.function("UpdateSubMeshes", &Mesh::UpdateSubMeshes)
+		.function("SetSubMeshesShareBuffers", &Mesh::SetSubMeshesShareBuffers)
+		.function("AreSubMeshesSharingBuffers", &Mesh::AreSubMeshesSharingBuffers)
+		.function("SetUseBVH", &Mesh::SetUseBVH)
+		.function("IsUsingBVH", &Mesh::IsUsingBVH)
+		.function("SetOctreeLooseness", &Mesh::SetOctreeLooseness)
+		.function("GetOctreeLooseness", &Mesh::GetOctreeLooseness)
+		.function("SetOctreeLeafCapacity", &Mesh::SetOctreeLeafCapacity)
+		.function("GetOctreeLeafCapacity", &Mesh::GetOctreeLeafCapacity)
+		.function("AutoTuneOctreeLeafCapacity", &Mesh::AutoTuneOctreeLeafCapacity)
+		.function("SetSubMeshesMaxVertices", &Mesh::SetSubMeshesMaxVertices)
+		.function("GetSubMeshesMaxVertices", &Mesh::GetSubMeshesMaxVertices);
 }
 #endif // __EMSCRIPTEN__
\ No newline at end of file
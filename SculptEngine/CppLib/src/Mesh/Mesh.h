@@ -10,10 +10,13 @@
 #include "Collisions\BBox.h"
 #include "Collisions\BSphere.h"
 #include "Octree.h"
+#include "TrianglesBVH.h"
+#include "TrianglesAroundVertices.h"
 #include "OctreeVisitorCollectBBox.h"
 #include "OctreeVisitorBuildAndCollectSubMeshes.h"
 #include "CSG.h"
 #include "Retessellate.h"
+#include "ScratchArena.h"
 
 #ifdef __EMSCRIPTEN__ 
 #include <emscripten/val.h>
@@ -50,6 +53,15 @@ private:
 	std::vector<OctreeCell const*> _collidedCells;
 };
 
+struct RayHit	// Mesh::IntersectRays result, for one ray
+{
+	bool hasHit;
+	unsigned int triangle;
+	float distance;
+	Vector3 point;
+	Vector3 normal;
+};
+
 class Mesh
 {
 	friend class Csg;	// Todo: try to remove the friend if possible
@@ -64,7 +76,20 @@ public:
 	void RecomputeNormals(bool forceReducedCompute, bool authorizeAutoSmooth = true);
 	void ProcessHardEdges(std::vector<unsigned int>* createdTriangles, std::vector<unsigned int>* createdVertices);
 	void ReBalanceOctree(std::vector<unsigned int> const& additionalTrisToInsert, std::vector<unsigned int> const& additionalVtxsToInsert, bool extractFromAllCells);
+	void InsertInOctree(std::vector<unsigned int> const& trisToInsert, std::vector<unsigned int> const& vtxsToInsert);	// Only adds new geometry, visible to queries right away. Extraction, empty cells purge and bboxes recompute wait for the next ReBalanceOctree
 	void HandlePendingRemovals();
+	void ReorderPerCell();	// Renumber vertices and triangles in octree leaves order (no pending removals must remain)
+	void ReorderIfFragmented();	// To call once the stroke ended: reorder if too many vertices and triangles were added or moved since last reorder
+	void SetReorderThreshold(float ratio) { _reorderThreshold = ratio; }	// Ratio of the vertices and triangles count, zero or less disables the automatic reorder
+	unsigned int GetScatteredElementsCount() const { return _nbScatteredElements; }
+	void SetOctreeLooseness(float looseness);	// Above 1, octree cells keep their triangles and vertices until they move that far out (cell size ratio), so that strokes extract less of them (see Octree)
+	float GetOctreeLooseness() const { return _octreeLooseness; }
+	unsigned int GetOctreeExtractedTrisCount() const { return _nbOctreeExtractedTris; }	// Triangles and vertices ReBalanceOctree took out of their cell since the last counters reset (brushes reset them at each stroke start)
+	unsigned int GetOctreeExtractedVtxsCount() const { return _nbOctreeExtractedVtxs; }
+	void ResetOctreeExtractionCounters() { _nbOctreeExtractedTris = 0; _nbOctreeExtractedVtxs = 0; }
+	void SetOctreeLeafCapacity(unsigned int maxTrianglesPerLeaf);	// Octree leaves granularity, for ray and range queries (the octree is rebuilt). Keep it under the sub meshes max vertices / 3, as a leaf is never split into several sub meshes
+	unsigned int GetOctreeLeafCapacity() const { return _octreeLeafCapacity; }
+	unsigned int AutoTuneOctreeLeafCapacity();	// Times ray and range queries through octrees built with several leaf capacities, keeps the fastest one and returns it
 	void TagAndCollectOpenEdgesVertices(LoopBuilder *loopBuilder);
 	bool CheckVertexIsClosed(unsigned int vtxIdx);
 #ifdef _DEBUG
@@ -75,6 +100,11 @@ public:
 	// Collision related
 	bool GetClosestIntersectionPoint(Ray const& ray, Vector3& point, Vector3* normal, bool cullBackFace);	// "normal" could be null (optional)
 	bool GetClosestIntersectionPointAndTriangle(Ray const& ray, Vector3& point, unsigned int* triangle, Vector3* normal, bool cullBackFace);	// "triangle" and "normal" could be null (optional)
+	void GetAllIntersections(Ray const& ray, bool cullBackFace, bool intersectTriToRemove, std::vector<float>& intersectionDists, std::vector<unsigned int>& intersectionTriangles);	// All hits, in no particular order
+	void IntersectRays(Ray const* rays, unsigned int nbRays, RayHit* hits, bool cullBackFace);	// Closest hit of each ray, as GetClosestIntersectionPointAndTriangle. Consecutive rays are traversed together by packets, so give coherent rays (same origin, close directions) next to each other
+	void IntersectRays(std::vector<Ray> const& rays, std::vector<RayHit>& hits, bool cullBackFace);
+	void SetUseBVH(bool useBVH);	// Ray queries go through a bounding volume hierarchy instead of the octree (the octree is still maintained for the other queries)
+	bool IsUsingBVH() const { return _bvh != nullptr; }
 
 	// Vertices related
 	std::vector<Vector3> const& GetVertices() const { return _vertices; }
@@ -89,45 +119,48 @@ public:
 		for(unsigned int triIdx : _vtxToTriAround[vertexIndex])
 			ASSERT(triIdx != triangleIndex);	// Verify the triangle index we add doesn't already exist
 #endif // _DEBUG
-		_vtxToTriAround[vertexIndex].push_back(triangleIndex);
+		_vtxToTriAround.Add(vertexIndex, triangleIndex);
+		SetTriangleTwinToUpdate(triangleIndex);
 	}
 
 	void ChangeTriangleAroundVertex(unsigned int vertexIndex, unsigned int oldTtriangleIndex, unsigned int newTtriangleIndex)
 	{
 		// Todo: build a map or something to prevent the for loop
-		for(unsigned int& tri : _vtxToTriAround[vertexIndex])
+		if(_vtxToTriAround.Change(vertexIndex, oldTtriangleIndex, newTtriangleIndex))
 		{
-			if(tri == oldTtriangleIndex)
-			{
-				tri = newTtriangleIndex;
-				return;
-			}
+			SetTriangleTwinToUpdate(oldTtriangleIndex);
+			SetTriangleTwinToUpdate(newTtriangleIndex);
+			return;
 		}
 		ASSERT(false);	// Means we didn't find oldTtriangleIndex 
 	}
 	void RemoveTriangleAroundVertex(unsigned int vertexIndex, unsigned int triangleIndex)
 	{
 		// Todo: build a map or something to prevent the for loop
-		for(unsigned int& tri : _vtxToTriAround[vertexIndex])
+		if(_vtxToTriAround.Remove(vertexIndex, triangleIndex))
 		{
-			if(tri == triangleIndex)
-			{
-				tri = _vtxToTriAround[vertexIndex].back();
-				_vtxToTriAround[vertexIndex].pop_back();
-				ASSERT((_vtxToTriAround[vertexIndex].empty() == false) || TestStateFlags(_vtxsState[vertexIndex], VTX_STATE_PENDING_REMOVE));
-				return;
-			}
+			SetTriangleTwinToUpdate(triangleIndex);
+			ASSERT((_vtxToTriAround[vertexIndex].empty() == false) || TestStateFlags(_vtxsState[vertexIndex], VTX_STATE_PENDING_REMOVE));
+			return;
 		}
 		ASSERT(TestStateFlags(_vtxsState[vertexIndex], VTX_STATE_PENDING_REMOVE));	// We get there if we didn't find triangleIndex in _vtxToTriAround
 	}
-	std::vector<unsigned int> const& GetTrianglesAroundVertex(unsigned int vertexIndex) const { return _vtxToTriAround[vertexIndex]; }
+	TriangleFan GetTrianglesAroundVertex(unsigned int vertexIndex) const { return _vtxToTriAround[vertexIndex]; }
+	size_t GetTrianglesAroundVerticesMemoryUsage() const { return _vtxToTriAround.GetMemoryUsage(); }
 
-	void ClearTriangleAroundVertex(unsigned int vertexIndex) { _vtxToTriAround[vertexIndex].clear(); }
+	void ClearTriangleAroundVertex(unsigned int vertexIndex)
+	{
+		for(unsigned int triIdx : _vtxToTriAround[vertexIndex])
+			SetTriangleTwinToUpdate(triIdx);
+		_vtxToTriAround.ClearVertex(vertexIndex);
+	}
 
 	void SetHasToRecomputeNormal(unsigned int vertexIndex);
+	void SetHasToRecomputeNormals(std::vector<unsigned int> const& vtxsIdx);	// Same as calling SetHasToRecomputeNormal on each, the surrounding triangles being collected by several threads for large lists
 
 	unsigned int AddVertex(Vector3 const& newVertex)
 	{
+		++_nbScatteredElements;	// Out of its cell vertices range
 #ifndef CLEAN_PENDING_REMOVALS_IMMEDIATELY
 		if(_vtxsIdxToRecycle.empty() == false)
 		{	// We recycle
@@ -135,7 +168,7 @@ public:
 			_vtxsIdxToRecycle.pop_back();
 			ASSERT(TestStateFlags(_vtxsState[recycledVtxId], VTX_STATE_PENDING_REMOVE));
 			_vertices[recycledVtxId] = newVertex;
-			_vtxToTriAround[recycledVtxId].clear();
+			ClearTriangleAroundVertex(recycledVtxId);
 			_vtxsNormal[recycledVtxId].ResetToZero();
 			_vtxsState[recycledVtxId] = 0;
 			_vtxsNewIdx[recycledVtxId] = UNDEFINED_NEW_ID;
@@ -146,7 +179,7 @@ public:
 #endif // !CLEAN_PENDING_REMOVALS_IMMEDIATELY
 			unsigned int nbVtx = (unsigned int) _vertices.size();
 			_vertices.push_back(newVertex);
-			_vtxToTriAround.resize(nbVtx + 1);
+			_vtxToTriAround.AddVertex();
 			_vtxsNormal.resize(nbVtx + 1);
 			_vtxsState.resize(nbVtx + 1);
 			_vtxsNewIdx.push_back(UNDEFINED_NEW_ID);
@@ -175,7 +208,21 @@ public:
 	void ClearAllVerticesInStitchingZone() { for(unsigned char& vtxState : _vtxsState) ClearStateFlags(vtxState, VTX_STATE_IS_IN_STITCHING_ZONE); }
 
 	bool IsVertexToUpdateInSubMesh(unsigned int vtxId) const { return TestStateFlags(_vtxsState[vtxId], VTX_STATE_HAS_TO_RECOMPUTE_SUB_MESH); }
-	void ClearAllVerticesToUpdateInSubMesh() { for(unsigned char& vtxState : _vtxsState) ClearStateFlags(vtxState, VTX_STATE_HAS_TO_RECOMPUTE_SUB_MESH); }
+	void SetVertexToUpdateInSubMesh(unsigned int vtxId)
+	{
+		unsigned char& vtxState = _vtxsState[vtxId];
+		if(!TestStateFlags(vtxState, VTX_STATE_HAS_TO_RECOMPUTE_SUB_MESH))
+		{
+			AddStateFlags(vtxState, VTX_STATE_HAS_TO_RECOMPUTE_SUB_MESH);
+			_vtxsIdxToUpdateInSubMesh.push_back(vtxId);
+		}
+	}
+	void ClearAllVerticesToUpdateInSubMesh()
+	{
+		for(unsigned int vtxIdx : _vtxsIdxToUpdateInSubMesh)
+			ClearStateFlags(_vtxsState[vtxIdx], VTX_STATE_HAS_TO_RECOMPUTE_SUB_MESH);
+		_vtxsIdxToUpdateInSubMesh.clear();
+	}
 
 	bool IsVertexAlreadyTreated(unsigned int vtxId) const { return TestStateFlags(_vtxsState[vtxId], VTX_STATE_ALREADY_TREATED); }
 	void SetVertexAlreadyTreated(unsigned int vtxId) { AddStateFlags(_vtxsState[vtxId], VTX_STATE_ALREADY_TREATED); }
@@ -216,6 +263,7 @@ public:
 
 	unsigned int AddTriangle(unsigned int vtx1, unsigned int vtx2, unsigned int vtx3, Vector3 const& normal, bool computeBSphere)
 	{
+		++_nbScatteredElements;	// Out of its cell triangles range
 #ifndef CLEAN_PENDING_REMOVALS_IMMEDIATELY
 		if(_trisIdxToRecycle.empty() == false)
 		{	// We recycle
@@ -233,6 +281,8 @@ public:
 				_trisBSphere[recycledTriId] = BSphere();
 			_trisState[recycledTriId] = 0;
 			_trisNewIdx[recycledTriId] = UNDEFINED_NEW_ID;
+			ResetTrisTwin(recycledTriId);
+			_trisOctreeCell[recycledTriId] = UNDEFINED_CELL_IDX;
 			return recycledTriId;
 		}
 		else
@@ -249,6 +299,8 @@ public:
 				_trisBSphere.push_back(BSphere());
 			_trisState.push_back(0);
 			_trisNewIdx.push_back(UNDEFINED_NEW_ID);
+			_trisTwin.insert(_trisTwin.end(), 3, nbTri);	// Not linked yet, alone around its edges
+			_trisOctreeCell.push_back(UNDEFINED_CELL_IDX);
 			return nbTri;
 #ifndef CLEAN_PENDING_REMOVALS_IMMEDIATELY
 		}
@@ -275,6 +327,12 @@ public:
 #endif // !CLEAN_PENDING_REMOVALS_IMMEDIATELY
 	}
 
+	bool TriangleHasVertex(unsigned int triIdx, unsigned int vtxIdx) const
+	{
+		unsigned int const* vtxsIdx = &(_triangles[triIdx * 3]);
+		return (vtxsIdx[0] == vtxIdx) || (vtxsIdx[1] == vtxIdx) || (vtxsIdx[2] == vtxIdx);
+	}
+
 	bool RemoveFlatTriangle(unsigned int triIdx);	// Returns true if the triangle was removed
 	void RemoveFlatTriangles() { for(unsigned int triIdx = 0; triIdx < _trisState.size(); ++triIdx) RemoveFlatTriangle(triIdx); }
 	void DeleteTriangle(unsigned int triIdx);
@@ -292,6 +350,12 @@ public:
 	void ClearTriangleRetessellationBan(unsigned int triId) { ClearStateFlags(_trisState[triId], TRI_STATE_DONT_RETESSELATE); }
 	void ClearAllTriangleRetessellationBan() { for(unsigned char& triState : _trisState) ClearStateFlags(triState, TRI_STATE_DONT_RETESSELATE); }
 
+	// Edges related (an edge is given by its two vertices and one of the triangles around it, walked through the twin table)
+	unsigned int GetTriangleAcrossEdge(unsigned int triIdx, unsigned int edgeVtx1, unsigned int edgeVtx2);	// First other triangle (not to be removed) sharing the edge, UNDEFINED_NEW_ID if the edge is open
+	bool IsEdgeOpen(unsigned int triIdx, unsigned int edgeVtx1, unsigned int edgeVtx2) { return GetTriangleAcrossEdge(triIdx, edgeVtx1, edgeVtx2) == UNDEFINED_NEW_ID; }
+	void GetTrianglesAroundEdge(unsigned int triIdx, unsigned int edgeVtx1, unsigned int edgeVtx2, std::vector<unsigned int>& triangles);	// Starting with triIdx, triangles to be removed included
+	unsigned int CountTrianglesAroundEdge(unsigned int triIdx, unsigned int edgeVtx1, unsigned int edgeVtx2, bool skipTrianglesToBeRemoved);
+
 	// Vertices and triangles related
 #ifndef CLEAN_PENDING_REMOVALS_IMMEDIATELY
 	void TransferPendingRemovesToRecycle()
@@ -307,23 +371,29 @@ public:
 	BBox const& GetBBox() const;
 
 	void RecomputeFragmentsBBox(bool forceAllCellRecomputing);
+	void ShrinkFragmentsBBox();	// Content bboxes grown while moving vertices get back to their exact size (called at stroke end)
 
 	std::vector<BBox> GetFragmentsBBox()
 	{
 		VisitorCollectBBox collectBbox;
-		_octreeRoot->Traverse(collectBbox);
+		GrabOctreeRoot().Traverse(collectBbox);
 		return std::move(collectBbox.GetBBoxes());
 	}
 
 	// Octree related
-	OctreeCell& GrabOctreeRoot() { ASSERT(_octreeRoot.get() != nullptr); return *(_octreeRoot.get()); }
+	OctreeCell& GrabOctreeRoot() { ASSERT(_octree.get() != nullptr); return _octree->GrabRoot(); }
+	void SetTriangleOctreeCell(unsigned int triIdx, unsigned int cellIdx) { _trisOctreeCell[triIdx] = cellIdx; }	// Called by the octree when a triangle lands in a leaf
 
 	// Submesh related
 	unsigned int GetSubMeshCount() { return GrabSubMeshesVisitor().GetSubMeshCount(); }
 	SubMesh const* GetSubMesh(unsigned int index) { return GrabSubMeshesVisitor().GetSubMesh(index); }
 	SubMesh* GrabSubMesh(unsigned int index) { return GrabSubMeshesVisitor().GrabSubMesh(index); }
 	bool IsSubMeshExist(unsigned int subMeshID) { return GrabSubMeshesVisitor().IsSubMeshExist(subMeshID); }
-	void UpdateSubMeshes() { GrabOctreeRoot().Traverse(GrabSubMeshesVisitor()); }
+	void UpdateSubMeshes();
+	void SetSubMeshesShareBuffers(bool shareBuffers);	// Sub meshes become windows into our vertices and normals buffers instead of holding a copy of them
+	void SetSubMeshesMaxVertices(unsigned int maxVertices) { GrabSubMeshesVisitor().SetMaxVertices(maxVertices); }	// Sub meshes gather octree leaves up to that many vertices (keep it under 65536 for 16 bits indices), zero for one sub mesh per leaf
+	unsigned int GetSubMeshesMaxVertices() { return GrabSubMeshesVisitor().GetMaxVertices(); }
+	bool AreSubMeshesSharingBuffers() { return GrabSubMeshesVisitor().IsSharingFullMeshBuffers(); }
 
 	// Undo/redo related
 	bool CanUndo();
@@ -354,6 +424,9 @@ public:
 		return *_retessellator;
 	}
 
+	// Temporaries related
+	ScratchArena& GrabScratchArena() const { return _scratchArena; }	// Available from const queries too, the buffers are not part of the mesh state
+
 #ifdef __EMSCRIPTEN__ 
 	emscripten::val Triangles() { return emscripten::val(emscripten::typed_memory_view(_triangles.size() * sizeof(int), (char const *) _triangles.data())); }
 	emscripten::val Vertices() { return emscripten::val(emscripten::typed_memory_view(_vertices.size() * sizeof(Vector3), (char const *) _vertices.data())); }
@@ -364,7 +437,7 @@ private:
 	enum VTX_STATE_FLAGS: unsigned char
 	{
 		VTX_STATE_HAS_TO_RECOMPUTE_NORMAL = 1,
-		VTX_STATE_ALREADY_TREATED = VTX_STATE_HAS_TO_RECOMPUTE_NORMAL << 1,	// used for example in "VisitorBuildAndCollectSubMeshes"
+		VTX_STATE_ALREADY_TREATED = VTX_STATE_HAS_TO_RECOMPUTE_NORMAL << 1,	// used for example in "ProcessHardEdges"
 		VTX_STATE_PENDING_REMOVE = VTX_STATE_ALREADY_TREATED << 1,
 		VTX_STATE_HAS_TO_RECOMPUTE_SUB_MESH = VTX_STATE_PENDING_REMOVE << 1,
 		VTX_STATE_IS_ON_OPEN_EDGE = VTX_STATE_HAS_TO_RECOMPUTE_SUB_MESH << 1,
@@ -376,7 +449,8 @@ private:
 		TRI_STATE_HAS_TO_RECOMPUTE_NORMAL = 1,
 		TRI_STATE_PENDING_REMOVE = TRI_STATE_HAS_TO_RECOMPUTE_NORMAL << 1,
 		TRI_STATE_ALREADY_TREATED = TRI_STATE_PENDING_REMOVE << 1,
-		TRI_STATE_DONT_RETESSELATE = TRI_STATE_ALREADY_TREATED << 1
+		TRI_STATE_DONT_RETESSELATE = TRI_STATE_ALREADY_TREATED << 1,
+		TRI_STATE_HAS_TO_UPDATE_TWIN = TRI_STATE_DONT_RETESSELATE << 1
 	};
 
 	// State flag related
@@ -384,9 +458,34 @@ private:
 	void ClearStateFlags(unsigned char& state, unsigned char flags) { state &= ~flags; }
 	bool TestStateFlags(unsigned char const& state, unsigned char flags) const { return (state & flags) != 0; }
 
+	// Edges related
+	unsigned int GetEdgeNumber(unsigned int triIdx, unsigned int edgeVtx1, unsigned int edgeVtx2) const;	// Edge n goes from the triangle's vertex n to vertex (n + 1) % 3, 3 if not an edge of the triangle
+	unsigned int GetNextTriangleAroundEdge(unsigned int triIdx, unsigned int edgeVtx1, unsigned int edgeVtx2) const;	// UNDEFINED_NEW_ID if triIdx doesn't have the edge
+	void AddTriangleTwinToUpdate(unsigned int triIdx)
+	{
+		if(!TestStateFlags(_trisState[triIdx], TRI_STATE_HAS_TO_UPDATE_TWIN))
+		{
+			AddStateFlags(_trisState[triIdx], TRI_STATE_HAS_TO_UPDATE_TWIN);
+			_trisIdxToUpdateTwin.push_back(triIdx);
+		}
+	}
+	void SetTriangleTwinToUpdate(unsigned int triIdx)
+	{	// The triangle joins or leaves an edge: relink it, and its current twins for the edges it leaves
+		AddTriangleTwinToUpdate(triIdx);
+		for(unsigned int i = 0; i < 3; ++i)
+			AddTriangleTwinToUpdate(_trisTwin[triIdx * 3 + i]);
+	}
+	void ResetTrisTwin(unsigned int triIdx) { for(unsigned int i = 0; i < 3; ++i) _trisTwin[triIdx * 3 + i] = triIdx; }
+	void LinkTrianglesAroundEdge(unsigned int triIdx, unsigned int edgeVtx1, unsigned int edgeVtx2);
+	void UpdateTrisTwin();
+	void BuildTrisTwin();
+
 	// Mesh related
 	void WeldVertices(std::vector<unsigned int> const& triIn, std::vector<Vector3> const& vtxsIn, std::vector<unsigned int>& triOut, std::vector<Vector3>& vtxsOut);
 	void RebuildMeshData(bool rescale, bool recenter, bool buildHardEdges);
+
+	// Collision related
+	bool GetClosestIntersection(Ray const& ray, bool cullBackFace, unsigned int& closestTriangle, float& closestDist);	// Octree or BVH traversal
 #ifdef MESH_CONSISTENCY_CHECK
 	public:
 	void CheckTriangleIsCorrect(unsigned int triIdx, bool testFlateness);
@@ -398,6 +497,7 @@ public:
 	// Octree related
 	void BuildOctree(BBox bbox);
 private:
+	void GrowCellsContentBBox(std::vector<unsigned int> const& vtxsIdx);	// Cells holding the triangles around the moved vertices grow to hold them
 	// Sub meshes related
 	VisitorBuildAndCollectSubMeshes& GrabSubMeshesVisitor()
 	{
@@ -417,13 +517,16 @@ private:
 	std::vector<unsigned char> _vtxsState;	// See VTX_STATE_FLAGS
 	std::vector<unsigned int> _vtxsNewIdx;	// Store the new index "to be" of the vertex as it will be moved somewhere else
 	std::vector<Vector3> _vtxsNormal;
-	std::vector<std::vector<unsigned int> > _vtxToTriAround;	// For each vertex, tells the triangles around it
+	TrianglesAroundVertices _vtxToTriAround;	// For each vertex, tells the triangles around it
 	// Triangles related
 	std::vector<unsigned int> _triangles;	// 3 int per triangle (3 vertex index)
 	std::vector<unsigned char> _trisState;	// See TRI_STATE_FLAGS
 	std::vector<unsigned int> _trisNewIdx;	// Store the new index "to be" of the triangle as it will be moved somewhere else
 	std::vector<Vector3> _trisNormal;
 	std::vector<BSphere> _trisBSphere;	// For fast triangle distance pre-tests
+	std::vector<unsigned int> _trisTwin;	// 3 per triangle: next triangle around each edge, the triangles sharing an edge form a ring (itself on an open edge)
+	std::vector<unsigned int> _trisIdxToUpdateTwin;	// Triangles whose edges changed since the last UpdateTrisTwin, relinked from the vertex fans on the next edge query
+	std::vector<unsigned int> _trisOctreeCell;	// Index of the octree leaf holding the triangle, to find the sub meshes a modified vertex belongs to
 	// Reduced recompute normal related
 	std::vector<unsigned int> _vtxsIdxToRecomputeNormalOn;
 	std::vector<unsigned int> _trisIdxToRecomputeNormalOn;
@@ -435,9 +538,18 @@ private:
 	std::vector<unsigned int> _trisIdxToRecycle;
 #endif // !CLEAN_PENDING_REMOVALS_IMMEDIATELY
 	// Octree related
-	std::unique_ptr<OctreeCell> _octreeRoot;
+	std::unique_ptr<Octree> _octree;
+	float _octreeLooseness;
+	unsigned int _octreeLeafCapacity;
+	unsigned int _nbOctreeExtractedTris;
+	unsigned int _nbOctreeExtractedVtxs;
+	std::unique_ptr<TrianglesBVH> _bvh;	// Optional, null if not used
 	// Sub meshes related (this is for the moment only used to inject a split mesh into unity (due to its limit at 64K vertices per mesh))
 	std::unique_ptr<VisitorBuildAndCollectSubMeshes> _subMeshesVisitor;
+	std::vector<unsigned int> _vtxsIdxToUpdateInSubMesh;	// Vertices flagged VTX_STATE_HAS_TO_RECOMPUTE_SUB_MESH
+	// Memory layout related
+	unsigned int _nbScatteredElements;	// Vertices and triangles added or moved since the last reorder, they break the octree leaves order
+	float _reorderThreshold;
 	// ID
 	int _id;
 	// Debug
@@ -451,6 +563,8 @@ private:
 	bool _IsManifold;
 	// Retessalate related
 	std::unique_ptr<Retessellate> _retessellator;
+	// Temporaries related
+	mutable ScratchArena _scratchArena;	// Brushes and visitors temporary buffers, given back at the end of each dab and reset at stroke end
 };
 
 #endif // _MESH_H_
\ No newline at end of file
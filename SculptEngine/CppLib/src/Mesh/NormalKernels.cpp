@@ -0,0 +1,101 @@
+﻿#include "NormalKernels.h"
+
+namespace
+{
+	template <class S>
+	void ComputeTrianglesNormalAndBSphereT(TrisNormalJob const& job, unsigned int begin, unsigned int end)
+	{
+		typedef typename S::Float Float;
+		const unsigned int W = S::Width;
+		// Triangles are gathered "Width" by "Width" into aligned SoA lanes (the last block being padded with its first triangle)
+		alignas(32) float laneIn[9][W];	// x1, y1, z1, x2, y2, z2, x3, y3, z3
+		alignas(32) float laneOut[7][W];	// normal x, y, z, center x, y, z, radius
+		unsigned int lanesTriIdx[W];
+		Float const third = S::Set1(3.0f);
+		Float const orientation = S::Set1(job.invertOrientation ? -1.0f : 1.0f);
+		for(unsigned int blockStart = begin; blockStart < end; blockStart += W)
+		{
+			unsigned int nbLanes = min(W, end - blockStart);
+			for(unsigned int lane = 0; lane < W; ++lane)
+			{
+				unsigned int jobIdx = blockStart + ((lane < nbLanes) ? lane : 0);
+				unsigned int triIdx = (job.trisIdx != nullptr) ? job.trisIdx[jobIdx] : jobIdx;
+				lanesTriIdx[lane] = triIdx;
+				unsigned int const* vtxsIdx = &(job.triangles[triIdx * 3]);
+				for(unsigned int k = 0; k < 3; ++k)
+				{
+					Vector3 const& vtx = job.vertices[vtxsIdx[k]];
+					laneIn[k * 3][lane] = vtx.x;
+					laneIn[k * 3 + 1][lane] = vtx.y;
+					laneIn[k * 3 + 2][lane] = vtx.z;
+				}
+			}
+			Float x1 = S::Load(laneIn[0]), y1 = S::Load(laneIn[1]), z1 = S::Load(laneIn[2]);
+			Float x2 = S::Load(laneIn[3]), y2 = S::Load(laneIn[4]), z2 = S::Load(laneIn[5]);
+			Float x3 = S::Load(laneIn[6]), y3 = S::Load(laneIn[7]), z3 = S::Load(laneIn[8]);
+			// Normal: (p2 - p1) cross (p3 - p1), normalized then flipped if orientation is inverted
+			Float p1p2x = S::Sub(x2, x1), p1p2y = S::Sub(y2, y1), p1p2z = S::Sub(z2, z1);
+			Float p1p3x = S::Sub(x3, x1), p1p3y = S::Sub(y3, y1), p1p3z = S::Sub(z3, z1);
+			Float nx = S::Sub(S::Mul(p1p2y, p1p3z), S::Mul(p1p2z, p1p3y));
+			Float ny = S::Sub(S::Mul(p1p2z, p1p3x), S::Mul(p1p2x, p1p3z));
+			Float nz = S::Sub(S::Mul(p1p2x, p1p3y), S::Mul(p1p2y, p1p3x));
+			Float length = S::Sqrt(S::Add(S::Add(S::Mul(nx, nx), S::Mul(ny, ny)), S::Mul(nz, nz)));
+			nx = S::SelectIfNotZero(length, S::Mul(S::Div(nx, length), orientation), nx);
+			ny = S::SelectIfNotZero(length, S::Mul(S::Div(ny, length), orientation), ny);
+			nz = S::SelectIfNotZero(length, S::Mul(S::Div(nz, length), orientation), nz);
+			// Bounding sphere: centered on centroid, radius reaching the farthest vertex
+			Float cx = S::Div(S::Add(S::Add(x1, x2), x3), third);
+			Float cy = S::Div(S::Add(S::Add(y1, y2), y3), third);
+			Float cz = S::Div(S::Add(S::Add(z1, z2), z3), third);
+			Float dx = S::Sub(x1, cx), dy = S::Sub(y1, cy), dz = S::Sub(z1, cz);
+			Float squareDist1 = S::Add(S::Add(S::Mul(dx, dx), S::Mul(dy, dy)), S::Mul(dz, dz));
+			dx = S::Sub(x2, cx); dy = S::Sub(y2, cy); dz = S::Sub(z2, cz);
+			Float squareDist2 = S::Add(S::Add(S::Mul(dx, dx), S::Mul(dy, dy)), S::Mul(dz, dz));
+			dx = S::Sub(x3, cx); dy = S::Sub(y3, cy); dz = S::Sub(z3, cz);
+			Float squareDist3 = S::Add(S::Add(S::Mul(dx, dx), S::Mul(dy, dy)), S::Mul(dz, dz));
+			Float radius = S::Sqrt(S::Max(S::Max(squareDist1, squareDist2), squareDist3));
+			S::Store(laneOut[0], nx); S::Store(laneOut[1], ny); S::Store(laneOut[2], nz);
+			S::Store(laneOut[3], cx); S::Store(laneOut[4], cy); S::Store(laneOut[5], cz);
+			S::Store(laneOut[6], radius);
+			for(unsigned int lane = 0; lane < nbLanes; ++lane)
+			{
+				unsigned int triIdx = lanesTriIdx[lane];
+				job.trisNormal[triIdx] = Vector3(laneOut[0][lane], laneOut[1][lane], laneOut[2][lane]);
+				job.trisBSphere[triIdx] = BSphere(Vector3(laneOut[3][lane], laneOut[4][lane], laneOut[5][lane]), laneOut[6][lane]);
+			}
+		}
+	}
+}
+
+void ComputeTrianglesNormalAndBSphere(TrisNormalJob const& job, unsigned int begin, unsigned int end)
+{
+	ASSERT(end <= job.nbTris);
+	switch(GetSimdKernelType())
+	{
+#ifdef SIMD_AVX
+	case SIMD_KERNEL_AVX: ComputeTrianglesNormalAndBSphereT<SimdAVX>(job, begin, end); break;
+#endif // SIMD_AVX
+#ifdef SIMD_SSE
+	case SIMD_KERNEL_SSE: ComputeTrianglesNormalAndBSphereT<SimdSSE>(job, begin, end); break;
+#endif // SIMD_SSE
+#ifdef SIMD_NEON
+	case SIMD_KERNEL_NEON: ComputeTrianglesNormalAndBSphereT<SimdNEON>(job, begin, end); break;
+#endif // SIMD_NEON
+#ifdef SIMD_WASM
+	case SIMD_KERNEL_WASM: ComputeTrianglesNormalAndBSphereT<SimdWasm>(job, begin, end); break;
+#endif // SIMD_WASM
+	default: ComputeTrianglesNormalAndBSphereT<SimdScalar>(job, begin, end); break;
+	}
+}
+
+void ComputeTrianglesNormalAndBSphere(TrisNormalJob const& job)
+{
+	const int blockSize = 1024;	// Triangles per thread task
+	int nbBlocks = int((job.nbTris + blockSize - 1) / blockSize);
+#pragma omp parallel for
+	for(int block = 0; block < nbBlocks; ++block)
+	{
+		unsigned int begin = (unsigned int) block * blockSize;
+		ComputeTrianglesNormalAndBSphere(job, begin, min(begin + blockSize, job.nbTris));
+	}
+}
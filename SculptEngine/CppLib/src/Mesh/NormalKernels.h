@@ -0,0 +1,24 @@
+﻿#ifndef _NORMAL_KERNELS_H_
+#define _NORMAL_KERNELS_H_
+
+#include "Math\Vector.h"
+#include "Math\SimdTraits.h"
+#include "Collisions\BSphere.h"
+
+// Vectorized (SSE/AVX/NEON/wasm-simd, with a scalar fallback) computing of triangles normal and bounding sphere.
+// The SIMD kernels do exactly the same IEEE operations as the scalar one (no fused multiply-add, real divisions), so results match the scalar path.
+struct TrisNormalJob
+{
+	Vector3 const* vertices;
+	unsigned int const* triangles;	// 3 vertex index per triangle
+	unsigned int const* trisIdx;	// Triangles to treat, if null the triangles [0, nbTris[ are treated
+	unsigned int nbTris;
+	bool invertOrientation;
+	Vector3* trisNormal;
+	BSphere* trisBSphere;
+};
+
+void ComputeTrianglesNormalAndBSphere(TrisNormalJob const& job);	// Multithreaded over blocks of triangles
+void ComputeTrianglesNormalAndBSphere(TrisNormalJob const& job, unsigned int begin, unsigned int end);	// Treats [begin, end[ of the job, on the calling thread
+
+#endif // _NORMAL_KERNELS_H_
@@ -1,89 +1,339 @@
 ﻿#include "Octree.h"
 #include "Mesh.h"
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif // _OPENMP
 
-const unsigned int maxTrianglesPerCell = 1000;
+const unsigned int minCellsForParallelTraverse = 16;	// Below that, thread startup costs more than what we gain
+const unsigned int cellsPerTraverseBlock = 4;	// Unit of work handed to a thread by ParallelTraverse
+const float minCellSizeRatio = 1.0f / 65536.0f;	// Of the root cell size, cells are not subdivided below that (16 levels)
+const unsigned int bulkInsertMaxDepth = 16;	// Depth of the Morton codes computed by BulkInsert (see minCellSizeRatio)
 unsigned int OctreeCell::_idGen = 0;
 
-OctreeCell::OctreeCell(OctreeCell const& otherCell, OctreeCell* parent):
-	_parent(parent),
-	_trianglesIdx(otherCell._trianglesIdx),
-	_verticesIdx(otherCell._verticesIdx),
-	_BBox(otherCell._BBox),
-	_contentBBox(otherCell._contentBBox),
-	_id(otherCell._id),
-	_stateFlags(otherCell._stateFlags)
+namespace
 {
-	_children.resize(otherCell._children.size());
-	unsigned int i = 0;
-	for(std::unique_ptr<OctreeCell> const& otherCellChild : otherCell._children)
+	// Point placing a triangle in the cells: its first vertex in a strict octree, its centroid in a loose one (so that it can move in any direction before leaving the cell loose bounds)
+	inline Vector3 GetTriangleAnchor(std::vector<Vector3> const& vertices, std::vector<unsigned int> const& triangles, unsigned int triIdx, bool loose)
 	{
-		if(otherCellChild != nullptr)
-			_children[i++].reset(new OctreeCell(*otherCellChild, this));
+		unsigned int const* triVtxs = &triangles[triIdx * 3];
+		if(!loose)
+			return vertices[triVtxs[0]];
+		return (vertices[triVtxs[0]] + vertices[triVtxs[1]] + vertices[triVtxs[2]]) / 3.0f;
 	}
+
+	unsigned int GetClosestSubCellPos(BBox const (&subCellsBBox)[8], Vector3 const& point)
+	{
+		unsigned int closestPos = 0;
+		float closestDistSquared = FLT_MAX;
+		for(unsigned int pos = 0; pos < 8; ++pos)
+		{
+			float distSquared = subCellsBBox[pos].Center().DistanceSquared(point);
+			if(distSquared < closestDistSquared)
+			{
+				closestPos = pos;
+				closestDistSquared = distSquared;
+			}
+		}
+		return closestPos;
+	}
+
+	// Bounds of the cells along one axis at bulkInsertMaxDepth, from the same float operations as BBox::Center and GetSubCellsBBox, so they are the exact sub cells bounds
+	void BuildCellsBounds(float* bounds, unsigned int lowIdx, unsigned int highIdx)
+	{
+		unsigned int middleIdx = (lowIdx + highIdx) / 2;
+		if(middleIdx == lowIdx)
+			return;
+		bounds[middleIdx] = (bounds[highIdx] + bounds[lowIdx]) / 2.0f;
+		BuildCellsBounds(bounds, lowIdx, middleIdx);
+		BuildCellsBounds(bounds, middleIdx, highIdx);
+	}
+
+	// Cell coordinate along one axis at bulkInsertMaxDepth: a guess from the regular grid, fixed with the actual bounds (then at each depth, the coordinate bit tells if the value is >= to the cell center, as BBox::Contains does)
+	inline unsigned int GetCellCoord(float value, float const* bounds, float invCellSize)
+	{
+		unsigned int const maxCoord = (1 << bulkInsertMaxDepth) - 1;
+		float guess = (value - bounds[0]) * invCellSize;
+		unsigned int coord = (guess > 0.0f) ? (unsigned int) min(guess, (float) maxCoord) : 0;
+		while((coord > 0) && (value < bounds[coord]))
+			--coord;
+		while((coord < maxCoord) && (value >= bounds[coord + 1]))
+			++coord;
+		return coord;
+	}
+
+	inline unsigned long long SpreadBits(unsigned int coord)
+	{	// Insert two zero bits between each of the 16 bits
+		unsigned long long bits = coord & 0xFFFF;
+		bits = (bits | (bits << 16)) & 0x0000FF0000FFull;
+		bits = (bits | (bits << 8)) & 0x00F00F00F00Full;
+		bits = (bits | (bits << 4)) & 0x0C30C30C30C3ull;
+		bits = (bits | (bits << 2)) & 0x249249249249ull;
+		return bits;
+	}
+
+	class MortonCoder
+	{
+	public:
+		MortonCoder(BBox const& rootBBox)
+		{
+			SetupAxis(0, rootBBox.Min().x, rootBBox.Max().x);
+			SetupAxis(1, rootBBox.Min().y, rootBBox.Max().y);
+			SetupAxis(2, rootBBox.Min().z, rootBBox.Max().z);
+		}
+
+		// Octant at each depth (x | y << 1 | z << 2), the root one in the most significant bits
+		unsigned long long GetCode(Vector3 const& point) const
+		{
+			return SpreadBits(GetCellCoord(point.x, _bounds[0].data(), _invCellSize[0]))
+				| (SpreadBits(GetCellCoord(point.y, _bounds[1].data(), _invCellSize[1])) << 1)
+				| (SpreadBits(GetCellCoord(point.z, _bounds[2].data(), _invCellSize[2])) << 2);
+		}
+
+	private:
+		void SetupAxis(unsigned int axis, float min, float max)
+		{
+			unsigned int const nbCells = 1 << bulkInsertMaxDepth;
+			_bounds[axis].resize(nbCells + 1);
+			_bounds[axis][0] = min;
+			_bounds[axis][nbCells] = max;
+			BuildCellsBounds(_bounds[axis].data(), 0, nbCells);
+			_invCellSize[axis] = float(nbCells) / (max - min);
+		}
+
+		std::vector<float> _bounds[3];
+		float _invCellSize[3];
+	};
+
+	// Least significant digit first radix sort
+	void SortByMortonCode(std::vector<unsigned long long>& codes, std::vector<unsigned int>& idxs)
+	{
+		const unsigned int digitBits = 12;
+		std::vector<unsigned long long> sortedCodes(codes.size());
+		std::vector<unsigned int> sortedIdxs(idxs.size());
+		std::vector<unsigned int> digitOffsets(1 << digitBits);
+		for(unsigned int shift = 0; shift < bulkInsertMaxDepth * 3; shift += digitBits)
+		{
+			std::fill(digitOffsets.begin(), digitOffsets.end(), 0);
+			for(unsigned long long code : codes)
+				++digitOffsets[(code >> shift) & ((1 << digitBits) - 1)];
+			if(codes.empty() || (digitOffsets[(codes[0] >> shift) & ((1 << digitBits) - 1)] == codes.size()))
+				continue;	// Same digit for all, nothing to reorder
+			unsigned int offset = 0;
+			for(unsigned int& digitOffset : digitOffsets)
+			{
+				unsigned int digitCount = digitOffset;
+				digitOffset = offset;
+				offset += digitCount;
+			}
+			for(size_t i = 0; i < codes.size(); ++i)
+			{
+				unsigned int dest = digitOffsets[(codes[i] >> shift) & ((1 << digitBits) - 1)]++;
+				sortedCodes[dest] = codes[i];
+				sortedIdxs[dest] = idxs[i];
+			}
+			codes.swap(sortedCodes);
+			idxs.swap(sortedIdxs);
+		}
+	}
+}
+
+Octree::Octree(BBox const& bbox, float looseness, unsigned int maxTrianglesPerCell) : _looseness(looseness), _maxTrianglesPerCell(maxTrianglesPerCell)
+{
+	unsigned int rootIdx = AddCell();
+	SetupCell(rootIdx, UNDEFINED_CELL_IDX, bbox);
+}
+
+Octree::Octree(Octree const& other):
+	_cells(other._cells),
+	_cellsBBox(other._cellsBBox),
+	_cellsContentBBox(other._cellsContentBBox),
+	_cellsTrianglesIdx(other._cellsTrianglesIdx),
+	_cellsVerticesIdx(other._cellsVerticesIdx),
+	_freeChildrenBlocks(other._freeChildrenBlocks),
+	_looseness(other._looseness),
+	_maxTrianglesPerCell(other._maxTrianglesPerCell)
+{
+	for(OctreeCell& cell : _cells)
+		cell._octree = this;	// Cells link to each other by index, only their owner changes
 }
 
-void OctreeCell::Insert(Mesh const& mesh, std::vector<unsigned int> const& trisToInsert, std::vector<unsigned int> const& vtxsToInsert)
+void Octree::Insert(Mesh& mesh, std::vector<unsigned int> const& trisToInsert, std::vector<unsigned int> const& vtxsToInsert, bool growContentBBox)
 {
+	InsertInCell(0, mesh, trisToInsert, vtxsToInsert, growContentBBox);
+	// Get back the slots lost by relocated lists
+	if(_cellsTrianglesIdx.HasToCompact())
+		_cellsTrianglesIdx.Compact();
+	if(_cellsVerticesIdx.HasToCompact())
+		_cellsVerticesIdx.Compact();
+}
+
+void Octree::BulkInsert(Mesh& mesh)
+{
+	ASSERT(!GetRoot().HasChildren() && (GetRoot().GetTrianglesIdx().size() == 0) && (GetRoot().GetVerticesIdx().size() == 0));
 	std::vector<Vector3> const& vertices = mesh.GetVertices();
 	std::vector<unsigned int> const& triangles = mesh.GetTriangles();
-	unsigned int totalCellTris = (unsigned int) (trisToInsert.size() + _trianglesIdx.size());
-	if(HasChildren() || (totalCellTris > maxTrianglesPerCell))	// have to subdivide cells or keep subdivision if it's already done
-	{
-		// Build sub cell bbox
-		Vector3 const& center = _BBox.Center();
-		Vector3 const& min = _BBox.Min();
-		Vector3 const& max = _BBox.Max();
-		std::vector<BBox> subCellsBBox;
-		subCellsBBox.reserve(8);
-		subCellsBBox.push_back(BBox(min, center));
-		subCellsBBox.push_back(BBox(Vector3(max.x, min.y, min.z), center));
-		subCellsBBox.push_back(BBox(Vector3(max.x, min.y, max.z), center));
-		subCellsBBox.push_back(BBox(Vector3(min.x, min.y, max.z), center));
-		subCellsBBox.push_back(BBox(max, center));
-		subCellsBBox.push_back(BBox(Vector3(min.x, max.y, max.z), center));
-		subCellsBBox.push_back(BBox(Vector3(min.x, max.y, min.z), center));
-		subCellsBBox.push_back(BBox(Vector3(max.x, max.y, min.z), center));
+	bool loose = IsLoose();
+	// Get each triangle and vertex Morton code (independent ones), then sort them so that each cell content is contiguous
+	MortonCoder mortonCoder(_cellsBBox[0]);
+	int nbTris = (int) (triangles.size() / 3);
+	std::vector<unsigned long long> trisCode(nbTris);
+	std::vector<unsigned int> trisIdx(nbTris);
+#pragma omp parallel for
+	for(int i = 0; i < nbTris; ++i)
+	{
+		trisCode[i] = mortonCoder.GetCode(GetTriangleAnchor(vertices, triangles, i, loose));
+		trisIdx[i] = i;
+	}
+	int nbVtxs = (int) vertices.size();
+	std::vector<unsigned long long> vtxsCode(nbVtxs);
+	std::vector<unsigned int> vtxsIdx(nbVtxs);
+#pragma omp parallel for
+	for(int i = 0; i < nbVtxs; ++i)
+	{
+		vtxsCode[i] = mortonCoder.GetCode(vertices[i]);
+		vtxsIdx[i] = i;
+	}
+#pragma omp parallel sections
+	{
+#pragma omp section
+		SortByMortonCode(trisCode, trisIdx);
+#pragma omp section
+		SortByMortonCode(vtxsCode, vtxsIdx);
+	}
+	BulkInsertInCell(0, 0, mesh, trisCode.data(), trisIdx.data(), (unsigned int) nbTris, vtxsCode.data(), vtxsIdx.data(), (unsigned int) nbVtxs);
+}
+
+void Octree::BulkInsertInCell(unsigned int cellIdx, unsigned int depth, Mesh& mesh, unsigned long long const* trisCode, unsigned int* trisIdx, unsigned int nbTris, unsigned long long const* vtxsCode, unsigned int* vtxsIdx, unsigned int nbVtxs)
+{	// Same choices as InsertInCell, but the sub cells content is already gathered: each one is a range of the sorted codes
+	if((nbTris > _maxTrianglesPerCell) && (depth < bulkInsertMaxDepth) && CanSubdivide(cellIdx))
+	{
+		static const unsigned int childPosToOctant[8] = { 0, 1, 5, 4, 7, 6, 2, 3 };	// See the sub cells order in GetSubCellsBBox
+		unsigned int shift = (bulkInsertMaxDepth - 1 - depth) * 3;
+		unsigned int octantsTrisBegin[9];
+		unsigned int octantsVtxsBegin[9];
+		octantsTrisBegin[0] = octantsVtxsBegin[0] = 0;
+		for(unsigned int octant = 0; octant < 8; ++octant)
+		{
+			unsigned int trisEnd = octantsTrisBegin[octant];
+			while((trisEnd < nbTris) && (((trisCode[trisEnd] >> shift) & 7) == octant))
+				++trisEnd;
+			octantsTrisBegin[octant + 1] = trisEnd;
+			unsigned int vtxsEnd = octantsVtxsBegin[octant];
+			while((vtxsEnd < nbVtxs) && (((vtxsCode[vtxsEnd] >> shift) & 7) == octant))
+				++vtxsEnd;
+			octantsVtxsBegin[octant + 1] = vtxsEnd;
+		}
+		ASSERT((octantsTrisBegin[8] == nbTris) && (octantsVtxsBegin[8] == nbVtxs));
+		BBox subCellsBBox[8];
+		GetSubCellsBBox(cellIdx, subCellsBBox);
+		unsigned int firstChildIdx = AllocateChildren();	// Note: the cells array can move
+		_cells[cellIdx]._firstChildIdx = firstChildIdx;
+		for(unsigned int i = 0; i < 8; ++i)
+		{
+			unsigned int octant = childPosToOctant[i];
+			unsigned int trisBegin = octantsTrisBegin[octant];
+			unsigned int vtxsBegin = octantsVtxsBegin[octant];
+			unsigned int nbSubCellTris = octantsTrisBegin[octant + 1] - trisBegin;
+			unsigned int nbSubCellVtxs = octantsVtxsBegin[octant + 1] - vtxsBegin;
+			if((nbSubCellTris != 0) || (nbSubCellVtxs != 0))
+			{
+				SetupCell(firstChildIdx + i, cellIdx, subCellsBBox[i]);
+				_cells[cellIdx]._childrenMask |= 1 << i;
+				BulkInsertInCell(firstChildIdx + i, depth + 1, mesh, trisCode + trisBegin, trisIdx + trisBegin, nbSubCellTris, vtxsCode + vtxsBegin, vtxsIdx + vtxsBegin, nbSubCellVtxs);
+			}
+		}
+	}
+	else
+	{	// Deeper digits of the codes sorted the leaf content, get back to the indices order (as Insert)
+		std::sort(trisIdx, trisIdx + nbTris);
+		std::sort(vtxsIdx, vtxsIdx + nbVtxs);
+		_cellsTrianglesIdx.Append(cellIdx, trisIdx, nbTris);
+		for(unsigned int i = 0; i < nbTris; ++i)
+			mesh.SetTriangleOctreeCell(trisIdx[i], cellIdx);
+		_cellsVerticesIdx.Append(cellIdx, vtxsIdx, nbVtxs);
+		OctreeCell& cell = _cells[cellIdx];
+		cell.AddStateFlags(CELL_STATE_HASTO_UPDATE_SUB_MESH);
+		cell.AddStateFlagsUpToRoot(CELL_STATE_HASTO_RECOMPUTE_BBOX);
+	}
+}
+
+void Octree::GetSubCellsBBox(unsigned int cellIdx, BBox (&subCellsBBox)[8]) const
+{
+	BBox const& cellBBox = _cellsBBox[cellIdx];
+	Vector3 const center = cellBBox.Center();
+	Vector3 const min = cellBBox.Min();
+	Vector3 const max = cellBBox.Max();
+	subCellsBBox[0] = BBox(min, center);
+	subCellsBBox[1] = BBox(Vector3(max.x, min.y, min.z), center);
+	subCellsBBox[2] = BBox(Vector3(max.x, min.y, max.z), center);
+	subCellsBBox[3] = BBox(Vector3(min.x, min.y, max.z), center);
+	subCellsBBox[4] = BBox(max, center);
+	subCellsBBox[5] = BBox(Vector3(min.x, max.y, max.z), center);
+	subCellsBBox[6] = BBox(Vector3(min.x, max.y, min.z), center);
+	subCellsBBox[7] = BBox(Vector3(max.x, max.y, min.z), center);
+}
+
+bool Octree::CanSubdivide(unsigned int cellIdx) const
+{	// Triangles sharing their anchor can't be split apart, with a small capacity they could subdivide cells forever
+	return _cellsBBox[cellIdx].Size().x > _cellsBBox[0].Size().x * minCellSizeRatio;
+}
+
+void Octree::InsertInCell(unsigned int cellIdx, Mesh& mesh, std::vector<unsigned int> const& trisToInsert, std::vector<unsigned int> const& vtxsToInsert, bool growContentBBox)
+{	// Note: cells can be created, so the cells array can move, don't keep a reference on a cell
+	std::vector<Vector3> const& vertices = mesh.GetVertices();
+	std::vector<unsigned int> const& triangles = mesh.GetTriangles();
+	bool loose = IsLoose();
+	IndexList cellTrianglesIdx = _cellsTrianglesIdx.GetList(cellIdx);
+	IndexList cellVerticesIdx = _cellsVerticesIdx.GetList(cellIdx);
+	unsigned int totalCellTris = (unsigned int) (trisToInsert.size() + cellTrianglesIdx.size());
+	if(_cells[cellIdx].HasChildren() || ((totalCellTris > _maxTrianglesPerCell) && CanSubdivide(cellIdx)))	// have to subdivide cells or keep subdivision if it's already done
+	{
+		BBox subCellsBBox[8];
+		GetSubCellsBBox(cellIdx, subCellsBBox);
 		// Get all the triangles that fit in the sub-cells
 		std::vector<unsigned int> trisInSubCells[8];
 		for(std::vector<unsigned int>& trisInSubCell : trisInSubCells)
 			trisInSubCell.reserve(totalCellTris);
-		auto SetupSubCellTris = [&](std::vector<unsigned int> const& triIdxs)
+		auto SetupSubCellTris = [&](IndexList triIdxs)
 		{
-			for(int const& i : triIdxs)
+			for(unsigned int i : triIdxs)
 			{
+				Vector3 const triAnchor = GetTriangleAnchor(vertices, triangles, i, loose);
 				int zoneIndex = 0;
 				for(BBox const& subCellBBox : subCellsBBox)
 				{
-					if(subCellBBox.Contains(vertices[triangles[i * 3]]))	// just test first vertex for the moment (will center triangle center later)
+					if(subCellBBox.Contains(triAnchor))
 					{
 						trisInSubCells[zoneIndex].push_back(i);
 						break;	// If a triangle fits in a sub cell, it won't fit in any other
 					}
 					++zoneIndex;
 				}
-				ASSERT(zoneIndex < 8);	// The triangle has no bbox it fits in
+				if(zoneIndex == 8)
+				{	// The subdivided cell held it in its loose margin, give it to the closest sub cell (it'll go to its own cell at the next extraction)
+					ASSERT(loose);	// The triangle has no bbox it fits in
+					trisInSubCells[GetClosestSubCellPos(subCellsBBox, triAnchor)].push_back(i);
+				}
 			}
 		};
 		SetupSubCellTris(trisToInsert);
-		SetupSubCellTris(_trianglesIdx);
+		SetupSubCellTris(cellTrianglesIdx);
 #ifdef _DEBUG
 		// Verify that all triangles were set to the subcells
 		unsigned int nbTotalTriInSubCells = 0;
 		for(std::vector<unsigned int>& trisInSubCell : trisInSubCells)
 			nbTotalTriInSubCells += (unsigned int) trisInSubCell.size();
-		ASSERT(nbTotalTriInSubCells == (unsigned int) (trisToInsert.size() + _trianglesIdx.size()));
+		ASSERT(nbTotalTriInSubCells == (unsigned int) (trisToInsert.size() + cellTrianglesIdx.size()));
 #endif // _DEBUG
-		_trianglesIdx.clear();	// No need to set CELL_STATE_HASTO_UPDATE_SUB_MESH (if a cell is empty, the submesh will be deleted (see VisitorBuildAndCollectSubMeshes))
-		_trianglesIdx.shrink_to_fit();
-		for(std::vector<unsigned int>& trisInSubCell : trisInSubCells)
-			trisInSubCell.shrink_to_fit();
+		_cellsTrianglesIdx.Release(cellIdx);	// No need to set CELL_STATE_HASTO_UPDATE_SUB_MESH (if a cell is empty, the submesh will be deleted (see VisitorBuildAndCollectSubMeshes))
 		// Get all the vertices that fit in the sub-cells
 		std::vector<unsigned int> vtxsInSubCells[8];
 		for(std::vector<unsigned int>& vtxInSubCell : vtxsInSubCells)
 			vtxInSubCell.reserve(vtxsToInsert.size());
-		auto SetupSubCellVtxs = [&](std::vector<unsigned int> const& vtxIdxs)
+		auto SetupSubCellVtxs = [&](IndexList vtxIdxs)
 		{
-			for(int const& i : vtxIdxs)
+			for(unsigned int i : vtxIdxs)
 			{
 				int zoneIndex = 0;
 				for(BBox const& subCellBBox : subCellsBBox)
@@ -95,58 +345,177 @@ void OctreeCell::Insert(Mesh const& mesh, std::vector<unsigned int> const& trisT
 					}
 					++zoneIndex;
 				}
-				ASSERT(zoneIndex < 8);	// The vertex has no bbox it fits in
+				if(zoneIndex == 8)
+				{	// Same as triangles
+					ASSERT(loose);	// The vertex has no bbox it fits in
+					vtxsInSubCells[GetClosestSubCellPos(subCellsBBox, vertices[i])].push_back(i);
+				}
 			}
 		};
 		SetupSubCellVtxs(vtxsToInsert);
-		SetupSubCellVtxs(_verticesIdx);
+		SetupSubCellVtxs(cellVerticesIdx);
 #ifdef _DEBUG
 		// Verify that all vertices were set to the subcells
 		unsigned int nbTotalVtxsInSubCells = 0;
 		for(std::vector<unsigned int>& vtxsInSubCell : vtxsInSubCells)
 			nbTotalVtxsInSubCells += (unsigned int) vtxsInSubCell.size();
-		ASSERT(nbTotalVtxsInSubCells == (unsigned int) (vtxsToInsert.size() + _verticesIdx.size()));
+		ASSERT(nbTotalVtxsInSubCells == (unsigned int) (vtxsToInsert.size() + cellVerticesIdx.size()));
 #endif // _DEBUG
-		_verticesIdx.clear();	// No need to set CELL_STATE_HASTO_UPDATE_SUB_MESH (if a cell is empty, the submesh will be deleted (see VisitorBuildAndCollectSubMeshes))
-		_verticesIdx.shrink_to_fit();
-		for(std::vector<unsigned int>& vtxInSubCell : vtxsInSubCells)
-			vtxInSubCell.shrink_to_fit();
+		_cellsVerticesIdx.Release(cellIdx);	// No need to set CELL_STATE_HASTO_UPDATE_SUB_MESH (if a cell is empty, the submesh will be deleted (see VisitorBuildAndCollectSubMeshes))
 		// Create the sub cells and move the triangles and vertices that fit in each one
-		_children.resize(8);
-		int zoneIndex = 0;
+		if(_cells[cellIdx]._firstChildIdx == UNDEFINED_CELL_IDX)
+		{
+			unsigned int firstChildIdx = AllocateChildren();
+			_cells[cellIdx]._firstChildIdx = firstChildIdx;
+		}
+		unsigned int firstChildIdx = _cells[cellIdx]._firstChildIdx;
 		for(unsigned int i = 0; i < 8; ++i)
 		{
 			std::vector<unsigned int> const& trisInSubCell = trisInSubCells[i];
 			std::vector<unsigned int> const& vtxsInSubCell = vtxsInSubCells[i];
-			std::unique_ptr<OctreeCell>& _child = _children[zoneIndex];
 			if(!trisInSubCell.empty() || !vtxsInSubCell.empty())
 			{
-				if(_child == nullptr)
-					_child.reset(new OctreeCell(subCellsBBox[zoneIndex], this));
-				_child->Insert(mesh, trisInSubCell, vtxsInSubCell);
+				if(!_cells[cellIdx].HasChild(i))
+				{
+					SetupCell(firstChildIdx + i, cellIdx, subCellsBBox[i]);
+					_cells[cellIdx]._childrenMask |= 1 << i;
+				}
+				InsertInCell(firstChildIdx + i, mesh, trisInSubCell, vtxsInSubCell, growContentBBox);
 			}
-			++zoneIndex;
 		}
 	}
 	else // Enough room for all triangles, don't need to subdivide, then consume the triangles and vertices and store them
 	{
-		if(_trianglesIdx.empty())
-			_trianglesIdx = trisToInsert;	// Don't use std::move as the memory reserved in "trisToInsert" (and "vtxsToInsert") oversize the actual size
-		else
-		{	// Append trisToInsert to _trianglesIdx
-			_trianglesIdx.reserve(_trianglesIdx.size() + trisToInsert.size());
-			_trianglesIdx.insert(_trianglesIdx.end(), trisToInsert.begin(), trisToInsert.end());
-		}
-		if(_verticesIdx.empty())
-			_verticesIdx = vtxsToInsert;	// Don't use std::move as the memory reserved in "trisToInsert" (and "vtxsToInsert") oversize the actual size
-		else
-		{	// Append vtxsToInsert to _verticesIdx
-			_verticesIdx.reserve(_verticesIdx.size() + vtxsToInsert.size());
-			_verticesIdx.insert(_verticesIdx.end(), vtxsToInsert.begin(), vtxsToInsert.end());
-		}
+		_cellsTrianglesIdx.Append(cellIdx, trisToInsert);
+		for(unsigned int triIdx : trisToInsert)
+			mesh.SetTriangleOctreeCell(triIdx, cellIdx);
+		_cellsVerticesIdx.Append(cellIdx, vtxsToInsert);
 		// have to recompute bbox and rebuild submesh
-		AddStateFlags(CELL_STATE_HASTO_UPDATE_SUB_MESH);
-		AddStateFlagsUpToRoot(CELL_STATE_HASTO_RECOMPUTE_BBOX);
+		OctreeCell& cell = _cells[cellIdx];
+		cell.AddStateFlags(CELL_STATE_HASTO_UPDATE_SUB_MESH);
+		cell.AddStateFlagsUpToRoot(CELL_STATE_HASTO_RECOMPUTE_BBOX);
+		if(growContentBBox)
+		{	// Also holds the content of a cell that was just subdivided, its new sub cells having no bbox yet
+			for(unsigned int triIdx : trisToInsert)
+			{
+				for(unsigned int i = 0; i < 3; ++i)
+					cell.GrowContentBBox(vertices[triangles[triIdx * 3 + i]]);
+			}
+			for(unsigned int vtxIdx : vtxsToInsert)
+				cell.GrowContentBBox(vertices[vtxIdx]);
+		}
+	}
+}
+
+unsigned int Octree::AddCell()
+{
+	unsigned int cellIdx = (unsigned int) _cells.size();
+	_cells.push_back(OctreeCell());
+	_cells.back()._octree = this;
+	_cellsBBox.push_back(BBox());
+	_cellsContentBBox.push_back(BBox());
+	_cellsTrianglesIdx.AddList();
+	_cellsVerticesIdx.AddList();
+	return cellIdx;
+}
+
+void Octree::SetupCell(unsigned int cellIdx, unsigned int parentIdx, BBox const& bbox)
+{
+	OctreeCell& cell = _cells[cellIdx];
+	cell._octree = this;
+	cell._index = cellIdx;
+	cell._parentIdx = parentIdx;
+	cell._firstChildIdx = UNDEFINED_CELL_IDX;
+	cell._childrenMask = 0;
+	cell._id = OctreeCell::_idGen++;
+	cell._stateFlags = CELL_STATE_HASTO_UPDATE_SUB_MESH;
+	_cellsBBox[cellIdx] = bbox;
+	_cellsContentBBox[cellIdx].Reset();
+}
+
+unsigned int Octree::AllocateChildren()
+{
+	if(!_freeChildrenBlocks.empty())
+	{	// Reuse a block given back by PurgeEmptyChildren
+		unsigned int firstChildIdx = _freeChildrenBlocks.back();
+		_freeChildrenBlocks.pop_back();
+		return firstChildIdx;
+	}
+	unsigned int firstChildIdx = (unsigned int) _cells.size();
+	for(unsigned int i = 0; i < 8; ++i)
+		AddCell();
+	return firstChildIdx;
+}
+
+void Octree::ReleaseCell(unsigned int cellIdx)
+{
+	_cellsTrianglesIdx.Release(cellIdx);
+	_cellsVerticesIdx.Release(cellIdx);
+}
+
+void Octree::ReleaseChildren(unsigned int firstChildIdx)
+{
+	_freeChildrenBlocks.push_back(firstChildIdx);
+}
+
+size_t Octree::GetMemoryUsage() const
+{
+	return _cells.capacity() * sizeof(OctreeCell) + (_cellsBBox.capacity() + _cellsContentBBox.capacity()) * sizeof(BBox)
+		+ _cellsTrianglesIdx.GetMemoryUsage() + _cellsVerticesIdx.GetMemoryUsage() + _freeChildrenBlocks.capacity() * sizeof(unsigned int);
+}
+
+void OctreeCell::GrowContentBBox(Vector3 const& point)
+{
+	OctreeCell* cell = this;
+	while(true)
+	{
+		BBox& contentBBox = cell->GrabContentBBox();
+		Vector3 const& min = contentBBox.Min();
+		Vector3 const& max = contentBBox.Max();
+		if((point.x >= min.x) && (point.x <= max.x) && (point.y >= min.y) && (point.y <= max.y) && (point.z >= min.z) && (point.z <= max.z))
+			return;
+		contentBBox.Encapsulate(point);
+		if(!cell->TestStateFlags(CELL_STATE_HASTO_SHRINK_BBOX))
+			cell->AddStateFlagsUpToRoot(CELL_STATE_HASTO_SHRINK_BBOX);
+		if(cell->IsRoot())
+			return;
+		cell = &_octree->_cells[cell->_parentIdx];
+	}
+}
+
+void OctreeCell::CollectIndices(std::vector<unsigned int>& verticesIdx, std::vector<unsigned int>& trianglesIdx) const
+{
+	IndexList cellVerticesIdx = GetVerticesIdx();
+	IndexList cellTrianglesIdx = GetTrianglesIdx();
+	verticesIdx.insert(verticesIdx.end(), cellVerticesIdx.begin(), cellVerticesIdx.end());
+	trianglesIdx.insert(trianglesIdx.end(), cellTrianglesIdx.begin(), cellTrianglesIdx.end());
+	for(unsigned int childPos = 0; childPos < 8; ++childPos)
+	{
+		if(HasChild(childPos))
+			GetChild(childPos).CollectIndices(verticesIdx, trianglesIdx);
+	}
+}
+
+void OctreeCell::RemapIndices(Mesh const& mesh)
+{
+	unsigned int* trianglesIdx = _octree->_cellsTrianglesIdx.GrabData(_index);
+	unsigned int nbTriangles = _octree->_cellsTrianglesIdx.GetCount(_index);
+	for(unsigned int i = 0; i < nbTriangles; ++i)
+	{
+		if(mesh.TriHasToMove(trianglesIdx[i]))
+			trianglesIdx[i] = mesh.GetNewTriIdx(trianglesIdx[i]);
+	}
+	unsigned int* verticesIdx = _octree->_cellsVerticesIdx.GrabData(_index);
+	unsigned int nbVertices = _octree->_cellsVerticesIdx.GetCount(_index);
+	for(unsigned int i = 0; i < nbVertices; ++i)
+	{
+		if(mesh.VtxHasToMove(verticesIdx[i]))
+			verticesIdx[i] = mesh.GetNewVtxIdx(verticesIdx[i]);
+	}
+	for(unsigned int childPos = 0; childPos < 8; ++childPos)
+	{
+		if(HasChild(childPos))
+			GrabChild(childPos).RemapIndices(mesh);
 	}
 }
 
@@ -155,64 +524,176 @@ void OctreeCell::Traverse(OctreeVisitor& visitor)
 	if(visitor.HasToVisit(*this))
 	{
 		visitor.VisitEnter(*this);
-		for(std::unique_ptr<OctreeCell>& childCell : _children)
+		for(unsigned int childPos = 0; childPos < 8; ++childPos)
 		{
-			if(childCell != nullptr)
-				childCell->Traverse(visitor);
+			if(HasChild(childPos))
+				GrabChild(childPos).Traverse(visitor);
 		}
 		visitor.VisitLeave(*this);
 	}
 }
 
-bool OctreeCell::HasChildren()
+void OctreeCell::ParallelTraverse(OctreeVisitor& visitor)
+{
+	VISITOR_PARALLELISM parallelism = visitor.GetParallelism();
+#ifdef _OPENMP
+	if(omp_get_max_threads() < 2)
+		parallelism = VISITOR_SEQUENTIAL;
+#else
+	parallelism = VISITOR_SEQUENTIAL;
+#endif // _OPENMP
+	if((parallelism == VISITOR_SEQUENTIAL) || !visitor.HasToVisit(*this))
+	{
+		Traverse(visitor);
+		return;
+	}
+	// Flatten the cells to visit: children in traverse order for VisitEnter, per depth for VisitLeave
+	std::vector<OctreeCell*> cellsToEnter;
+	std::vector<std::vector<OctreeCell*>> cellsToLeavePerDepth;
+	for(unsigned int childPos = 0; childPos < 8; ++childPos)
+	{
+		if(HasChild(childPos))
+			GrabChild(childPos).CollectCellsToVisit(visitor, 0, cellsToEnter, cellsToLeavePerDepth);
+	}
+	if(cellsToEnter.size() < minCellsForParallelTraverse)
+	{
+		Traverse(visitor);	// Note: HasToVisit will be called twice on some cells, visitors allowing parallelism don't mind
+		return;
+	}
+	// This cell is entered before and left after all the others, as in Traverse()
+	visitor.VisitEnter(*this);
+	// Enter all cells, dynamic scheduling so that threads done with light cells take the next blocks
+	signed int nbBlocks = (signed int) ((cellsToEnter.size() + cellsPerTraverseBlock - 1) / cellsPerTraverseBlock);
+	std::vector<std::unique_ptr<OctreeVisitor>> blockVisitors(nbBlocks);
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(signed int block = 0; block < nbBlocks; ++block)
+	{
+		OctreeVisitor* blockVisitor = &visitor;
+		if(parallelism == VISITOR_REDUCEABLE)
+		{
+			blockVisitors[block].reset(visitor.CreateThreadCopy());
+			blockVisitor = blockVisitors[block].get();
+		}
+		unsigned int end = std::min((unsigned int) cellsToEnter.size(), (unsigned int) (block + 1) * cellsPerTraverseBlock);
+		for(unsigned int i = block * cellsPerTraverseBlock; i < end; ++i)
+			blockVisitor->VisitEnter(*cellsToEnter[i]);
+	}
+	// Merge in block order, so the results are the same as Traverse() ones
+	if(parallelism == VISITOR_REDUCEABLE)
+	{
+		for(std::unique_ptr<OctreeVisitor>& blockVisitor : blockVisitors)
+			visitor.MergeThreadCopy(*blockVisitor);
+	}
+	// Leave cells deepest first, a cell is left once all its children were
+	for(signed int depth = (signed int) cellsToLeavePerDepth.size() - 1; depth >= 0; --depth)
+	{
+		std::vector<OctreeCell*> const& cellsToLeave = cellsToLeavePerDepth[depth];
+		#pragma omp parallel for schedule(dynamic, cellsPerTraverseBlock)
+		for(signed int i = 0; i < (signed int) cellsToLeave.size(); ++i)
+			visitor.VisitLeave(*cellsToLeave[i]);
+	}
+	visitor.VisitLeave(*this);
+}
+
+void OctreeCell::TraverseFrontToBack(OctreeVisitor& visitor)
+{
+	float entryDistance;
+	if(visitor.GetEntryDistance(*this, entryDistance))
+		VisitFrontToBack(visitor, entryDistance);
+}
+
+void OctreeCell::VisitFrontToBack(OctreeVisitor& visitor, float entryDistance)
+{
+	if(!visitor.IsInRange(entryDistance))
+		return;	// What the visitor found in closer cells makes this one useless
+	visitor.VisitEnter(*this);
+	// Sort the children to visit by entry distance (insertion sort, there are 8 at most)
+	unsigned int childrenPos[8];
+	float childrenEntryDistance[8];
+	unsigned int nbChildren = 0;
+	for(unsigned int childPos = 0; childPos < 8; ++childPos)
+	{
+		float childEntryDistance;
+		if(HasChild(childPos) && visitor.GetEntryDistance(GrabChild(childPos), childEntryDistance))
+		{
+			unsigned int i = nbChildren++;
+			for(; (i > 0) && (childrenEntryDistance[i - 1] > childEntryDistance); --i)
+			{
+				childrenPos[i] = childrenPos[i - 1];
+				childrenEntryDistance[i] = childrenEntryDistance[i - 1];
+			}
+			childrenPos[i] = childPos;
+			childrenEntryDistance[i] = childEntryDistance;
+		}
+	}
+	for(unsigned int i = 0; i < nbChildren; ++i)
+		GrabChild(childrenPos[i]).VisitFrontToBack(visitor, childrenEntryDistance[i]);
+	visitor.VisitLeave(*this);
+}
+
+void OctreeCell::CollectCellsToVisit(OctreeVisitor& visitor, unsigned int depth, std::vector<OctreeCell*>& cellsToEnter, std::vector<std::vector<OctreeCell*>>& cellsToLeavePerDepth)
 {
-	if(_children.empty())
-		return false;
-	for(std::unique_ptr<OctreeCell> const& child : _children)
+	if(visitor.HasToVisit(*this))
 	{
-		if(child != nullptr)
-			return true;
+		cellsToEnter.push_back(this);
+		if(cellsToLeavePerDepth.size() <= depth)
+			cellsToLeavePerDepth.resize(depth + 1);
+		cellsToLeavePerDepth[depth].push_back(this);
+		for(unsigned int childPos = 0; childPos < 8; ++childPos)
+		{
+			if(HasChild(childPos))
+				GrabChild(childPos).CollectCellsToVisit(visitor, depth + 1, cellsToEnter, cellsToLeavePerDepth);
+		}
 	}
-	return false;
 }
 
 void OctreeCell::ExtractOutOfBoundsGeom(Mesh const& mesh, std::vector<unsigned int>& extractedTris, std::vector<unsigned int>& extractedVtxs)
 {
 	std::vector<Vector3> const& vertices = mesh.GetVertices();
 	std::vector<unsigned int> const& triangles = mesh.GetTriangles();
-	size_t initialVerticesIdxSize = _verticesIdx.size();
-	size_t initialTrianglesIdxSize = _trianglesIdx.size();
+	bool loose = _octree->IsLoose();
+	BBox cellBBox = _octree->_cellsBBox[_index];
+	if(loose)
+		cellBBox.Scale(_octree->_looseness);	// Small moves keep the geometry in its cell
+	IndexListsPool& cellsTrianglesIdx = _octree->_cellsTrianglesIdx;
+	IndexListsPool& cellsVerticesIdx = _octree->_cellsVerticesIdx;
+	unsigned int* trianglesIdx = cellsTrianglesIdx.GrabData(_index);
+	unsigned int* verticesIdx = cellsVerticesIdx.GrabData(_index);
+	unsigned int initialNbTriangles = cellsTrianglesIdx.GetCount(_index);
+	unsigned int initialNbVertices = cellsVerticesIdx.GetCount(_index);
+	unsigned int nbTriangles = initialNbTriangles;
+	unsigned int nbVertices = initialNbVertices;
 
-	for(unsigned int i = 0; i < _trianglesIdx.size();)
+	for(unsigned int i = 0; i < nbTriangles;)
 	{
-		unsigned int triIdx = _trianglesIdx[i];
-		if(!_BBox.Contains(vertices[triangles[triIdx * 3]]))	// just test first vertex for the moment (will center triangle center later)
+		unsigned int triIdx = trianglesIdx[i];
+		if(!cellBBox.Contains(GetTriangleAnchor(vertices, triangles, triIdx, loose)))
 		{	// Has to remove triangle from the cell
 			// Remove element from triangle array
-			_trianglesIdx[i] = _trianglesIdx.back();
-			_trianglesIdx.pop_back();
+			trianglesIdx[i] = trianglesIdx[--nbTriangles];
 			// Store the triangle ID we will have to insert again
 			extractedTris.push_back(triIdx);
 		}
 		else
 			++i;
 	}
-	for(unsigned int i = 0; i < _verticesIdx.size();)
+	for(unsigned int i = 0; i < nbVertices;)
 	{
-		unsigned int vtxIdx = _verticesIdx[i];
-		if(!_BBox.Contains(vertices[vtxIdx]))
+		unsigned int vtxIdx = verticesIdx[i];
+		if(!cellBBox.Contains(vertices[vtxIdx]))
 		{	// Has to remove vertex from the cell
 			// Remove element from vertex array
-			_verticesIdx[i] = _verticesIdx.back();
-			_verticesIdx.pop_back();
+			verticesIdx[i] = verticesIdx[--nbVertices];
 			// Store the triangle ID we will have to insert again
 			extractedVtxs.push_back(vtxIdx);
 		}
 		else
 			++i;
 	}
+	cellsTrianglesIdx.Shrink(_index, nbTriangles);
+	cellsVerticesIdx.Shrink(_index, nbVertices);
 	// If something has changed, we have to recompute bbox and rebuild submesh
-	if((initialVerticesIdxSize != _verticesIdx.size()) || (initialTrianglesIdxSize != _trianglesIdx.size()))
+	if((initialNbVertices != nbVertices) || (initialNbTriangles != nbTriangles))
 	{
 		AddStateFlags(CELL_STATE_HASTO_UPDATE_SUB_MESH);
 		AddStateFlagsUpToRoot(CELL_STATE_HASTO_RECOMPUTE_BBOX);
@@ -221,39 +702,46 @@ void OctreeCell::ExtractOutOfBoundsGeom(Mesh const& mesh, std::vector<unsigned i
 
 void OctreeCell::PurgeEmptyChildren()
 {
-	if(_children.empty())
+	if(!HasChildren())
 		return;
-	bool hasAValidChild = false;
-	for(std::unique_ptr<OctreeCell>& childCell : _children)
+	for(unsigned int childPos = 0; childPos < 8; ++childPos)
 	{
-		if(childCell != nullptr)
+		if(HasChild(childPos))
 		{
-			if(!childCell->HasChildren() && childCell->GetTrianglesIdx().empty() && childCell->GetVerticesIdx().empty())
-				childCell = nullptr;
-			else
-				hasAValidChild = true;
+			OctreeCell& childCell = GrabChild(childPos);
+			if(!childCell.HasChildren() && childCell.GetTrianglesIdx().empty() && childCell.GetVerticesIdx().empty())
+			{
+				_octree->ReleaseCell(childCell._index);
+				_childrenMask &= ~(1 << childPos);
+				AddStateFlags(CELL_STATE_HASTO_UPDATE_SUB_MESH);	// A sub mesh gathering several cells (see VisitorBuildAndCollectSubMeshes) has to drop the released cell
+			}
 		}
 	}
-	if(hasAValidChild == false)	// No child with something in it are there any more. So delete children array
+	if(!HasChildren())	// No child with something in it are there any more. So give back the children block
 	{
-		_children.clear();
-		_children.shrink_to_fit();
+		_octree->ReleaseChildren(_firstChildIdx);
+		_firstChildIdx = UNDEFINED_CELL_IDX;
 	}
 }
 
 void OctreeCell::HandlePendingRemovals(Mesh const& mesh, bool doRemapping)
 {
 	// remove from vertices and triangles, the ones that have been tagged has pending to be removed (because one of their edge were too small)
-	size_t initialVerticesIdxSize = _verticesIdx.size();
-	size_t initialTrianglesIdxSize = _trianglesIdx.size();
+	IndexListsPool& cellsTrianglesIdx = _octree->_cellsTrianglesIdx;
+	IndexListsPool& cellsVerticesIdx = _octree->_cellsVerticesIdx;
+	unsigned int* trianglesIdx = cellsTrianglesIdx.GrabData(_index);
+	unsigned int* verticesIdx = cellsVerticesIdx.GrabData(_index);
+	unsigned int initialNbTriangles = cellsTrianglesIdx.GetCount(_index);
+	unsigned int initialNbVertices = cellsVerticesIdx.GetCount(_index);
+	unsigned int nbTriangles = initialNbTriangles;
+	unsigned int nbVertices = initialNbVertices;
 	bool remapOccured = false;
-	for(unsigned int i = 0; i < _trianglesIdx.size();)
+	for(unsigned int i = 0; i < nbTriangles;)
 	{
-		unsigned int& triIdx = _trianglesIdx[i];
+		unsigned int& triIdx = trianglesIdx[i];
 		if(mesh.IsTriangleToBeRemoved(triIdx))
 		{	// Remove element
-			triIdx = _trianglesIdx.back();
-			_trianglesIdx.pop_back();
+			triIdx = trianglesIdx[--nbTriangles];
 		}
 		else
 		{
@@ -265,13 +753,12 @@ void OctreeCell::HandlePendingRemovals(Mesh const& mesh, bool doRemapping)
 			++i;
 		}
 	}
-	for(unsigned int i = 0; i < _verticesIdx.size();)
+	for(unsigned int i = 0; i < nbVertices;)
 	{
-		unsigned int& vtxIdx = _verticesIdx[i];
+		unsigned int& vtxIdx = verticesIdx[i];
 		if(mesh.IsVertexToBeRemoved(vtxIdx))
 		{	// Remove element
-			vtxIdx = _verticesIdx.back();
-			_verticesIdx.pop_back();
+			vtxIdx = verticesIdx[--nbVertices];
 		}
 		else
 		{
@@ -283,8 +770,10 @@ void OctreeCell::HandlePendingRemovals(Mesh const& mesh, bool doRemapping)
 			++i;
 		}
 	}
+	cellsTrianglesIdx.Shrink(_index, nbTriangles);
+	cellsVerticesIdx.Shrink(_index, nbVertices);
 	// If something has changed, we have to recompute bbox and rebuild submesh
-	if(remapOccured || (initialVerticesIdxSize != _verticesIdx.size()) || (initialTrianglesIdxSize != _trianglesIdx.size()))
+	if(remapOccured || (initialNbVertices != nbVertices) || (initialNbTriangles != nbTriangles))
 	{
 		AddStateFlags(CELL_STATE_HASTO_UPDATE_SUB_MESH);
 		AddStateFlagsUpToRoot(CELL_STATE_HASTO_RECOMPUTE_BBOX);
@@ -2,61 +2,64 @@
 #define _OCTREE_H_
 
 #include <vector>
-#include <memory>
 #include "Collisions\BBox.h"
+#include "IndexListsPool.h"
 
 class Mesh;
 class BBox;
+class Octree;
 class OctreeVisitor;
 
 enum CELL_STATE_FLAGS
 {
 	CELL_STATE_HASTO_UPDATE_SUB_MESH = 1,
 	CELL_STATE_HASTO_RECOMPUTE_BBOX = CELL_STATE_HASTO_UPDATE_SUB_MESH << 1,
-	CELL_STATE_HASTO_EXTRACT_OUTOFBOUNDS_GEOM = CELL_STATE_HASTO_RECOMPUTE_BBOX << 1
+	CELL_STATE_HASTO_EXTRACT_OUTOFBOUNDS_GEOM = CELL_STATE_HASTO_RECOMPUTE_BBOX << 1,
+	CELL_STATE_HASTO_PATCH_SUB_MESH = CELL_STATE_HASTO_EXTRACT_OUTOFBOUNDS_GEOM << 1,	// Vertices of the cell triangles changed, the sub mesh may only need its vertices refreshed
+	CELL_STATE_HASTO_GROW_BBOX = CELL_STATE_HASTO_PATCH_SUB_MESH << 1,	// Vertices of the cell moved, its content bbox has to hold them (but doesn't need to be recomputed)
+	CELL_STATE_HASTO_SHRINK_BBOX = CELL_STATE_HASTO_GROW_BBOX << 1	// Content bbox was grown, it may be bigger than the cell content until recomputed (see Mesh::ShrinkFragmentsBBox)
 };
 
+const unsigned int UNDEFINED_CELL_IDX = 0xFFFFFFFF;
+
+// A node of the octree. Cells live in their octree pool and refer to each other by index, their bboxes and index lists are stored by the pool
 class OctreeCell
 {
 public:
-	OctreeCell(BBox const& BBox, OctreeCell* parent): _id(_idGen++), _stateFlags(0), _BBox(BBox), _parent(parent) { AddStateFlags(CELL_STATE_HASTO_UPDATE_SUB_MESH); }
-	OctreeCell(OctreeCell const& otherCell, OctreeCell* parent); // For cloning octree
-
-	// Use insert to add tri and vertices initally, but also at update
-	void Insert(Mesh const& mesh, std::vector<unsigned int> const& trisToInsert, std::vector<unsigned int> const& vtxToInsert);
+	void CollectIndices(std::vector<unsigned int>& verticesIdx, std::vector<unsigned int>& trianglesIdx) const;	// Depth first, so that each cell vertices and triangles end up contiguous
+	void RemapIndices(Mesh const& mesh);	// Apply the mesh new vertices and triangles indices, when only a renumbering occurred (no flags are set, content doesn't change)
 
 	// Visitor's Traverse
 	void Traverse(OctreeVisitor& visitor);
+	void ParallelTraverse(OctreeVisitor& visitor);	// Falls back to Traverse() for VISITOR_SEQUENTIAL visitors and small trees
+	void TraverseFrontToBack(OctreeVisitor& visitor);	// Children are entered by increasing entry distance (see OctreeVisitor::GetEntryDistance)
 
 	// Vertices and triangles
-	std::vector<unsigned int> const& GetTrianglesIdx() const { return _trianglesIdx; }
-	std::vector<unsigned int> const& GetVerticesIdx() const { return _verticesIdx; }
+	IndexList GetTrianglesIdx() const;
+	IndexList GetVerticesIdx() const;
 
 	// ID
 	unsigned int GetID() const { return _id; }
+	unsigned int GetIndex() const { return _index; }	// Position in the octree pool
 
 	// Bbox
-	BBox const& GetContentBBox() const { return _contentBBox; }
-	BBox& GrabContentBBox() { return _contentBBox; }
+	BBox const& GetContentBBox() const;
+	BBox& GrabContentBBox();
+	void GrowContentBBox(Vector3 const& point);	// Parents grow as well, as long as the point is out of their content bbox
 
 	// Flags
 	void AddStateFlags(unsigned int flags) { _stateFlags |= flags; }
-	void AddStateFlagsUpToRoot(unsigned int flags)
-	{
-		OctreeCell *cell = this;
-		while(cell)
-		{
-			cell->_stateFlags |= flags;
-			cell = cell->_parent;
-		}
-	}
+	void AddStateFlagsUpToRoot(unsigned int flags);
 	void ClearStateFlags(unsigned int flags) { _stateFlags &= ~flags; }
 	bool TestStateFlags(unsigned int flags) const { return (_stateFlags & flags) != 0; }
+	unsigned int GetStateFlags() const { return _stateFlags; }
 
 	// Hierarchy
-	bool HasChildren();
-	std::vector<std::unique_ptr<OctreeCell>> const& GetChildren() const { return _children; }
-	bool IsRoot() { return _parent == nullptr; }
+	bool HasChildren() const { return _childrenMask != 0; }
+	bool HasChild(unsigned int childPos) const { return (_childrenMask & (1 << childPos)) != 0; }
+	OctreeCell const& GetChild(unsigned int childPos) const;
+	OctreeCell& GrabChild(unsigned int childPos);
+	bool IsRoot() const { return _parentIdx == UNDEFINED_CELL_IDX; }
 
 	// Rebuild
 	void ExtractOutOfBoundsGeom(Mesh const& mesh, std::vector<unsigned int>& extractedTris, std::vector<unsigned int>& extractedVtxs);
@@ -64,15 +67,87 @@ public:
 	void HandlePendingRemovals(Mesh const& mesh, bool doRemapping);
 
 private:
-	std::vector<std::unique_ptr<OctreeCell>> _children;
-	OctreeCell* _parent;
-	std::vector<unsigned int> _trianglesIdx;
-	std::vector<unsigned int> _verticesIdx;
-	BBox const _BBox;		// Octree cell bbox
-	BBox _contentBBox;		// Bbox encompassing triangles and vertices contained in the cell
+	friend class Octree;
+
+	void VisitFrontToBack(OctreeVisitor& visitor, float entryDistance);
+	void CollectCellsToVisit(OctreeVisitor& visitor, unsigned int depth, std::vector<OctreeCell*>& cellsToEnter, std::vector<std::vector<OctreeCell*>>& cellsToLeavePerDepth);
+
+	Octree* _octree;	// Pool owning the cell
+	unsigned int _index;
+	unsigned int _parentIdx;
+	unsigned int _firstChildIdx;	// Children are 8 consecutive cells in the pool (UNDEFINED_CELL_IDX if none were ever created)
+	unsigned int _childrenMask;	// Bit set for each of the 8 children in use
 	static unsigned int _idGen;
 	unsigned int _id;
 	unsigned int _stateFlags;
 };
 
-#endif // _OCTREE_H_
\ No newline at end of file
+// Pointerless octree: cells are stored in a flat array and link to their children with a 32 bits index.
+// Bboxes are stored contiguously, apart from the cells, and the cells vertices and triangles index lists share two pools, so copying an octree only copies a few arrays.
+// Cells can move in memory when new ones are created (Insert), don't keep references to them across an Insert.
+// A loose octree (looseness above 1) places triangles by their centroid, then lets them (and the vertices) move in the cell bbox scaled by the looseness before extracting them (see ExtractOutOfBoundsGeom).
+class Octree
+{
+public:
+	Octree(BBox const& bbox, float looseness, unsigned int maxTrianglesPerCell);
+	Octree(Octree const& other);
+
+	OctreeCell& GrabRoot() { return _cells[0]; }
+	OctreeCell const& GetRoot() const { return _cells[0]; }
+	OctreeCell& GrabCell(unsigned int cellIdx) { ASSERT(cellIdx < _cells.size()); return _cells[cellIdx]; }
+
+	// Use insert to add tri and vertices initally, but also at update
+	void Insert(Mesh& mesh, std::vector<unsigned int> const& trisToInsert, std::vector<unsigned int> const& vtxsToInsert, bool growContentBBox = false);	// With "growContentBBox", cells receiving geometry grow their content bbox right away, so queries find it before the next bbox recompute
+	void BulkInsert(Mesh& mesh);	// Fills an empty octree with all the mesh triangles and vertices, sorted by Morton code instead of being split level after level (same tree as Insert)
+
+	void SetLooseness(float looseness) { _looseness = looseness; }	// Call ReBalanceOctree afterwards, so that what the cells hold follows the new rule
+	float GetLooseness() const { return _looseness; }
+	bool IsLoose() const { return _looseness > 1.0f; }
+	unsigned int GetMaxTrianglesPerCell() const { return _maxTrianglesPerCell; }	// Leaves holding more are subdivided
+
+	size_t GetMemoryUsage() const;
+
+private:
+	friend class OctreeCell;
+
+	bool CanSubdivide(unsigned int cellIdx) const;
+	void GetSubCellsBBox(unsigned int cellIdx, BBox (&subCellsBBox)[8]) const;
+	void InsertInCell(unsigned int cellIdx, Mesh& mesh, std::vector<unsigned int> const& trisToInsert, std::vector<unsigned int> const& vtxsToInsert, bool growContentBBox);
+	void BulkInsertInCell(unsigned int cellIdx, unsigned int depth, Mesh& mesh, unsigned long long const* trisCode, unsigned int* trisIdx, unsigned int nbTris, unsigned long long const* vtxsCode, unsigned int* vtxsIdx, unsigned int nbVtxs);
+	unsigned int AddCell();
+	void SetupCell(unsigned int cellIdx, unsigned int parentIdx, BBox const& bbox);
+	unsigned int AllocateChildren();	// Returns the index of the first of the 8 children
+	void ReleaseCell(unsigned int cellIdx);
+	void ReleaseChildren(unsigned int firstChildIdx);
+
+	std::vector<OctreeCell> _cells;	// Root is the first one
+	std::vector<BBox> _cellsBBox;	// Octree cell bbox
+	std::vector<BBox> _cellsContentBBox;	// Bbox encompassing triangles and vertices contained in the cell
+	IndexListsPool _cellsTrianglesIdx;	// One list per cell
+	IndexListsPool _cellsVerticesIdx;
+	std::vector<unsigned int> _freeChildrenBlocks;	// First cell of the children blocks given back by PurgeEmptyChildren
+	float _looseness;	// 1 for a strict octree
+	unsigned int _maxTrianglesPerCell;
+};
+
+inline IndexList OctreeCell::GetTrianglesIdx() const { return _octree->_cellsTrianglesIdx.GetList(_index); }
+inline IndexList OctreeCell::GetVerticesIdx() const { return _octree->_cellsVerticesIdx.GetList(_index); }
+inline BBox const& OctreeCell::GetContentBBox() const { return _octree->_cellsContentBBox[_index]; }
+inline BBox& OctreeCell::GrabContentBBox() { return _octree->_cellsContentBBox[_index]; }
+inline OctreeCell const& OctreeCell::GetChild(unsigned int childPos) const { ASSERT(HasChild(childPos)); return _octree->_cells[_firstChildIdx + childPos]; }
+inline OctreeCell& OctreeCell::GrabChild(unsigned int childPos) { ASSERT(HasChild(childPos)); return _octree->_cells[_firstChildIdx + childPos]; }
+
+inline void OctreeCell::AddStateFlagsUpToRoot(unsigned int flags)
+{
+	OctreeCell* cell = this;
+	while(true)
+	{
+#pragma omp atomic
+		cell->_stateFlags |= flags;	// Atomic as sibling cells can be visited concurrently (see ParallelTraverse)
+		if(cell->IsRoot())
+			break;
+		cell = &(_octree->_cells[cell->_parentIdx]);
+	}
+}
+
+#endif // _OCTREE_H_
@@ -3,13 +3,31 @@
 
 class OctreeCell;
 
+// Tells OctreeCell::ParallelTraverse how the visitor can be run
+enum VISITOR_PARALLELISM
+{
+	VISITOR_SEQUENTIAL,			// Cells have to be visited one at a time in traverse order
+	VISITOR_CELL_INDEPENDENT,	// VisitEnter/VisitLeave only touch the visited cell (and can flag its parents), HasToVisit doesn't depend on what VisitEnter does
+	VISITOR_REDUCEABLE			// Same as cell independent, but collects results: each block of cells is visited by its own copy, copies are merged back in traverse order
+};
+
 class OctreeVisitor
 {
 public:
 	OctreeVisitor() {}
+	virtual ~OctreeVisitor() {}
 	virtual bool HasToVisit(OctreeCell& /*cell*/) = 0;
 	virtual void VisitEnter(OctreeCell& /*cell*/) = 0; 
 	virtual void VisitLeave(OctreeCell& /*cell*/) = 0;
+
+	// Parallel traverse related
+	virtual VISITOR_PARALLELISM GetParallelism() const { return VISITOR_SEQUENTIAL; }
+	virtual OctreeVisitor* CreateThreadCopy() const { return nullptr; }	// VISITOR_REDUCEABLE only: empty copy that collects its own results
+	virtual void MergeThreadCopy(OctreeVisitor& /*threadCopy*/) {}		// VISITOR_REDUCEABLE only: append the copy results to ours
+
+	// Front to back traverse related
+	virtual bool GetEntryDistance(OctreeCell& cell, float& entryDistance) { entryDistance = 0.0f; return HasToVisit(cell); }	// Same as HasToVisit, also giving the distance at which the cell is reached
+	virtual bool IsInRange(float /*entryDistance*/) const { return true; }	// Checked right before entering a cell, once the closer ones were visited
 };
 
 #endif // _OCTREE_VISITOR_H_
\ No newline at end of file
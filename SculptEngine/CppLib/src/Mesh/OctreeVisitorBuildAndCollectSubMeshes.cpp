@@ -3,17 +3,108 @@
 #include "Mesh.h"
 #include "SubMesh.h"
 
-VisitorBuildAndCollectSubMeshes::VisitorBuildAndCollectSubMeshes(Mesh& fullMesh, VisitorBuildAndCollectSubMeshes const& cloneFrom): OctreeVisitor(), _fullMesh(fullMesh)
+namespace
+{
+	void CollectBranchTriangles(OctreeCell const& cell, std::vector<unsigned int>& trianglesIdx)
+	{	// Depth first as OctreeCell::CollectIndices, so that once reordered per cell the sub mesh vertices are contiguous
+		IndexList cellTrianglesIdx = cell.GetTrianglesIdx();
+		trianglesIdx.insert(trianglesIdx.end(), cellTrianglesIdx.begin(), cellTrianglesIdx.end());
+		for(unsigned int childPos = 0; childPos < 8; ++childPos)
+		{
+			if(cell.HasChild(childPos))
+				CollectBranchTriangles(cell.GetChild(childPos), trianglesIdx);
+		}
+	}
+}
+
+VisitorBuildAndCollectSubMeshes::VisitorBuildAndCollectSubMeshes(Mesh& fullMesh, VisitorBuildAndCollectSubMeshes const& cloneFrom): OctreeVisitor(), _fullMesh(fullMesh),
+	_maxVertices(cloneFrom._maxVertices),
+	_shareFullMeshBuffers(cloneFrom._shareFullMeshBuffers),
+	_hasToRebuildAll(cloneFrom._hasToRebuildAll),
+	_sharedWindowsVerticesCount(cloneFrom._sharedWindowsVerticesCount),
+	_sharedWindowsVerticesCountAfterRebuildAll(cloneFrom._sharedWindowsVerticesCountAfterRebuildAll)
 {
 	for(auto subMeshEntry : cloneFrom._subMeshes)
-		_subMeshes[subMeshEntry.first].reset(new SubMesh(*(subMeshEntry.second)));
+	{
+		SubMesh* subMesh = new SubMesh(*(subMeshEntry.second));
+		if(subMesh->IsSharingBuffers())	// Point to our own full mesh buffers
+			subMesh->ShareBuffers(_fullMesh.GetVertices(), _fullMesh.GetNormals(), subMesh->GetSharedFirstVertex(), subMesh->GetVerticesCount());
+		_subMeshes[subMeshEntry.first].reset(subMesh);
+	}
 	_subMeshesIds = cloneFrom._subMeshesIds;
 	_subMeshesToDelete = cloneFrom._subMeshesToDelete;
 }
 
-bool VisitorBuildAndCollectSubMeshes::HasToVisit(OctreeCell& /*cell*/)
+void VisitorBuildAndCollectSubMeshes::RemapFullMeshVerticesIdx()
 {
-	return true;
+	if(_shareFullMeshBuffers || _hasToRebuildAll)
+	{	// Windows are defined by the vertices order, they have to be recomputed (or sub meshes are stale anyway)
+		SetHasToRebuildAll();
+		return;
+	}
+	for(auto subMeshEntry : _subMeshes)
+	{	// Local vertices don't change, only where they come from
+		for(unsigned int& vtxIdx : subMeshEntry.second->GrabFullMeshVerticesIdx())
+		{
+			if(_fullMesh.VtxHasToMove(vtxIdx))
+				vtxIdx = _fullMesh.GetNewVtxIdx(vtxIdx);
+		}
+	}
+}
+
+void VisitorBuildAndCollectSubMeshes::SelectSubMeshesCells(OctreeCell const& root)
+{
+	CountBranchTriangles(root);
+	SetCellsRole(root, SUB_MESH_CELL_ABOVE);
+}
+
+unsigned int VisitorBuildAndCollectSubMeshes::CountBranchTriangles(OctreeCell const& cell)
+{
+	unsigned int nbBranchTris = cell.GetTrianglesIdx().size();
+	for(unsigned int childPos = 0; childPos < 8; ++childPos)
+	{
+		if(cell.HasChild(childPos))
+			nbBranchTris += CountBranchTriangles(cell.GetChild(childPos));
+	}
+	if(_cellsBranchTrisCount.size() <= cell.GetIndex())
+		_cellsBranchTrisCount.resize(cell.GetIndex() + 1);
+	_cellsBranchTrisCount[cell.GetIndex()] = nbBranchTris;
+	return nbBranchTris;
+}
+
+void VisitorBuildAndCollectSubMeshes::SetCellsRole(OctreeCell const& cell, SUB_MESH_CELL_ROLE role)
+{
+	if(role == SUB_MESH_CELL_ABOVE)
+	{	// The branch is gathered if each triangle could bring 3 vertices of its own without exceeding the max
+		if(!cell.HasChildren() || ((_maxVertices != 0) && (_cellsBranchTrisCount[cell.GetIndex()] <= _maxVertices / 3)))
+			role = SUB_MESH_CELL_ROOT;
+	}
+	if(_cellsRole.size() <= cell.GetIndex())
+		_cellsRole.resize(cell.GetIndex() + 1);
+	_cellsRole[cell.GetIndex()] = (unsigned char) role;
+	for(unsigned int childPos = 0; childPos < 8; ++childPos)
+	{
+		if(cell.HasChild(childPos))
+			SetCellsRole(cell.GetChild(childPos), (role == SUB_MESH_CELL_ABOVE) ? SUB_MESH_CELL_ABOVE : SUB_MESH_CELL_INSIDE);
+	}
+}
+
+unsigned int VisitorBuildAndCollectSubMeshes::GetAndClearBranchStateFlags(OctreeCell& cell, unsigned int flags)
+{
+	unsigned int branchFlags = cell.GetStateFlags() & flags;
+	cell.ClearStateFlags(flags);
+	for(unsigned int childPos = 0; childPos < 8; ++childPos)
+	{
+		if(cell.HasChild(childPos))
+			branchFlags |= GetAndClearBranchStateFlags(cell.GrabChild(childPos), flags);
+	}
+	return branchFlags;
+}
+
+bool VisitorBuildAndCollectSubMeshes::HasToVisit(OctreeCell& cell)
+{
+	ASSERT(cell.GetIndex() < _cellsRole.size());	// SelectSubMeshesCells wasn't called
+	return _cellsRole[cell.GetIndex()] != SUB_MESH_CELL_INSIDE;	// Branches are handled by the cell gathering them
 }
 
 void VisitorBuildAndCollectSubMeshes::VisitEnter(OctreeCell& cell)
@@ -24,101 +115,202 @@ void VisitorBuildAndCollectSubMeshes::VisitEnter(OctreeCell& cell)
 		for(auto subMeshEntry : _subMeshes)
 			_subMeshesToDelete.insert(subMeshEntry.first);
 	}
-	if(!cell.GetTrianglesIdx().empty())
+	if(_cellsRole[cell.GetIndex()] != SUB_MESH_CELL_ROOT)
+		return;
+	unsigned int nbBranchTris = _cellsBranchTrisCount[cell.GetIndex()];
+	if(nbBranchTris != 0)
 	{
+		#pragma omp critical(SubMeshesMap)
 		_subMeshesToDelete.erase(cell.GetID());	// Sub mesh (so octree cell) still exist
-		if(cell.TestStateFlags(CELL_STATE_HASTO_UPDATE_SUB_MESH) == false)
-		{	// Do a deep test to ensure that some triangles hasn't been modified without the cell flag set: When doing dynamic tessellation (subdiv and merge), it could spread to surroundings triangles and vertices. And keeping track of the triangle and vertices to octree cell association could cost much in memory and link update (from vertex or triangle to octree cell), so we set flag on vertices and scan for it
-			std::vector<unsigned int> const& trianglesIdx = cell.GetTrianglesIdx();
-			std::vector<unsigned int> const& trianglesFullmesh = _fullMesh.GetTriangles();
-			for(unsigned int const& triIdx : trianglesIdx)
+		// Note: cells holding triangles around modified vertices were flagged CELL_STATE_HASTO_PATCH_SUB_MESH by Mesh::UpdateSubMeshes(), no need to scan the clean ones
+		unsigned int branchFlags = GetAndClearBranchStateFlags(cell, CELL_STATE_HASTO_UPDATE_SUB_MESH | CELL_STATE_HASTO_PATCH_SUB_MESH);
+		if(_hasToRebuildAll || (branchFlags != 0))
+		{
+			bool hasToRebuild = _hasToRebuildAll || ((branchFlags & CELL_STATE_HASTO_UPDATE_SUB_MESH) != 0);
+			IndexList trianglesIdx = cell.GetTrianglesIdx();
+			std::vector<unsigned int> branchTrianglesIdx;
+			if(cell.HasChildren())
 			{
-				unsigned int const* vtxsIdx = &(trianglesFullmesh[triIdx * 3]);
-				if(_fullMesh.IsVertexToUpdateInSubMesh(vtxsIdx[0])
-				|| _fullMesh.IsVertexToUpdateInSubMesh(vtxsIdx[1])
-				|| _fullMesh.IsVertexToUpdateInSubMesh(vtxsIdx[2]))
-				{
-					cell.AddStateFlags(CELL_STATE_HASTO_UPDATE_SUB_MESH);
-					break;
-				}
+				branchTrianglesIdx.reserve(nbBranchTris);
+				CollectBranchTriangles(cell, branchTrianglesIdx);
+				trianglesIdx = IndexList(branchTrianglesIdx);
 			}
-		}
-		if(cell.TestStateFlags(CELL_STATE_HASTO_UPDATE_SUB_MESH))
-		{
-			cell.ClearStateFlags(CELL_STATE_HASTO_UPDATE_SUB_MESH);
 			// Try to find an already existing SubMesh, and if not, create it
-			std::map<unsigned int, std::shared_ptr<SubMesh>>::iterator itFindSubMesh = _subMeshes.find(cell.GetID());
 			std::shared_ptr<SubMesh> subMesh;
-			if(itFindSubMesh == _subMeshes.end())
-			{
-				subMesh.reset(new SubMesh(cell.GetID()));
-				_subMeshes[cell.GetID()] = subMesh;
-			}
-			else
-			{
-				subMesh = itFindSubMesh->second;
-				subMesh->IncVersionNumber();	// This way the caller/user of the submesh will know he has to update its data
-			}
-			// Get required vectors
-			std::vector<unsigned int> const& trianglesFullmesh = _fullMesh.GetTriangles();
-			std::vector<Vector3> const& verticesFullmesh = _fullMesh.GetVertices();
-			std::vector<Vector3> const& normalsFullmesh = _fullMesh.GetNormals();
-			std::vector<unsigned int> const& trianglesIdx = cell.GetTrianglesIdx();
-			std::vector<unsigned int>& subMeshTriangles = subMesh->GrabTriangles();
-			std::vector<Vector3>& subMeshVertioes = subMesh->GrabVertices();
-			std::vector<Vector3>& subMeshNormals = subMesh->GrabNormals();
-			// todo : enhance performances of the code below
-			subMeshTriangles.clear();
-			subMeshVertioes.clear();
-			subMeshNormals.clear();
-			// Build the list of needed unique vertex indices
-			std::vector<int> reqVtxIndices;
-			reqVtxIndices.reserve(trianglesIdx.size() * 3);	// Of course we reserve too much memory (this would be the size we would get if no triangles were weld together), but that's worth it as we don't know the exact size we will need and to avoid to have to reallocate after
-			for(unsigned int const& triIdx : trianglesIdx)
+			bool subMeshCreated = false;
+			#pragma omp critical(SubMeshesMap)
 			{
-				unsigned int const* vtxsIdx = &(trianglesFullmesh[triIdx * 3]);
-				for(int i = 0; i < 3; ++i)
+				std::shared_ptr<SubMesh>& subMeshEntry = _subMeshes[cell.GetID()];
+				if(subMeshEntry == nullptr)
 				{
-					if(!_fullMesh.IsVertexAlreadyTreated(vtxsIdx[i]))
-					{
-						_fullMesh.SetVertexAlreadyTreated(vtxsIdx[i]);
-						reqVtxIndices.push_back(vtxsIdx[i]);
-					}
+					subMeshEntry.reset(new SubMesh(cell.GetID()));
+					subMeshCreated = true;
 				}
+				subMesh = subMeshEntry;
 			}
-			// Build vertex vector from collected unique vertex indices
-			subMeshVertioes.reserve(reqVtxIndices.size());
-			subMeshNormals.reserve(reqVtxIndices.size());
-			std::map<int, int> vtxIdxRemap;
-			for(int const& vtxIdx : reqVtxIndices)
-			{
-				vtxIdxRemap[vtxIdx] = (int) subMeshVertioes.size();
-				subMeshVertioes.push_back(verticesFullmesh[vtxIdx]);
-				subMeshNormals.push_back(normalsFullmesh[vtxIdx]);
-				_fullMesh.ClearVertexAlreadyTreated(vtxIdx);
-			}
-			// Build triangles draw list
-			subMeshTriangles.reserve(trianglesIdx.size() * 3);
-			for(unsigned int const& triIdx : trianglesIdx)
+			unsigned int prevVersionNumber = subMesh->GetVersionNumber();
+			if(subMeshCreated)
+				hasToRebuild = true;
+			else
+				subMesh->IncVersionNumber();	// This way the caller/user of the submesh will know he has to update its data
+			if(hasToRebuild || !PatchSubMesh(trianglesIdx, *subMesh, prevVersionNumber))
 			{
-				unsigned int const* vtxsIdx = &(trianglesFullmesh[triIdx * 3]);
-				for(int i = 0; i < 3; ++i)
-					subMeshTriangles.push_back(vtxIdxRemap[vtxsIdx[i]]);
+				if(_shareFullMeshBuffers)
+					RebuildSharedSubMesh(trianglesIdx, *subMesh);
+				else
+					RebuildSubMesh(trianglesIdx, *subMesh);
+				subMesh->ClearDirtyRanges(subMesh->GetVersionNumber());	// No partial update possible, everything has to be reloaded
 			}
 			// Set bbox
 			subMesh->SetBBox(cell.GetContentBBox());
 		}
 #ifdef _DEBUG
-		std::map<unsigned int, std::shared_ptr<SubMesh>>::iterator itFindSubMesh = _subMeshes.find(cell.GetID());
-		if(itFindSubMesh != _subMeshes.end())
+		#pragma omp critical(SubMeshesMap)
 		{
-			//ASSERT(itFindSubMesh->second->GetVertices().size() == cell.GetVerticesIdx().size());	// Can't test vertices number as vertices stored in the cell doesn't necessarily belong to the cell's triangle.
-			ASSERT(itFindSubMesh->second->GetTriangles().size() == cell.GetTrianglesIdx().size() * 3);
+			std::map<unsigned int, std::shared_ptr<SubMesh>>::iterator itFindSubMesh = _subMeshes.find(cell.GetID());
+			if(itFindSubMesh != _subMeshes.end())
+			{
+				//ASSERT(itFindSubMesh->second->GetVertices().size() == cell.GetVerticesIdx().size());	// Can't test vertices number as vertices stored in the cell doesn't necessarily belong to the cell's triangle.
+				ASSERT(itFindSubMesh->second->GetTriangles().size() == nbBranchTris * 3);
+			}
 		}
 #endif // _DEBUG
 	}
 }
 
+bool VisitorBuildAndCollectSubMeshes::PatchSubMesh(IndexList trianglesIdx, SubMesh& subMesh, unsigned int prevVersionNumber)
+{
+	std::vector<unsigned int> const& trianglesFullmesh = _fullMesh.GetTriangles();
+	std::vector<unsigned int> const& subMeshTriangles = subMesh.GetTriangles();
+	std::vector<unsigned int> const& fullMeshVtxsIdx = subMesh.GetFullMeshVerticesIdx();
+	// Check the triangles still use the same vertices (retessellation edits triangles in place, pending removals remap vertices)
+	if(subMeshTriangles.size() != trianglesIdx.size() * 3)
+		return false;
+	if(subMesh.IsSharingBuffers())
+	{	// Nothing to copy, only check the topology and report the modified vertices of our window
+		unsigned int firstVertex = subMesh.GetSharedFirstVertex();
+		unsigned int verticesCount = subMesh.GetVerticesCount();
+		for(unsigned int i = 0; i < trianglesIdx.size(); ++i)
+		{
+			unsigned int const* vtxsIdx = &(trianglesFullmesh[trianglesIdx[i] * 3]);
+			unsigned int const* subMeshVtxsIdx = &(subMeshTriangles[i * 3]);
+			for(int j = 0; j < 3; ++j)
+			{
+				if(firstVertex + subMeshVtxsIdx[j] != vtxsIdx[j])
+					return false;
+			}
+		}
+		subMesh.ClearDirtyRanges(prevVersionNumber);
+		for(unsigned int i = 0; i < verticesCount; ++i)
+		{
+			if(_fullMesh.IsVertexToUpdateInSubMesh(firstVertex + i))
+				subMesh.AddDirtyVertex(i);
+		}
+		return true;
+	}
+	for(unsigned int i = 0; i < trianglesIdx.size(); ++i)
+	{
+		unsigned int const* vtxsIdx = &(trianglesFullmesh[trianglesIdx[i] * 3]);
+		unsigned int const* subMeshVtxsIdx = &(subMeshTriangles[i * 3]);
+		for(int j = 0; j < 3; ++j)
+		{
+			if(fullMeshVtxsIdx[subMeshVtxsIdx[j]] != vtxsIdx[j])
+				return false;
+		}
+	}
+	// Same topology, only refresh the vertices that were modified
+	std::vector<Vector3> const& verticesFullmesh = _fullMesh.GetVertices();
+	std::vector<Vector3> const& normalsFullmesh = _fullMesh.GetNormals();
+	std::vector<Vector3>& subMeshVertices = subMesh.GrabVertices();
+	std::vector<Vector3>& subMeshNormals = subMesh.GrabNormals();
+	subMesh.ClearDirtyRanges(prevVersionNumber);
+	for(unsigned int i = 0; i < fullMeshVtxsIdx.size(); ++i)
+	{
+		unsigned int vtxIdx = fullMeshVtxsIdx[i];
+		if(_fullMesh.IsVertexToUpdateInSubMesh(vtxIdx))
+		{
+			subMeshVertices[i] = verticesFullmesh[vtxIdx];
+			subMeshNormals[i] = normalsFullmesh[vtxIdx];
+			subMesh.AddDirtyVertex(i);
+		}
+	}
+	return true;
+}
+
+void VisitorBuildAndCollectSubMeshes::RebuildSubMesh(IndexList trianglesIdx, SubMesh& subMesh)
+{
+	std::vector<unsigned int> const& trianglesFullmesh = _fullMesh.GetTriangles();
+	std::vector<Vector3> const& verticesFullmesh = _fullMesh.GetVertices();
+	std::vector<Vector3> const& normalsFullmesh = _fullMesh.GetNormals();
+	std::vector<unsigned int>& subMeshTriangles = subMesh.GrabTriangles();
+	std::vector<Vector3>& subMeshVertices = subMesh.GrabVertices();
+	std::vector<Vector3>& subMeshNormals = subMesh.GrabNormals();
+	std::vector<unsigned int>& fullMeshVtxsIdx = subMesh.GrabFullMeshVerticesIdx();
+	subMesh.StopSharingBuffers();
+	// Full mesh to local vertex index remap: open addressing hash table, sized to stay under half full
+	unsigned int nbHashBits = 4;
+	while((1u << nbHashBits) < trianglesIdx.size() * 3 * 2)
+		++nbHashBits;
+	unsigned int hashMask = (1u << nbHashBits) - 1;
+	std::vector<unsigned int> hashKeys(hashMask + 1, UNDEFINED_NEW_ID);
+	std::vector<unsigned int> hashValues(hashMask + 1);
+	// Build triangles draw list and the local to full mesh vertex index table (vertices are added in first use order)
+	fullMeshVtxsIdx.clear();
+	subMeshTriangles.resize(trianglesIdx.size() * 3);
+	for(unsigned int i = 0; i < trianglesIdx.size(); ++i)
+	{
+		unsigned int const* vtxsIdx = &(trianglesFullmesh[trianglesIdx[i] * 3]);
+		for(int j = 0; j < 3; ++j)
+		{
+			unsigned int vtxIdx = vtxsIdx[j];
+			unsigned int slot = ((vtxIdx * 2654435761u) >> (32 - nbHashBits)) & hashMask;
+			while((hashKeys[slot] != vtxIdx) && (hashKeys[slot] != UNDEFINED_NEW_ID))
+				slot = (slot + 1) & hashMask;
+			if(hashKeys[slot] == UNDEFINED_NEW_ID)
+			{	// First time we meet this vertex
+				hashKeys[slot] = vtxIdx;
+				hashValues[slot] = (unsigned int) fullMeshVtxsIdx.size();
+				fullMeshVtxsIdx.push_back(vtxIdx);
+			}
+			subMeshTriangles[i * 3 + j] = hashValues[slot];
+		}
+	}
+	// Build vertex vector from collected unique vertex indices
+	subMeshVertices.resize(fullMeshVtxsIdx.size());
+	subMeshNormals.resize(fullMeshVtxsIdx.size());
+	for(unsigned int i = 0; i < fullMeshVtxsIdx.size(); ++i)
+	{
+		subMeshVertices[i] = verticesFullmesh[fullMeshVtxsIdx[i]];
+		subMeshNormals[i] = normalsFullmesh[fullMeshVtxsIdx[i]];
+	}
+}
+
+void VisitorBuildAndCollectSubMeshes::RebuildSharedSubMesh(IndexList trianglesIdx, SubMesh& subMesh)
+{
+	std::vector<unsigned int> const& trianglesFullmesh = _fullMesh.GetTriangles();
+	std::vector<unsigned int>& subMeshTriangles = subMesh.GrabTriangles();
+	// Our window spans all the vertices used by the branch triangles (once vertices are reordered per cell, mostly the branch own ones)
+	unsigned int firstVertex = (unsigned int) ~0;
+	unsigned int lastVertex = 0;
+	for(unsigned int triIdx : trianglesIdx)
+	{
+		unsigned int const* vtxsIdx = &(trianglesFullmesh[triIdx * 3]);
+		for(int j = 0; j < 3; ++j)
+		{
+			firstVertex = min(firstVertex, vtxsIdx[j]);
+			lastVertex = max(lastVertex, vtxsIdx[j]);
+		}
+	}
+	subMeshTriangles.resize(trianglesIdx.size() * 3);
+	for(unsigned int i = 0; i < trianglesIdx.size(); ++i)
+	{
+		unsigned int const* vtxsIdx = &(trianglesFullmesh[trianglesIdx[i] * 3]);
+		for(int j = 0; j < 3; ++j)
+			subMeshTriangles[i * 3 + j] = vtxsIdx[j] - firstVertex;
+	}
+	subMesh.ShareBuffers(_fullMesh.GetVertices(), _fullMesh.GetNormals(), firstVertex, lastVertex - firstVertex + 1);
+}
+
 void VisitorBuildAndCollectSubMeshes::VisitLeave(OctreeCell& cell)
 {
 	if(cell.IsRoot())
@@ -130,6 +322,16 @@ void VisitorBuildAndCollectSubMeshes::VisitLeave(OctreeCell& cell)
 		_subMeshesIds.clear();
 		for(auto subMeshEntry : _subMeshes)
 			_subMeshesIds.push_back(subMeshEntry.first);
+		// Keep track of shared windows growth
+		if(_shareFullMeshBuffers)
+		{
+			_sharedWindowsVerticesCount = 0;
+			for(auto subMeshEntry : _subMeshes)
+				_sharedWindowsVerticesCount += subMeshEntry.second->GetVerticesCount();
+			if(_hasToRebuildAll)
+				_sharedWindowsVerticesCountAfterRebuildAll = _sharedWindowsVerticesCount;
+		}
+		_hasToRebuildAll = false;
 		// Clear VTX_STATE_HAS_TO_RECOMPUTE_SUB_MESH on all fullmesh vertices
 		_fullMesh.ClearAllVerticesToUpdateInSubMesh();
 	}
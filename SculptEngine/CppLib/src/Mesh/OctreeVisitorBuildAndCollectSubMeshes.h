@@ -6,31 +6,67 @@
 #include <set>
 #include <memory>
 #include "OctreeVisitor.h"
+#include "IndexListsPool.h"
 
 class Mesh;
 class SubMesh;
 
+const unsigned int DEFAULT_SUB_MESH_MAX_VERTICES = 16384;	// Fits 16 bits indices, and is small enough for a stroke not to rebuild too much geometry
+
 // VisitorBuildAndCollectSubMeshes is for the moment only used to inject a split mesh into unity(due to its limit at 64K vertices per mesh)
+// A sub mesh gathers the triangles of a whole octree branch, the largest one that can't exceed the sub meshes max vertices count (or of a single leaf if the max is zero).
+// So octree leaves can be kept small for the queries while sub meshes stay big enough to limit draw calls.
 class VisitorBuildAndCollectSubMeshes : public OctreeVisitor
 {
 public:
-	VisitorBuildAndCollectSubMeshes(Mesh& fullMesh): OctreeVisitor(), _fullMesh(fullMesh) {}
+	VisitorBuildAndCollectSubMeshes(Mesh& fullMesh): OctreeVisitor(), _fullMesh(fullMesh), _maxVertices(DEFAULT_SUB_MESH_MAX_VERTICES), _shareFullMeshBuffers(false), _hasToRebuildAll(false), _sharedWindowsVerticesCount(0), _sharedWindowsVerticesCountAfterRebuildAll(0) {}
 	VisitorBuildAndCollectSubMeshes(Mesh& fullMesh, VisitorBuildAndCollectSubMeshes const& cloneFrom);
 	
 	virtual bool HasToVisit(OctreeCell& cell);
 	virtual void VisitEnter(OctreeCell& cell);
 	virtual void VisitLeave(OctreeCell& cell);
+	virtual VISITOR_PARALLELISM GetParallelism() const { return VISITOR_CELL_INDEPENDENT; }	// Sub meshes map accesses are serialized, each cell builds its own sub mesh
+	void SelectSubMeshesCells(OctreeCell const& root);	// To call before each traverse: picks the cells gathering their branch into a sub mesh
 	
 	unsigned int GetSubMeshCount() const { return (unsigned int) _subMeshesIds.size();  }
 	SubMesh const* GetSubMesh(unsigned int index) const { return _subMeshes.at(_subMeshesIds[index]).get(); }
 	SubMesh* GrabSubMesh(unsigned int index) { return _subMeshes.at(_subMeshesIds[index]).get(); }
 	bool IsSubMeshExist(unsigned int subMeshID) const { return _subMeshes.find(subMeshID) != _subMeshes.end(); }
 
+	void SetHasToRebuildAll() { _hasToRebuildAll = true; }	// On next traverse, even sub meshes of untouched cells will be rebuilt
+	void RemapFullMeshVerticesIdx();	// The full mesh renumbered its vertices (pending new indices are set), follow it without rebuilding copies
+	void SetShareFullMeshBuffers(bool shareBuffers) { _shareFullMeshBuffers = shareBuffers; _hasToRebuildAll = true; }
+	bool IsSharingFullMeshBuffers() const { return _shareFullMeshBuffers; }
+	bool IsSharedBuffersFragmented() const { return _sharedWindowsVerticesCount > _sharedWindowsVerticesCountAfterRebuildAll + (_sharedWindowsVerticesCountAfterRebuildAll / 2); }	// Windows grew by more than 50% since vertices were last reordered
+	void SetMaxVertices(unsigned int maxVertices) { _maxVertices = maxVertices; }	// Zero for one sub mesh per octree leaf
+	unsigned int GetMaxVertices() const { return _maxVertices; }
+
 private:
+	enum SUB_MESH_CELL_ROLE
+	{
+		SUB_MESH_CELL_ABOVE,	// Its branch is split into several sub meshes
+		SUB_MESH_CELL_ROOT,	// Gathers its branch into one sub mesh
+		SUB_MESH_CELL_INSIDE	// Part of a branch gathered by one of its parents
+	};
+
+	unsigned int CountBranchTriangles(OctreeCell const& cell);
+	void SetCellsRole(OctreeCell const& cell, SUB_MESH_CELL_ROLE role);	// "role" is given to the cell and, if inside, to its whole branch
+	unsigned int GetAndClearBranchStateFlags(OctreeCell& cell, unsigned int flags);
+	bool PatchSubMesh(IndexList trianglesIdx, SubMesh& subMesh, unsigned int prevVersionNumber);	// Returns false if the triangles topology changed, then the sub mesh has to be rebuilt
+	void RebuildSubMesh(IndexList trianglesIdx, SubMesh& subMesh);
+	void RebuildSharedSubMesh(IndexList trianglesIdx, SubMesh& subMesh);
+
 	Mesh& _fullMesh;
+	unsigned int _maxVertices;
+	std::vector<unsigned int> _cellsBranchTrisCount;	// Per octree cell index
+	std::vector<unsigned char> _cellsRole;	// SUB_MESH_CELL_ROLE per octree cell index
 	std::map<unsigned int, std::shared_ptr<SubMesh>> _subMeshes;
 	std::vector<unsigned int> _subMeshesIds;
 	std::set<unsigned int> _subMeshesToDelete;	// Will store the mesh that are detected as deleted, to be able to clean our data in "EndTraverse()"
+	bool _shareFullMeshBuffers;
+	bool _hasToRebuildAll;
+	size_t _sharedWindowsVerticesCount;	// Sum of all sub meshes windows size, to detect fragmentation
+	size_t _sharedWindowsVerticesCountAfterRebuildAll;
 };
 
 #endif // _OCTREE_VISITOR_BUILDANDCOLLECTSUBMESHES_H_
\ No newline at end of file
@@ -3,14 +3,13 @@
 #include "Mesh.h"
 #include "ThicknessHandler.h"
 
-OctreeVisitorCollectVertices::OctreeVisitorCollectVertices(Mesh const& mesh, Vector3 const& rangeCenterPoint, float rangeRadius, Vector3 const* selectDirection, float cosAngleLimit, bool dirtyOctreeCells, bool collectRejected, ThicknessHandler& thicknessHandler): OctreeVisitor(), _mesh(mesh), _rangeSphere(rangeCenterPoint, rangeRadius), _rangeRadiusSquared(rangeRadius * rangeRadius), _selectDirection(selectDirection), _dirtyOctreeCells(dirtyOctreeCells), _collectRejected(collectRejected), _cosAngleLimit(cosAngleLimit), _thicknessHandler(thicknessHandler)
+OctreeVisitorCollectVertices::OctreeVisitorCollectVertices(Mesh const& mesh, Vector3 const& rangeCenterPoint, float rangeRadius, Vector3 const* selectDirection, float cosAngleLimit, bool dirtyOctreeCells, bool collectRejected, ThicknessHandler& thicknessHandler): OctreeVisitor(), _mesh(mesh), _rangeSphere(rangeCenterPoint, rangeRadius), _rangeRadiusSquared(rangeRadius * rangeRadius), _selectDirection(selectDirection), _collectedVertices(mesh.GrabScratchArena().GrabIndexBuffer()), _rejectedVertices(mesh.GrabScratchArena().GrabIndexBuffer()), _dirtyOctreeCells(dirtyOctreeCells), _collectRejected(collectRejected), _cosAngleLimit(cosAngleLimit), _thicknessHandler(thicknessHandler)
+{
+	ASSERT(!_collectRejected || (_selectDirection != nullptr));
+}
+
+OctreeVisitorCollectVertices::OctreeVisitorCollectVertices(OctreeVisitorCollectVertices const& otherVisitor): OctreeVisitor(), _mesh(otherVisitor._mesh), _rangeSphere(otherVisitor._rangeSphere), _rangeRadiusSquared(otherVisitor._rangeRadiusSquared), _selectDirection(otherVisitor._selectDirection), _collectedVertices(otherVisitor._mesh.GrabScratchArena().GrabIndexBuffer()), _rejectedVertices(otherVisitor._mesh.GrabScratchArena().GrabIndexBuffer()), _dirtyOctreeCells(otherVisitor._dirtyOctreeCells), _collectRejected(otherVisitor._collectRejected), _cosAngleLimit(otherVisitor._cosAngleLimit), _thicknessHandler(otherVisitor._thicknessHandler)
 {
-	_collectedVertices.reserve(mesh.GetVertices().size());
-	if(_collectRejected)
-	{
-		ASSERT(_selectDirection != nullptr);
-		_rejectedVertices.reserve(mesh.GetVertices().size());
-	}
 }
 
 bool OctreeVisitorCollectVertices::HasToVisit(OctreeCell& cell)
@@ -24,8 +23,8 @@ void OctreeVisitorCollectVertices::VisitEnter(OctreeCell& cell)
 	{
 		if(_dirtyOctreeCells)
 		{
-			cell.AddStateFlags(CELL_STATE_HASTO_UPDATE_SUB_MESH | CELL_STATE_HASTO_EXTRACT_OUTOFBOUNDS_GEOM);
-			cell.AddStateFlagsUpToRoot(CELL_STATE_HASTO_RECOMPUTE_BBOX);
+			cell.AddStateFlags(CELL_STATE_HASTO_PATCH_SUB_MESH | CELL_STATE_HASTO_EXTRACT_OUTOFBOUNDS_GEOM);	// Vertices only move, topology changes are flagged by retessellation and octree updates
+			cell.AddStateFlagsUpToRoot(CELL_STATE_HASTO_GROW_BBOX);
 		}
 		std::vector<Vector3> const& vertices = _mesh.GetVertices();
 		if(_selectDirection != nullptr)
@@ -57,6 +56,13 @@ void OctreeVisitorCollectVertices::VisitEnter(OctreeCell& cell)
 	}
 }
 
+void OctreeVisitorCollectVertices::MergeThreadCopy(OctreeVisitor& threadCopy)
+{
+	OctreeVisitorCollectVertices& copy = static_cast<OctreeVisitorCollectVertices&>(threadCopy);
+	_collectedVertices.insert(_collectedVertices.end(), copy._collectedVertices.begin(), copy._collectedVertices.end());
+	_rejectedVertices.insert(_rejectedVertices.end(), copy._rejectedVertices.begin(), copy._rejectedVertices.end());
+}
+
 Vector3 OctreeVisitorCollectVertices::ComputeAveragePosition() const
 {
 	Vector3 verticesAccumulator;
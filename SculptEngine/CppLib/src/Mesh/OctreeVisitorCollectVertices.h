@@ -16,6 +16,13 @@ public:
 	virtual bool HasToVisit(OctreeCell& cell);
 	virtual void VisitEnter(OctreeCell& cell);
 	virtual void VisitLeave(OctreeCell& /*cell*/) {}
+#ifdef THICKNESS_HANDLER_WIP
+	virtual VISITOR_PARALLELISM GetParallelism() const { return VISITOR_SEQUENTIAL; }	// Thickness handler test list is shared
+#else
+	virtual VISITOR_PARALLELISM GetParallelism() const { return VISITOR_REDUCEABLE; }
+#endif // THICKNESS_HANDLER_WIP
+	virtual OctreeVisitor* CreateThreadCopy() const { return new OctreeVisitorCollectVertices(*this); }
+	virtual void MergeThreadCopy(OctreeVisitor& threadCopy);
 
 	std::vector<unsigned int> const& GetVertices() const { return _collectedVertices; }
 	std::vector<unsigned int> const& GetRejectedVertices() const { return _rejectedVertices; }
@@ -23,13 +30,15 @@ public:
 	Vector3 ComputeAverageNormal() const;
 
 private:
+	OctreeVisitorCollectVertices(OctreeVisitorCollectVertices const& otherVisitor);	// Copies the settings, not the collected vertices
+
 	Mesh const& _mesh;
 	BSphere _rangeSphere;
 	Vector3 const * const _selectDirection;
 	float _rangeRadiusSquared;
 	float _cosAngleLimit;
-	std::vector<unsigned int> _collectedVertices;
-	std::vector<unsigned int> _rejectedVertices;
+	std::vector<unsigned int>& _collectedVertices;	// Buffers from the mesh scratch arena
+	std::vector<unsigned int>& _rejectedVertices;
 	bool _dirtyOctreeCells;
 	bool _collectRejected;
 	ThicknessHandler& _thicknessHandler;
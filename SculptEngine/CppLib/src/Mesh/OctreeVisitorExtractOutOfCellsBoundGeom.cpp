@@ -16,3 +16,10 @@ void VisitorExtractOutOfCellsBoundGeom::VisitEnter(OctreeCell& cell)
 		cell.ExtractOutOfBoundsGeom(_mesh, _extractedTris, _extractedVtxs);
 	}
 }
+
+void VisitorExtractOutOfCellsBoundGeom::MergeThreadCopy(OctreeVisitor& threadCopy)
+{
+	VisitorExtractOutOfCellsBoundGeom& copy = static_cast<VisitorExtractOutOfCellsBoundGeom&>(threadCopy);
+	_extractedTris.insert(_extractedTris.end(), copy._extractedTris.begin(), copy._extractedTris.end());
+	_extractedVtxs.insert(_extractedVtxs.end(), copy._extractedVtxs.begin(), copy._extractedVtxs.end());
+}
@@ -13,6 +13,9 @@ public:
 	virtual bool HasToVisit(OctreeCell& cell);
 	virtual void VisitEnter(OctreeCell& cell);
 	virtual void VisitLeave(OctreeCell& /*cell*/) {}
+	virtual VISITOR_PARALLELISM GetParallelism() const { return VISITOR_REDUCEABLE; }
+	virtual OctreeVisitor* CreateThreadCopy() const { return new VisitorExtractOutOfCellsBoundGeom(_mesh, _extractFromAllCells); }
+	virtual void MergeThreadCopy(OctreeVisitor& threadCopy);
 
 	std::vector<unsigned int> const& GetExtractedTris() { return _extractedTris; }
 	std::vector<unsigned int> const& GetExtractedVtxs() { return _extractedVtxs; }
@@ -0,0 +1,41 @@
+﻿#include "OctreeVisitorGetClosestIntersection.h"
+#include "Octree.h"
+#include "Mesh.h"
+#include "RayKernels.h"
+
+bool VisitorGetClosestIntersection::HasToVisit(OctreeCell& cell)
+{
+	return _ray.Intersects(cell.GetContentBBox());
+}
+
+bool VisitorGetClosestIntersection::GetEntryDistance(OctreeCell& cell, float& entryDistance)
+{
+	return _ray.Intersects(cell.GetContentBBox(), entryDistance);
+}
+
+void VisitorGetClosestIntersection::VisitEnter(OctreeCell& cell)
+{
+	IndexList trisIdx = cell.GetTrianglesIdx();
+	if(trisIdx.empty())
+		return;
+	if(_hitTrisIdx.size() < trisIdx.size())
+	{
+		_hitTrisIdx.resize(trisIdx.size());
+		_hitDistances.resize(trisIdx.size());
+	}
+	RayTrisJob job = { _vertices.data(), _triangles.data(), _trisBSphere.data(), trisIdx.begin(), trisIdx.size(), _cullBackFace };
+	unsigned int nbHits = IntersectRayTriangles(_ray, job, _hitTrisIdx.data(), _hitDistances.data());
+	for(unsigned int i = 0; i < nbHits; ++i)
+	{
+		unsigned int triIndex = _hitTrisIdx[i];
+		float distance = _hitDistances[i];
+		if(_mesh.IsTriangleToBeRemoved(triIndex) || (distance > _ray.GetLength()))
+			continue;	// The ray was shortened by a previous hit of the cell
+		// On a tie (hit on a shared edge), keep the lowest triangle index so that the result doesn't depend on the visit order
+		if(!HasIntersection() || (distance < _ray.GetLength()) || (triIndex < _closestTriangle))
+		{
+			_ray.SetLength(distance);
+			_closestTriangle = triIndex;
+		}
+	}
+}
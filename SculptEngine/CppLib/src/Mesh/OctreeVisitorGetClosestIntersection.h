@@ -0,0 +1,36 @@
+﻿#ifndef _OCTREE_VISITOR_GETCLOSESTINTERSECTION_H_
+#define _OCTREE_VISITOR_GETCLOSESTINTERSECTION_H_
+
+#include "OctreeVisitor.h"
+#include "Mesh.h"
+
+// Closest hit only, to be run with OctreeCell::TraverseFrontToBack: each hit shortens the ray, cells farther than the closest hit are skipped
+class VisitorGetClosestIntersection : public OctreeVisitor
+{
+public:
+	VisitorGetClosestIntersection(Mesh const& mesh, Ray const& ray, bool cullBackFace) : OctreeVisitor(), _mesh(mesh), _ray(ray), _cullBackFace(cullBackFace), _closestTriangle(UNDEFINED_NEW_ID), _vertices(_mesh.GetVertices()), _triangles(_mesh.GetTriangles()), _trisBSphere(_mesh.GetTrisBSphere()) {}
+	virtual bool HasToVisit(OctreeCell& cell);
+	virtual void VisitEnter(OctreeCell& cell);
+	virtual void VisitLeave(OctreeCell& /*cell*/) {}
+
+	// Front to back traverse related
+	virtual bool GetEntryDistance(OctreeCell& cell, float& entryDistance);
+	virtual bool IsInRange(float entryDistance) const { return entryDistance <= _ray.GetLength(); }
+
+	bool HasIntersection() const { return _closestTriangle != UNDEFINED_NEW_ID; }
+	float GetClosestDist() const { return _ray.GetLength(); }
+	unsigned int GetClosestTriangle() const { return _closestTriangle; }
+
+private:
+	Mesh const& _mesh;
+	Ray _ray;	// Its length is shrunk to the closest intersection found so far
+	bool _cullBackFace;
+	unsigned int _closestTriangle;
+	std::vector<unsigned int> _hitTrisIdx;	// Ray kernel output, for one cell
+	std::vector<float> _hitDistances;
+	std::vector<Vector3> const& _vertices;
+	std::vector<unsigned int> const& _triangles;
+	std::vector<BSphere> const& _trisBSphere;
+};
+
+#endif // _OCTREE_VISITOR_GETCLOSESTINTERSECTION_H_
\ No newline at end of file
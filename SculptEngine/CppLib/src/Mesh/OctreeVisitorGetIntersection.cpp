@@ -1,6 +1,7 @@
 ﻿#include "OctreeVisitorGetIntersection.h"
 #include "Octree.h"
 #include "Mesh.h"
+#include "RayKernels.h"
 
 bool VisitorGetIntersection::HasToVisit(OctreeCell& cell)
 {
@@ -9,20 +10,24 @@ bool VisitorGetIntersection::HasToVisit(OctreeCell& cell)
 
 void VisitorGetIntersection::VisitEnter(OctreeCell& cell)
 {
-	if(!cell.GetTrianglesIdx().empty() || !cell.GetVerticesIdx().empty())
+	IndexList trisIdx = cell.GetTrianglesIdx();
+	if(!trisIdx.empty())
 	{
-		for(int triIndex : cell.GetTrianglesIdx())
+		if(_hitTrisIdx.size() < trisIdx.size())
 		{
-			if((!_mesh.IsTriangleToBeRemoved(triIndex) || _intersectTriToRemove) && _ray.Intersects(_trisBSphere[triIndex]))
+			_hitTrisIdx.resize(trisIdx.size());
+			_hitDistances.resize(trisIdx.size());
+		}
+		RayTrisJob job = { _vertices.data(), _triangles.data(), _trisBSphere.data(), trisIdx.begin(), trisIdx.size(), _cullBackFace };
+		unsigned int nbHits = IntersectRayTriangles(_ray, job, _hitTrisIdx.data(), _hitDistances.data());
+		for(unsigned int i = 0; i < nbHits; ++i)
+		{
+			unsigned int triIndex = _hitTrisIdx[i];
+			if(!_mesh.IsTriangleToBeRemoved(triIndex) || _intersectTriToRemove)	// Rarely hit, cheaper to filter after the test
 			{
-				float distance = -1;
-				unsigned int const* vtxsIdx = &(_triangles[triIndex * 3]);
-				if(_ray.Intersects(_vertices[vtxsIdx[0]], _vertices[vtxsIdx[1]], _vertices[vtxsIdx[2]], distance, _cullBackFace))
-				{
-					//DEBUG_intersectionPoints.push_back(ray.GetOrigin() + ray.GetDirection() * distance);
-					_intersectionDists.push_back(distance);
-					_intersectionTriangles.push_back(triIndex);
-				}
+				//DEBUG_intersectionPoints.push_back(ray.GetOrigin() + ray.GetDirection() * distance);
+				_intersectionDists.push_back(_hitDistances[i]);
+				_intersectionTriangles.push_back(triIndex);
 			}
 		}
 	}
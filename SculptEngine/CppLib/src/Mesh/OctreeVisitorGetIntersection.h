@@ -8,7 +8,7 @@
 class VisitorGetIntersection : public OctreeVisitor
 {
 public:
-	VisitorGetIntersection(Mesh const& mesh, Ray const& ray, bool cullBackFace, bool intersectTriToRemove) : OctreeVisitor(), _mesh(mesh), _ray(ray), _cullBackFace(cullBackFace), _intersectTriToRemove(intersectTriToRemove), _vertices(_mesh.GetVertices()), _triangles(_mesh.GetTriangles()), _trisBSphere(_mesh.GetTrisBSphere()) {}
+	VisitorGetIntersection(Mesh const& mesh, Ray const& ray, bool cullBackFace, bool intersectTriToRemove) : OctreeVisitor(), _mesh(mesh), _ray(ray), _cullBackFace(cullBackFace), _intersectTriToRemove(intersectTriToRemove), _intersectionDists(mesh.GrabScratchArena().GrabFloatBuffer()), _intersectionTriangles(mesh.GrabScratchArena().GrabIndexBuffer()), _hitTrisIdx(mesh.GrabScratchArena().GrabIndexBuffer()), _hitDistances(mesh.GrabScratchArena().GrabFloatBuffer()), _vertices(_mesh.GetVertices()), _triangles(_mesh.GetTriangles()), _trisBSphere(_mesh.GetTrisBSphere()) {}
 	virtual bool HasToVisit(OctreeCell& cell);
 	virtual void VisitEnter(OctreeCell& cell);
 	virtual void VisitLeave(OctreeCell& /*cell*/) {}
@@ -22,8 +22,10 @@ private:
 	Ray const& _ray;
 	bool _cullBackFace;
 	bool _intersectTriToRemove;
-	std::vector<float> _intersectionDists;
-	std::vector<unsigned int> _intersectionTriangles;
+	std::vector<float>& _intersectionDists;	// Buffers from the mesh scratch arena
+	std::vector<unsigned int>& _intersectionTriangles;
+	std::vector<unsigned int>& _hitTrisIdx;	// Ray kernel output, for one cell
+	std::vector<float>& _hitDistances;
 	std::vector<Vector3> const& _vertices;
 	std::vector<unsigned int> const& _triangles;
 	std::vector<BSphere> const& _trisBSphere;
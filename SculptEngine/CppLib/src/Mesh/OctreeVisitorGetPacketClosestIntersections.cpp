@@ -0,0 +1,56 @@
+﻿#include "OctreeVisitorGetPacketClosestIntersections.h"
+#include "Octree.h"
+#include "Mesh.h"
+
+bool VisitorGetPacketClosestIntersections::HasToVisit(OctreeCell& cell)
+{
+	float entryDistance;
+	return GetEntryDistance(cell, entryDistance);
+}
+
+bool VisitorGetPacketClosestIntersections::GetEntryDistance(OctreeCell& cell, float& entryDistance)
+{
+	return _packet.GetRaysReaching(cell.GetContentBBox(), _packet.GetAllRaysMask(), entryDistance) != 0;
+}
+
+void VisitorGetPacketClosestIntersections::VisitEnter(OctreeCell& cell)
+{
+	IndexList trisIdx = cell.GetTrianglesIdx();
+	if(trisIdx.empty())
+		return;
+	float entryDistance;
+	unsigned int raysMask = _packet.GetRaysReaching(cell.GetContentBBox(), _packet.GetAllRaysMask(), entryDistance);	// Only these rays are tested against the cell triangles
+	if(raysMask == 0)
+		return;
+	if(_hitTrisIdx.size() < trisIdx.size())
+	{
+		_hitTrisIdx.resize(trisIdx.size());
+		_hitDistances.resize(trisIdx.size());
+	}
+	bool hasShrunk = false;
+	for(unsigned int rayIdx = 0; rayIdx < _packet.GetNbRays(); ++rayIdx)
+	{
+		if((raysMask & (1u << rayIdx)) == 0)
+			continue;
+		Ray const& ray = _packet.GetRay(rayIdx);
+		unsigned int& closestTriangle = _closestTriangles[rayIdx];
+		RayTrisJob job = { _vertices.data(), _triangles.data(), _trisBSphere.data(), trisIdx.begin(), trisIdx.size(), _cullBackFace };
+		unsigned int nbHits = IntersectRayTriangles(ray, job, _hitTrisIdx.data(), _hitDistances.data());
+		for(unsigned int i = 0; i < nbHits; ++i)
+		{
+			unsigned int triIndex = _hitTrisIdx[i];
+			float distance = _hitDistances[i];
+			if(_mesh.IsTriangleToBeRemoved(triIndex) || (distance > ray.GetLength()))
+				continue;	// The ray was shortened by a previous hit of the cell
+			// On a tie, keep the lowest triangle index (same as VisitorGetClosestIntersection)
+			if((closestTriangle == UNDEFINED_NEW_ID) || (distance < ray.GetLength()) || (triIndex < closestTriangle))
+			{
+				_packet.SetRayLength(rayIdx, distance);
+				closestTriangle = triIndex;
+				hasShrunk = true;
+			}
+		}
+	}
+	if(hasShrunk)
+		_maxLength = _packet.GetMaxLength(_packet.GetAllRaysMask());
+}
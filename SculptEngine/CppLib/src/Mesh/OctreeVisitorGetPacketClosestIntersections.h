@@ -0,0 +1,43 @@
+﻿#ifndef _OCTREE_VISITOR_GETPACKETCLOSESTINTERSECTIONS_H_
+#define _OCTREE_VISITOR_GETPACKETCLOSESTINTERSECTIONS_H_
+
+#include "OctreeVisitor.h"
+#include "Mesh.h"
+#include "RayKernels.h"
+
+// Closest hit of each ray of a packet (up to RAY_PACKET_SIZE rays), in a single OctreeCell::TraverseFrontToBack.
+// A cell is entered if any ray of the packet reaches it, then only the rays reaching it are tested against its triangles. Results are the same as VisitorGetClosestIntersection run on each ray.
+class VisitorGetPacketClosestIntersections : public OctreeVisitor
+{
+public:
+	VisitorGetPacketClosestIntersections(Mesh const& mesh, Ray const* rays, unsigned int nbRays, bool cullBackFace) : OctreeVisitor(), _mesh(mesh), _packet(rays, nbRays), _maxLength(_packet.GetMaxLength(_packet.GetAllRaysMask())), _cullBackFace(cullBackFace), _vertices(_mesh.GetVertices()), _triangles(_mesh.GetTriangles()), _trisBSphere(_mesh.GetTrisBSphere())
+	{
+		for(unsigned int rayIdx = 0; rayIdx < RAY_PACKET_SIZE; ++rayIdx)
+			_closestTriangles[rayIdx] = UNDEFINED_NEW_ID;
+	}
+	virtual bool HasToVisit(OctreeCell& cell);
+	virtual void VisitEnter(OctreeCell& cell);
+	virtual void VisitLeave(OctreeCell& /*cell*/) {}
+
+	// Front to back traverse related
+	virtual bool GetEntryDistance(OctreeCell& cell, float& entryDistance);
+	virtual bool IsInRange(float entryDistance) const { return entryDistance <= _maxLength; }
+
+	bool HasIntersection(unsigned int rayIdx) const { return _closestTriangles[rayIdx] != UNDEFINED_NEW_ID; }
+	float GetClosestDist(unsigned int rayIdx) const { return _packet.GetRay(rayIdx).GetLength(); }
+	unsigned int GetClosestTriangle(unsigned int rayIdx) const { return _closestTriangles[rayIdx]; }
+
+private:
+	Mesh const& _mesh;
+	RayPacket _packet;	// Rays length is shrunk to the closest intersection found so far
+	unsigned int _closestTriangles[RAY_PACKET_SIZE];
+	float _maxLength;	// Longest ray of the packet, cells farther than it are useless to all rays
+	bool _cullBackFace;
+	std::vector<unsigned int> _hitTrisIdx;	// Ray kernel output, for one cell and one ray
+	std::vector<float> _hitDistances;
+	std::vector<Vector3> const& _vertices;
+	std::vector<unsigned int> const& _triangles;
+	std::vector<BSphere> const& _trisBSphere;
+};
+
+#endif // _OCTREE_VISITOR_GETPACKETCLOSESTINTERSECTIONS_H_
@@ -12,6 +12,7 @@ public:
 	virtual bool HasToVisit(OctreeCell& cell);
 	virtual void VisitEnter(OctreeCell& cell);
 	virtual void VisitLeave(OctreeCell& cell);
+	virtual VISITOR_PARALLELISM GetParallelism() const { return VISITOR_CELL_INDEPENDENT; }
 
 private:
 	bool _doRemapping;	// Remapping of vertices and triangles is not necessary when we do recycling (i.e during all updates between start and end stroke)
@@ -2,26 +2,40 @@
 #include "Mesh.h"
 #include "Octree.h"
 
-bool VisitorRecomputeBBox::HasToVisit(OctreeCell& /*cell*/)
+bool VisitorRecomputeBBox::HasToVisit(OctreeCell& cell)
 {
-	return true;
+	return _forceAllCellRecomputing || cell.TestStateFlags(_cellsFlags);
 }
 
 void VisitorRecomputeBBox::VisitLeave(OctreeCell& cell)
 {
-	if(!cell.TestStateFlags(CELL_STATE_HASTO_RECOMPUTE_BBOX) && !_forceAllCellRecomputing)
+	if(!cell.TestStateFlags(_cellsFlags) && !_forceAllCellRecomputing)
 		return;
-	cell.ClearStateFlags(CELL_STATE_HASTO_RECOMPUTE_BBOX);
+	bool hasToRecompute = _forceAllCellRecomputing || cell.TestStateFlags(_cellsFlags & ~CELL_STATE_HASTO_GROW_BBOX);
+	cell.ClearStateFlags(_cellsFlags);
 	BBox& cellContentBBox = cell.GrabContentBBox();
-	cellContentBBox.Reset();
 	if(!cell.GetTrianglesIdx().empty() || !cell.GetVerticesIdx().empty())
 	{	// Leaf node: compute bbox using tessellation data
 		std::vector<Vector3> const& vertices = _mesh.GetVertices();
 		std::vector<unsigned int> const& triangles = _mesh.GetTriangles();
-		std::vector<unsigned int> const& cellTrianglesIdx = cell.GetTrianglesIdx();
-		if(cellTrianglesIdx.empty())	// Take in account vertices in case of no triangle are fitting in the cell (sometimes it happens)
+		IndexList cellTrianglesIdx = cell.GetTrianglesIdx();
+		bool withVertices = cellTrianglesIdx.empty() || (_mesh.GetOctreeLooseness() > 1.0f);	// Take in account vertices in case of no triangle are fitting in the cell (sometimes it happens, and often in a loose octree as triangles are placed by their centroid)
+		if(!hasToRecompute)
+		{	// Moved vertices already grew the bbox of the cells holding their triangles (see Mesh::GrowCellsContentBBox), only the vertices not covered by triangles are left
+			if(withVertices)
+			{	// Parents get the union of their children right after, so only this cell grows
+				BBox const previousBBox = cellContentBBox;
+				for(unsigned int vtxIdx : cell.GetVerticesIdx())
+					cellContentBBox.Encapsulate(vertices[vtxIdx]);
+				if(((cellContentBBox.Min() != previousBBox.Min()) || (cellContentBBox.Max() != previousBBox.Max())) && !cell.TestStateFlags(CELL_STATE_HASTO_SHRINK_BBOX))
+					cell.AddStateFlagsUpToRoot(CELL_STATE_HASTO_SHRINK_BBOX);
+			}
+			return;
+		}
+		cellContentBBox.Reset();
+		if(withVertices)
 		{
-			std::vector<unsigned int> const& cellVerticesIdx = cell.GetVerticesIdx();
+			IndexList cellVerticesIdx = cell.GetVerticesIdx();
 			for(int const& vtxIdx : cellVerticesIdx)
 				cellContentBBox.Encapsulate(vertices[vtxIdx]);
 		}
@@ -35,14 +49,14 @@ void VisitorRecomputeBBox::VisitLeave(OctreeCell& cell)
 	else
 	{	// Non leaf node: compute bbox using children bbox
 		ASSERT(cell.HasChildren());
+		cellContentBBox.Reset();
 		if(cell.HasChildren())
 		{
 			ASSERT(cell.GetTrianglesIdx().empty() && cell.GetVerticesIdx().empty());
-			std::vector<std::unique_ptr<OctreeCell>> const& cellChildren = cell.GetChildren();
-			for(std::unique_ptr<OctreeCell> const& childCell : cellChildren)
+			for(unsigned int childPos = 0; childPos < 8; ++childPos)
 			{
-				if(childCell != nullptr)
-					cellContentBBox.Encapsulate(childCell->GetContentBBox());
+				if(cell.HasChild(childPos))
+					cellContentBBox.Encapsulate(cell.GetChild(childPos).GetContentBBox());
 			}
 		}
 	}
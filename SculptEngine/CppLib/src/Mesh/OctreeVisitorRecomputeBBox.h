@@ -2,20 +2,26 @@
 #define _OCTREE_VISITOR_RECOMPUTEBBOX_H_
 
 #include "OctreeVisitor.h"
+#include "Octree.h"
 
 class Mesh;
 
+// Only goes through the flagged cells (flags are set up to the root).
+// Cells which content changed are recomputed, the ones which vertices only moved are grown (see CELL_STATE_HASTO_GROW_BBOX), unless shrinking the grown ones back to their content.
 class VisitorRecomputeBBox : public OctreeVisitor
 {
 public:
-	VisitorRecomputeBBox(Mesh const& mesh, bool forceAllCellRecomputing) : OctreeVisitor(), _mesh(mesh), _forceAllCellRecomputing(forceAllCellRecomputing) {}
+	VisitorRecomputeBBox(Mesh const& mesh, bool forceAllCellRecomputing, bool shrinkGrownCells = false) : OctreeVisitor(), _mesh(mesh), _forceAllCellRecomputing(forceAllCellRecomputing),
+		_cellsFlags(CELL_STATE_HASTO_RECOMPUTE_BBOX | CELL_STATE_HASTO_GROW_BBOX | ((shrinkGrownCells || forceAllCellRecomputing) ? CELL_STATE_HASTO_SHRINK_BBOX : 0)) {}
 	virtual bool HasToVisit(OctreeCell& cell);
 	virtual void VisitEnter(OctreeCell& /*cell*/) {}
 	virtual void VisitLeave(OctreeCell& cell);
+	virtual VISITOR_PARALLELISM GetParallelism() const { return VISITOR_CELL_INDEPENDENT; }	// Children are left before their parent, so their bbox is ready
 
 private:
 	Mesh const& _mesh;
 	bool _forceAllCellRecomputing;
+	unsigned int _cellsFlags;	// Flags of the cells to visit
 };
 
 #endif // _OCTREE_VISITOR_RECOMPUTEBBOX_H_
\ No newline at end of file
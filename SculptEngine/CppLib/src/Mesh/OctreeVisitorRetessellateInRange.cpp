@@ -28,7 +28,7 @@ void VisitorRetessellateInRange::VisitEnter(OctreeCell& cell)
 					HandleCrushedTriangle(retessellate.GetGenratedTris()[i]);
 #endif // MULTI_PASS_RETESS
 				// Handle cell triangles
-				std::vector<unsigned int> const& cellTrianglesIdx = cell.GetTrianglesIdx();
+				IndexList cellTrianglesIdx = cell.GetTrianglesIdx();
 				for(unsigned int triIdx : cellTrianglesIdx)
 					HandleCrushedTriangle(triIdx);
 				somethingWasModified = somethingWasModified || retessellate.WasSomethingSubdivided();
@@ -46,7 +46,7 @@ void VisitorRetessellateInRange::VisitEnter(OctreeCell& cell)
 				for(unsigned int i = nbNewTriBeforeBegin; i < nbGenTrisBeforeLoop; ++i)
 					HandleTriangleMerge(retessellate.GetGenratedTris()[i]);
 				// Handle cell triangles
-				std::vector<unsigned int> const& cellTrianglesIdx = cell.GetTrianglesIdx();
+				IndexList cellTrianglesIdx = cell.GetTrianglesIdx();
 				for(unsigned int triIdx : cellTrianglesIdx)
 					HandleTriangleMerge(triIdx);
 				somethingWasModified = somethingWasModified || retessellate.WasSomethingMerged();
@@ -64,7 +64,7 @@ void VisitorRetessellateInRange::VisitEnter(OctreeCell& cell)
 				for(unsigned int i = nbNewTriBeforeBegin; i < nbGenTrisBeforeLoop; ++i)
 					HandleTriangleSubdiv(retessellate.GetGenratedTris()[i], true, true);
 				// Handle cell triangles
-				std::vector<unsigned int> const& cellTrianglesIdx = cell.GetTrianglesIdx();
+				IndexList cellTrianglesIdx = cell.GetTrianglesIdx();
 				for(unsigned int triIdx : cellTrianglesIdx)
 					HandleTriangleSubdiv(triIdx, true, true);
 				somethingWasModified = somethingWasModified || retessellate.WasSomethingSubdivided();
@@ -77,7 +77,8 @@ void VisitorRetessellateInRange::VisitEnter(OctreeCell& cell)
 		// If we modified something, setup update flags accordingly
 		if(retessellate.WasSomethingSubdivided() || retessellate.WasSomethingMerged())
 		{
-			cell.AddStateFlags(CELL_STATE_HASTO_UPDATE_SUB_MESH | CELL_STATE_HASTO_EXTRACT_OUTOFBOUNDS_GEOM);
+			// Submesh is rebuilt only if this cell topology changed, otherwise patching will detect changes made from neighbour cells
+			cell.AddStateFlags((somethingWasModified ? CELL_STATE_HASTO_UPDATE_SUB_MESH : CELL_STATE_HASTO_PATCH_SUB_MESH) | CELL_STATE_HASTO_EXTRACT_OUTOFBOUNDS_GEOM);
 			cell.AddStateFlagsUpToRoot(CELL_STATE_HASTO_RECOMPUTE_BBOX);
 		}
 	}
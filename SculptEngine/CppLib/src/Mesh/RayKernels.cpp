@@ -0,0 +1,219 @@
+﻿#include "RayKernels.h"
+#include <float.h>
+
+namespace
+{
+	template <class S>
+	unsigned int IntersectRayTrianglesT(Ray const& ray, RayTrisJob const& job, unsigned int* hitTrisIdx, float* hitDistances)
+	{
+		typedef typename S::Float Float;
+		typedef typename S::Mask Mask;
+		const unsigned int W = S::Width;
+		const unsigned int allLanes = (1 << W) - 1;
+		// Triangles are gathered "Width" by "Width" into aligned SoA lanes (the last block being padded with its first triangle), their bounding sphere first then their vertices only if needed
+		alignas(32) float laneIn[13][W];	// x1, y1, z1, x2, y2, z2, x3, y3, z3, bsphere center x, y, z, radius
+		alignas(32) float laneDistance[W];
+		Vector3 const& origin = ray.GetOrigin();
+		Vector3 const& direction = ray.GetDirection();
+		Float const ox = S::Set1(origin.x), oy = S::Set1(origin.y), oz = S::Set1(origin.z);
+		Float const dx = S::Set1(direction.x), dy = S::Set1(direction.y), dz = S::Set1(direction.z);
+		Float const length = S::Set1(ray.GetLength());
+		Float const zero = S::Set1(0.0f), one = S::Set1(1.0f);
+		Float const epsilon = S::Set1(EPSILON), minusEpsilon = S::Set1(-EPSILON);
+		bool const orientationInverted = SculptEngine::IsTriangleOrientationInverted();
+		unsigned int nbHits = 0;
+		for(unsigned int blockStart = 0; blockStart < job.nbTris; blockStart += W)
+		{
+			unsigned int nbLanes = min(W, job.nbTris - blockStart);
+			unsigned int lanesTriIdx[W];
+			for(unsigned int lane = 0; lane < W; ++lane)
+			{
+				unsigned int triIdx = job.trisIdx[blockStart + ((lane < nbLanes) ? lane : 0)];
+				lanesTriIdx[lane] = triIdx;
+				BSphere const& bsphere = job.trisBSphere[triIdx];
+				laneIn[9][lane] = bsphere.GetCenter().x;
+				laneIn[10][lane] = bsphere.GetCenter().y;
+				laneIn[11][lane] = bsphere.GetCenter().z;
+				laneIn[12][lane] = bsphere.GetRadius();
+			}
+			// Bounding sphere first (as Ray::Intersects(BSphere)), the lanes are tested in "reject" form to behave as the scalar code on NaNs
+			Float lx = S::Sub(S::Load(laneIn[9]), ox), ly = S::Sub(S::Load(laneIn[10]), oy), lz = S::Sub(S::Load(laneIn[11]), oz);
+			Float tca = S::Add(S::Add(S::Mul(lx, dx), S::Mul(ly, dy)), S::Mul(lz, dz));
+			Float d2 = S::Sub(S::Add(S::Add(S::Mul(lx, lx), S::Mul(ly, ly)), S::Mul(lz, lz)), S::Mul(tca, tca));
+			Float radius = S::Load(laneIn[12]);
+			Float squaredRadius = S::Mul(radius, radius);
+			Mask reject = S::Or(S::CmpLt(tca, zero), S::CmpGt(d2, squaredRadius));
+			reject = S::Or(reject, S::CmpLt(length, S::Sub(tca, S::Sqrt(S::Sub(squaredRadius, d2)))));
+			if((S::MoveMask(reject) & allLanes) == allLanes)
+				continue;	// Most blocks stop here, without having read their vertices
+			for(unsigned int lane = 0; lane < W; ++lane)
+			{
+				unsigned int const* vtxsIdx = &(job.triangles[lanesTriIdx[lane] * 3]);
+				for(unsigned int k = 0; k < 3; ++k)
+				{
+					Vector3 const& vtx = job.vertices[vtxsIdx[k]];
+					laneIn[k * 3][lane] = vtx.x;
+					laneIn[k * 3 + 1][lane] = vtx.y;
+					laneIn[k * 3 + 2][lane] = vtx.z;
+				}
+			}
+			// Möller–Trumbore (as Ray::Intersects(V1, V2, V3))
+			Float x1 = S::Load(laneIn[0]), y1 = S::Load(laneIn[1]), z1 = S::Load(laneIn[2]);
+			Float e1x = S::Sub(S::Load(laneIn[3]), x1), e1y = S::Sub(S::Load(laneIn[4]), y1), e1z = S::Sub(S::Load(laneIn[5]), z1);
+			Float e2x = S::Sub(S::Load(laneIn[6]), x1), e2y = S::Sub(S::Load(laneIn[7]), y1), e2z = S::Sub(S::Load(laneIn[8]), z1);
+			Float px = S::Sub(S::Mul(dy, e2z), S::Mul(dz, e2y));
+			Float py = S::Sub(S::Mul(dz, e2x), S::Mul(dx, e2z));
+			Float pz = S::Sub(S::Mul(dx, e2y), S::Mul(dy, e2x));
+			Float det = S::Add(S::Add(S::Mul(e1x, px), S::Mul(e1y, py)), S::Mul(e1z, pz));
+			if(job.cullBackFace)
+				reject = S::Or(reject, orientationInverted ? S::CmpGt(det, minusEpsilon) : S::CmpLt(det, epsilon));
+			else
+				reject = S::Or(reject, S::And(S::CmpGt(det, minusEpsilon), S::CmpLt(det, epsilon)));
+			Float invDet = S::Div(one, det);
+			Float tx = S::Sub(ox, x1), ty = S::Sub(oy, y1), tz = S::Sub(oz, z1);
+			Float u = S::Mul(S::Add(S::Add(S::Mul(tx, px), S::Mul(ty, py)), S::Mul(tz, pz)), invDet);
+			reject = S::Or(reject, S::Or(S::CmpLt(u, zero), S::CmpGt(u, one)));
+			Float qx = S::Sub(S::Mul(ty, e1z), S::Mul(tz, e1y));
+			Float qy = S::Sub(S::Mul(tz, e1x), S::Mul(tx, e1z));
+			Float qz = S::Sub(S::Mul(tx, e1y), S::Mul(ty, e1x));
+			Float v = S::Mul(S::Add(S::Add(S::Mul(dx, qx), S::Mul(dy, qy)), S::Mul(dz, qz)), invDet);
+			reject = S::Or(reject, S::Or(S::CmpLt(v, zero), S::CmpGt(S::Add(u, v), one)));
+			Float t = S::Mul(S::Add(S::Add(S::Mul(e2x, qx), S::Mul(e2y, qy)), S::Mul(e2z, qz)), invDet);
+			unsigned int hitLanes = S::MoveMask(S::AndNot(reject, S::And(S::CmpGt(t, epsilon), S::CmpLe(t, length)))) & ((1 << nbLanes) - 1);
+			if(hitLanes == 0)
+				continue;
+			S::Store(laneDistance, t);
+			for(unsigned int lane = 0; lane < nbLanes; ++lane)
+			{
+				if(hitLanes & (1 << lane))
+				{
+					hitTrisIdx[nbHits] = lanesTriIdx[lane];
+					hitDistances[nbHits] = laneDistance[lane];
+					++nbHits;
+				}
+			}
+		}
+		return nbHits;
+	}
+}
+
+unsigned int IntersectRayTriangles(Ray const& ray, RayTrisJob const& job, unsigned int* hitTrisIdx, float* hitDistances)
+{
+	switch(GetSimdKernelType())
+	{
+#ifdef SIMD_AVX
+	case SIMD_KERNEL_AVX: return IntersectRayTrianglesT<SimdAVX>(ray, job, hitTrisIdx, hitDistances);
+#endif // SIMD_AVX
+#ifdef SIMD_SSE
+	case SIMD_KERNEL_SSE: return IntersectRayTrianglesT<SimdSSE>(ray, job, hitTrisIdx, hitDistances);
+#endif // SIMD_SSE
+#ifdef SIMD_NEON
+	case SIMD_KERNEL_NEON: return IntersectRayTrianglesT<SimdNEON>(ray, job, hitTrisIdx, hitDistances);
+#endif // SIMD_NEON
+#ifdef SIMD_WASM
+	case SIMD_KERNEL_WASM: return IntersectRayTrianglesT<SimdWasm>(ray, job, hitTrisIdx, hitDistances);
+#endif // SIMD_WASM
+	default: return IntersectRayTrianglesT<SimdScalar>(ray, job, hitTrisIdx, hitDistances);
+	}
+}
+
+RayPacket::RayPacket(Ray const* rays, unsigned int nbRays) : _nbRays(nbRays)
+{
+	ASSERT((nbRays > 0) && (nbRays <= RAY_PACKET_SIZE));
+	_allRaysMask = (nbRays < 32) ? ((1u << nbRays) - 1) : 0xFFFFFFFF;
+	for(unsigned int rayIdx = 0; rayIdx < RAY_PACKET_SIZE; ++rayIdx)
+	{
+		if(rayIdx < nbRays)
+		{
+			Ray const& ray = rays[rayIdx];
+			Vector3 const& direction = ray.GetDirection();
+			_rays[rayIdx] = ray;
+			_originX[rayIdx] = ray.GetOrigin().x;
+			_originY[rayIdx] = ray.GetOrigin().y;
+			_originZ[rayIdx] = ray.GetOrigin().z;
+			// Same as Ray::Intersects(BBox)
+			_invDirectionX[rayIdx] = (direction.x != 0.0f) ? 1.0f / direction.x : 1000000.0f;
+			_invDirectionY[rayIdx] = (direction.y != 0.0f) ? 1.0f / direction.y : 1000000.0f;
+			_invDirectionZ[rayIdx] = (direction.z != 0.0f) ? 1.0f / direction.z : 1000000.0f;
+			_length[rayIdx] = ray.GetLength();
+		}
+		else
+		{	// Padding lanes, never in a mask
+			_originX[rayIdx] = _originY[rayIdx] = _originZ[rayIdx] = 0.0f;
+			_invDirectionX[rayIdx] = _invDirectionY[rayIdx] = _invDirectionZ[rayIdx] = 1.0f;
+			_length[rayIdx] = 0.0f;
+		}
+	}
+}
+
+float RayPacket::GetMaxLength(unsigned int raysMask) const
+{
+	float maxLength = 0.0f;
+	for(unsigned int rayIdx = 0; rayIdx < _nbRays; ++rayIdx)
+	{
+		if(raysMask & (1u << rayIdx))
+			maxLength = max(maxLength, _length[rayIdx]);
+	}
+	return maxLength;
+}
+
+template <class S>
+unsigned int RayPacket::GetRaysReachingT(BBox const& bbox, unsigned int raysMask, float& entryDistance) const
+{
+	typedef typename S::Float Float;
+	typedef typename S::Mask Mask;
+	const unsigned int W = S::Width;
+	const unsigned int allLanes = (1 << W) - 1;
+	alignas(32) float laneEntryDistance[W];
+	Float const minX = S::Set1(bbox.Min().x), minY = S::Set1(bbox.Min().y), minZ = S::Set1(bbox.Min().z);
+	Float const maxX = S::Set1(bbox.Max().x), maxY = S::Set1(bbox.Max().y), maxZ = S::Set1(bbox.Max().z);
+	Float const zero = S::Set1(0.0f);
+	unsigned int reachingMask = 0;
+	entryDistance = FLT_MAX;
+	for(unsigned int blockStart = 0; blockStart < _nbRays; blockStart += W)
+	{
+		unsigned int blockMask = (raysMask >> blockStart) & allLanes;
+		if(blockMask == 0)
+			continue;
+		// Slabs test (as Ray::Intersects(BBox))
+		Float ox = S::Load(_originX + blockStart), oy = S::Load(_originY + blockStart), oz = S::Load(_originZ + blockStart);
+		Float invDx = S::Load(_invDirectionX + blockStart), invDy = S::Load(_invDirectionY + blockStart), invDz = S::Load(_invDirectionZ + blockStart);
+		Float t1 = S::Mul(S::Sub(minX, ox), invDx), t2 = S::Mul(S::Sub(maxX, ox), invDx);
+		Float t3 = S::Mul(S::Sub(minY, oy), invDy), t4 = S::Mul(S::Sub(maxY, oy), invDy);
+		Float t5 = S::Mul(S::Sub(minZ, oz), invDz), t6 = S::Mul(S::Sub(maxZ, oz), invDz);
+		Float tmin = S::Max(S::Max(S::Min(t1, t2), S::Min(t3, t4)), S::Min(t5, t6));
+		Float tmax = S::Min(S::Min(S::Max(t1, t2), S::Max(t3, t4)), S::Max(t5, t6));
+		Mask reject = S::Or(S::CmpLt(tmax, zero), S::CmpGt(tmin, tmax));
+		unsigned int hitLanes = S::MoveMask(S::AndNot(reject, S::CmpLe(tmin, S::Load(_length + blockStart)))) & blockMask;
+		if(hitLanes == 0)
+			continue;
+		reachingMask |= hitLanes << blockStart;
+		S::Store(laneEntryDistance, tmin);
+		for(unsigned int lane = 0; lane < W; ++lane)
+		{
+			if(hitLanes & (1 << lane))
+				entryDistance = min(entryDistance, max(laneEntryDistance[lane], 0.0f));
+		}
+	}
+	return reachingMask;
+}
+
+unsigned int RayPacket::GetRaysReaching(BBox const& bbox, unsigned int raysMask, float& entryDistance) const
+{
+	switch(GetSimdKernelType())
+	{
+#ifdef SIMD_AVX
+	case SIMD_KERNEL_AVX: return GetRaysReachingT<SimdAVX>(bbox, raysMask, entryDistance);
+#endif // SIMD_AVX
+#ifdef SIMD_SSE
+	case SIMD_KERNEL_SSE: return GetRaysReachingT<SimdSSE>(bbox, raysMask, entryDistance);
+#endif // SIMD_SSE
+#ifdef SIMD_NEON
+	case SIMD_KERNEL_NEON: return GetRaysReachingT<SimdNEON>(bbox, raysMask, entryDistance);
+#endif // SIMD_NEON
+#ifdef SIMD_WASM
+	case SIMD_KERNEL_WASM: return GetRaysReachingT<SimdWasm>(bbox, raysMask, entryDistance);
+#endif // SIMD_WASM
+	default: return GetRaysReachingT<SimdScalar>(bbox, raysMask, entryDistance);
+	}
+}
@@ -0,0 +1,57 @@
+﻿#ifndef _RAY_KERNELS_H_
+#define _RAY_KERNELS_H_
+
+#include "Math\Vector.h"
+#include "Math\SimdTraits.h"
+#include "Collisions\Ray.h"
+#include "Collisions\BSphere.h"
+#include "Collisions\BBox.h"
+
+// Vectorized (SSE/AVX/NEON/wasm-simd, with a scalar fallback) ray against triangles test, 4 or 8 triangles at a time.
+// Each triangle is tested against its bounding sphere then with Möller–Trumbore, doing the same IEEE operations as Ray::Intersects, so hits match the scalar path.
+struct RayTrisJob
+{
+	Vector3 const* vertices;
+	unsigned int const* triangles;	// 3 vertex index per triangle
+	BSphere const* trisBSphere;
+	unsigned int const* trisIdx;	// Triangles to test
+	unsigned int nbTris;
+	bool cullBackFace;
+};
+
+
+unsigned int IntersectRayTriangles(Ray const& ray, RayTrisJob const& job, unsigned int* hitTrisIdx, float* hitDistances);	// Returns the hits count, hits are written in the job order ("hitTrisIdx" and "hitDistances" must hold "nbTris" elements)
+
+const unsigned int RAY_PACKET_SIZE = 32;	// Rays traversed together by the packet queries (see Mesh::IntersectRays)
+
+// Rays traversing a tree together, their bounding box tests are vectorized across the rays.
+// Sets of rays are given as masks, one bit per ray.
+class RayPacket
+{
+public:
+	RayPacket(Ray const* rays, unsigned int nbRays);	// Up to RAY_PACKET_SIZE rays
+
+	unsigned int GetNbRays() const { return _nbRays; }
+	unsigned int GetAllRaysMask() const { return _allRaysMask; }
+	Ray const& GetRay(unsigned int rayIdx) const { return _rays[rayIdx]; }
+	void SetRayLength(unsigned int rayIdx, float length) { _rays[rayIdx].SetLength(length); _length[rayIdx] = length; }
+	float GetMaxLength(unsigned int raysMask) const;
+	unsigned int GetRaysReaching(BBox const& bbox, unsigned int raysMask, float& entryDistance) const;	// Rays of the mask reaching the box, as Ray::Intersects(BBox), "entryDistance" being the closest entry among them
+
+private:
+	template <class S> unsigned int GetRaysReachingT(BBox const& bbox, unsigned int raysMask, float& entryDistance) const;
+
+	Ray _rays[RAY_PACKET_SIZE];
+	// SoA copy of the rays, with their inverse direction
+	alignas(32) float _originX[RAY_PACKET_SIZE];
+	alignas(32) float _originY[RAY_PACKET_SIZE];
+	alignas(32) float _originZ[RAY_PACKET_SIZE];
+	alignas(32) float _invDirectionX[RAY_PACKET_SIZE];
+	alignas(32) float _invDirectionY[RAY_PACKET_SIZE];
+	alignas(32) float _invDirectionZ[RAY_PACKET_SIZE];
+	alignas(32) float _length[RAY_PACKET_SIZE];
+	unsigned int _nbRays;
+	unsigned int _allRaysMask;
+};
+
+#endif // _RAY_KERNELS_H_
@@ -97,22 +97,12 @@ bool Retessellate::HandleEdgeSubdiv(unsigned int inputTriIdx, TRI_EDGE_NUMBER ed
 					GetEdgeIndices(edgeNumber);	// Have to re-get vertices indices as suppressing the flat triangle have changed indices
 					flatTriangleInResult = false;
 				}
-				std::vector<unsigned int> const& triAroundA = _mesh.GetTrianglesAroundVertex(edgeVtx1);
-				std::vector<unsigned int> const& triAroundB = _mesh.GetTrianglesAroundVertex(edgeVtx2);
-				affectedTris.clear();
-				for(unsigned int triIdxA : triAroundA)		// Todo : O(n), of course optimize this
+				_mesh.GetTrianglesAroundEdge(inputTriIdx, edgeVtx1, edgeVtx2, affectedTris);
+				for(unsigned int triIdx : affectedTris)
 				{
-					for(unsigned int triIdxB : triAroundB)
-					{
-						if(triIdxA == triIdxB)
-						{	// triangle common to vertex A and B
-							ASSERT(_mesh.IsTriangleToBeRemoved(triIdxA) == false);
-							if(_mesh.IsTriangleToBeRemoved(triIdxA))
-								return false;	// We are working in the middle of triangles we already set to be deleted, don't continue. Todo: think about if continuing could be possible
-							affectedTris.push_back(triIdxA);
-							break;
-						}
-					}
+					ASSERT(_mesh.IsTriangleToBeRemoved(triIdx) == false);
+					if(_mesh.IsTriangleToBeRemoved(triIdx))
+						return false;	// We are working in the middle of triangles we already set to be deleted, don't continue. Todo: think about if continuing could be possible
 				}
 				ASSERT((affectedTris.size() == 2)
 					|| ((affectedTris.size() == 1) && _mesh.IsVertexOnOpenEdge(edgeVtx1) && _mesh.IsVertexOnOpenEdge(edgeVtx2)));	// Should be always the case on a manifold mesh
@@ -313,8 +303,8 @@ void Retessellate::HandleEdgeMerge(unsigned int inputTriIdx, TRI_EDGE_NUMBER edg
 		if(_mesh.IsTriangleToBeRemoved(inputTriIdx))
 			return;
 		// Get affected triangles, this will be a merge between triangles around "a" and "b"
-		std::vector<unsigned int> const& triAroundA = _mesh.GetTrianglesAroundVertex(edgeVtx1);
-		std::vector<unsigned int> const& triAroundB = _mesh.GetTrianglesAroundVertex(edgeVtx2);
+		TriangleFan triAroundA = _mesh.GetTrianglesAroundVertex(edgeVtx1);
+		TriangleFan triAroundB = _mesh.GetTrianglesAroundVertex(edgeVtx2);
 		if(edgeSquareLength > _dSquared * 0.1f/*EPSILON_SQR*/)
 		{
 			if(triAroundA.size() > 8) return;
@@ -340,19 +330,10 @@ void Retessellate::HandleEdgeMerge(unsigned int inputTriIdx, TRI_EDGE_NUMBER edg
 		std::vector<unsigned int> triToRemove;
 		affectedTriAroundA.reserve(triAroundA.size());
 		affectedTriAroundB.reserve(triAroundB.size());
-		affectedTriAroundA = triAroundA;
+		affectedTriAroundA.assign(triAroundA.begin(), triAroundA.end());
 		for(unsigned int triIdxB : triAroundB)
 		{
-			bool alreadyExist = false;
-			for(unsigned int triIdxA : triAroundA)		// Todo : O(n), of course optimize this
-			{
-				if(triIdxA == triIdxB)
-				{
-					alreadyExist = true;
-					break;
-				}
-			}
-			if(alreadyExist)
+			if(_mesh.TriangleHasVertex(triIdxB, edgeVtx1))
 			{
 				triToRemove.push_back(triIdxB);	// Remove the triangles that both share vertices "a" and "b"
 				// Remove from affectedTri
@@ -571,35 +552,16 @@ bool Retessellate::RemoveCrushedTriangle(unsigned int triIdx, bool forceComplete
 		else
 		{
 			// Get the other triangle sharing the tallest edge
-			std::vector<unsigned int> const* triAroundA = &(_mesh.GetTrianglesAroundVertex(*tallEdgeVtxId1));
-			std::vector<unsigned int> const* triAroundB = &(_mesh.GetTrianglesAroundVertex(*tallEdgeVtxId2));	// Note: take pointers as the upcoming removeFlatTriangles() call could change those
 			unsigned int otherTriangleID = UNDEFINED_NEW_ID;
 			bool flatTriangleDetected = false;
 			do
 			{
-				for(unsigned int triIdxA : *triAroundA)		// Todo : O(n), of course optimize this
-				{
-					for(unsigned int triIdxB : *triAroundB)
-					{
-						if(triIdxA == triIdxB)
-						{	// triangle common to vertex A and B
-							if(triIdx != triIdxA)
-								otherTriangleID = triIdxA;
-							break;
-						}
-					}
-					if(otherTriangleID != UNDEFINED_NEW_ID)
-						break;
-				}
+				otherTriangleID = _mesh.GetTriangleAcrossEdge(triIdx, *tallEdgeVtxId1, *tallEdgeVtxId2);
 				if(otherTriangleID != UNDEFINED_NEW_ID)
 				{	// Flat triangle removal
 					flatTriangleDetected = _mesh.RemoveFlatTriangle(otherTriangleID);
 					if(flatTriangleDetected)
-					{
-						triAroundA = &(_mesh.GetTrianglesAroundVertex(*tallEdgeVtxId1));
-						triAroundB = &(_mesh.GetTrianglesAroundVertex(*tallEdgeVtxId2));
 						otherTriangleID = UNDEFINED_NEW_ID;
-					}
 				}
 			} while(flatTriangleDetected);
 			ASSERT(otherTriangleID != UNDEFINED_NEW_ID);
@@ -742,7 +704,7 @@ void Retessellate::StichLoops(LoopElement const* rootLoopA, unsigned int vtxToEl
 	auto StitchVtx = [&](unsigned int curLoopVtx, unsigned int nextLoopVtx, unsigned int vtxToEliminateIdx, unsigned int vtxToStichToIdx)
 	{
 		// Find triangle curLoopVtx - nextLoopVtx - vtxToEliminateIdx
-		std::vector<unsigned int> const& triAround = _mesh.GetTrianglesAroundVertex(vtxToEliminateIdx);
+		TriangleFan triAround = _mesh.GetTrianglesAroundVertex(vtxToEliminateIdx);
 		for(unsigned int triIdx : triAround)
 		{
 			unsigned int* triVtxIdxs = &(_triangles[triIdx * 3]);
@@ -930,7 +892,7 @@ void Retessellate::StichLoops(LoopElement const* rootLoopA, unsigned int vtxToEl
 			_mesh.DetectAndTreatDegeneratedEdgeAroundVertex(curAVtx->GetVtxId(), _newVerticesIDs);
 			// Remove degenerated quads
 			std::set<unsigned int> vtxAround;
-			std::vector<unsigned int> const& triAround = _mesh.GetTrianglesAroundVertex(curAVtx->GetVtxId());
+			TriangleFan triAround = _mesh.GetTrianglesAroundVertex(curAVtx->GetVtxId());
 			for(unsigned int const& triIdx : triAround)
 			{
 				unsigned int const* vtxsIdx = &(_triangles[triIdx * 3]);
@@ -0,0 +1,23 @@
+﻿#include "ScratchArena.h"
+
+std::vector<unsigned int>& ScratchArena::GrabIndexBuffer()
+{
+	std::vector<unsigned int>* buffer;
+	#pragma omp critical(ScratchArena)
+	buffer = &_indexBuffers.Grab(_nbAllocations);
+	return *buffer;
+}
+
+std::vector<float>& ScratchArena::GrabFloatBuffer()
+{
+	std::vector<float>* buffer;
+	#pragma omp critical(ScratchArena)
+	buffer = &_floatBuffers.Grab(_nbAllocations);
+	return *buffer;
+}
+
+void ScratchArena::GiveBack(unsigned int indexBuffersMark, unsigned int floatBuffersMark)
+{
+	_indexBuffers.GiveBack(indexBuffersMark);
+	_floatBuffers.GiveBack(floatBuffersMark);
+}
@@ -0,0 +1,102 @@
+﻿#ifndef _SCRATCH_ARENA_H_
+#define _SCRATCH_ARENA_H_
+
+#include <vector>
+#include <deque>
+#include "SculptEngine.h"
+
+// Temporary buffers of the brushes and visitors, owned by the mesh so that they are reused from dab to dab instead of being allocated each time.
+// Buffers are handed out monotonically, and given back all at once: the ones grabbed while a Scope lives when it ends, all of them on Reset (stroke end).
+// A given back buffer keeps its capacity, so steady-state dabs don't allocate: GetAllocationCount only moves when a buffer is created or has to grow.
+class ScratchArena
+{
+public:
+	class Scope	// Scopes have to be nested (as stack objects are)
+	{
+	public:
+		Scope(ScratchArena& arena) : _arena(arena), _indexBuffersMark(arena._indexBuffers.GetUsedCount()), _floatBuffersMark(arena._floatBuffers.GetUsedCount()) {}
+		~Scope() { _arena.GiveBack(_indexBuffersMark, _floatBuffersMark); }
+
+	private:
+		Scope(Scope const&);
+		Scope& operator=(Scope const&);
+
+		ScratchArena& _arena;
+		unsigned int _indexBuffersMark;
+		unsigned int _floatBuffersMark;
+	};
+
+	ScratchArena() : _nbAllocations(0) {}
+	ScratchArena(ScratchArena const& /*other*/) : _nbAllocations(0) {}	// Buffers are not shared nor copied
+	ScratchArena& operator=(ScratchArena const& /*other*/) { return *this; }
+
+	std::vector<unsigned int>& GrabIndexBuffer();	// Empty buffer, valid until given back. Thread safe
+	std::vector<float>& GrabFloatBuffer();
+	void Reset() { GiveBack(0, 0); }
+
+	unsigned int GetAllocationCount() const { return _nbAllocations + _indexBuffers.GetGrownCount() + _floatBuffers.GetGrownCount(); }	// Buffers created or grown since the arena creation
+	size_t GetMemoryUsage() const { return _indexBuffers.GetMemoryUsage() + _floatBuffers.GetMemoryUsage(); }
+
+private:
+	template <class T>
+	class Pool
+	{
+	public:
+		Pool() : _nbUsed(0) {}
+
+		unsigned int GetUsedCount() const { return _nbUsed; }
+		std::vector<T>& Grab(unsigned int& nbAllocations)
+		{
+			if(_nbUsed == _buffers.size())
+			{
+				_buffers.push_back(std::vector<T>());	// deque: already handed out buffers are not relocated
+				_capacities.push_back(0);
+				++nbAllocations;
+			}
+			std::vector<T>& buffer = _buffers[_nbUsed];
+			buffer.clear();
+			if(buffer.capacity() != _capacities[_nbUsed])
+			{	// Grown while last handed out, maybe to the exact size needed (reserve, resize, range insert): room for the next dabs
+				buffer.reserve(buffer.capacity() * 2);
+				nbAllocations += 2;
+			}
+			_capacities[_nbUsed++] = buffer.capacity();
+			return buffer;
+		}
+		void GiveBack(unsigned int mark)
+		{
+			ASSERT(mark <= _nbUsed);
+			_nbUsed = mark;
+		}
+		unsigned int GetGrownCount() const
+		{	// Buffers grown since they were last handed out, not counted yet
+			unsigned int nbGrown = 0;
+			for(size_t i = 0; i < _buffers.size(); ++i)
+			{
+				if(_buffers[i].capacity() != _capacities[i])
+					++nbGrown;
+			}
+			return nbGrown;
+		}
+		size_t GetMemoryUsage() const
+		{
+			size_t memoryUsage = 0;
+			for(std::vector<T> const& buffer : _buffers)
+				memoryUsage += buffer.capacity() * sizeof(T);
+			return memoryUsage;
+		}
+
+	private:
+		std::deque<std::vector<T>> _buffers;
+		std::deque<size_t> _capacities;	// As they were when last handed out
+		unsigned int _nbUsed;
+	};
+
+	void GiveBack(unsigned int indexBuffersMark, unsigned int floatBuffersMark);
+
+	Pool<unsigned int> _indexBuffers;
+	Pool<float> _floatBuffers;
+	unsigned int _nbAllocations;
+};
+
+#endif // _SCRATCH_ARENA_H_
@@ -12,6 +12,11 @@ EMSCRIPTEN_BINDINGS(SubMesh)
 		.function("Triangles", &SubMesh::Triangles)
 		.function("Vertices", &SubMesh::Vertices)
 		.function("Normals", &SubMesh::Normals)
+		.function("GetDirtyRangesBaseVersion", &SubMesh::GetDirtyRangesBaseVersion)
+		.function("CanPartialUpdateFrom", &SubMesh::CanPartialUpdateFrom)
+		.function("IsSharingBuffers", &SubMesh::IsSharingBuffers)
+		.function("GetSharedFirstVertex", &SubMesh::GetSharedFirstVertex)
+		.function("DirtyRanges", &SubMesh::DirtyRanges)
 		.function("GetBBox", &SubMesh::GetBBox);
 }
 #endif // __EMSCRIPTEN__
\ No newline at end of file
@@ -12,7 +12,7 @@
 class SubMesh
 {
 public:
-	SubMesh(unsigned int id) : _id(id), _versionNumber(0) {}
+	SubMesh(unsigned int id) : _id(id), _versionNumber(0), _dirtyRangesBaseVersion(0), _sharedVertices(nullptr), _sharedNormals(nullptr), _sharedFirstVertex(0), _sharedVerticesCount(0) {}
 
 	unsigned int GetID() const { return _id; }
 	unsigned int GetVersionNumber() const { return _versionNumber; }
@@ -28,10 +28,57 @@ public:
 	std::vector<Vector3>& GrabVertices() { return _vertices; }
 	std::vector<Vector3>& GrabNormals() { return _normals; }
 
+	std::vector<unsigned int> const& GetFullMeshVerticesIdx() const { return _fullMeshVtxsIdx; }
+	std::vector<unsigned int>& GrabFullMeshVerticesIdx() { return _fullMeshVtxsIdx; }
+
+	// Vertices and normals access that works whether buffers are our own or shared with the full mesh
+	unsigned int GetVerticesCount() const { return IsSharingBuffers() ? _sharedVerticesCount : (unsigned int) _vertices.size(); }
+	Vector3 const* GetVerticesData() const { return IsSharingBuffers() ? _sharedVertices->data() + _sharedFirstVertex : _vertices.data(); }
+	Vector3 const* GetNormalsData() const { return IsSharingBuffers() ? _sharedNormals->data() + _sharedFirstVertex : _normals.data(); }
+
+	// Shared buffers: we are a window into the full mesh vertices and normals, triangles indices are relative to the window first vertex
+	bool IsSharingBuffers() const { return _sharedVertices != nullptr; }
+	unsigned int GetSharedFirstVertex() const { return _sharedFirstVertex; }
+	void ShareBuffers(std::vector<Vector3> const& fullMeshVertices, std::vector<Vector3> const& fullMeshNormals, unsigned int firstVertex, unsigned int verticesCount)
+	{
+		ASSERT(firstVertex + verticesCount <= fullMeshVertices.size());
+		if(!IsSharingBuffers())
+		{	// Release our own copy
+			std::vector<Vector3>().swap(_vertices);
+			std::vector<Vector3>().swap(_normals);
+			std::vector<unsigned int>().swap(_fullMeshVtxsIdx);
+		}
+		_sharedVertices = &fullMeshVertices;
+		_sharedNormals = &fullMeshNormals;
+		_sharedFirstVertex = firstVertex;
+		_sharedVerticesCount = verticesCount;
+	}
+	void StopSharingBuffers() { _sharedVertices = nullptr; _sharedNormals = nullptr; _sharedFirstVertex = 0; _sharedVerticesCount = 0; }
+
+	// Partial update: vertices modified when going from "dirty ranges base version" to current version, stored as (first vertex, vertex count) pairs
+	unsigned int GetDirtyRangesBaseVersion() const { return _dirtyRangesBaseVersion; }
+	bool CanPartialUpdateFrom(unsigned int versionNumber) const { return (versionNumber == _dirtyRangesBaseVersion) && (versionNumber != _versionNumber); }
+	std::vector<unsigned int> const& GetDirtyRanges() const { return _dirtyRanges; }
+	void ClearDirtyRanges(unsigned int baseVersionNumber) { _dirtyRangesBaseVersion = baseVersionNumber; _dirtyRanges.clear(); }
+	void AddDirtyVertex(unsigned int vtxIdx)
+	{	// Vertices are expected in increasing order, close ones are merged in the same range (uploading a few clean vertices is cheaper than handling one more range)
+		if(!_dirtyRanges.empty() && (vtxIdx <= _dirtyRanges[_dirtyRanges.size() - 2] + _dirtyRanges.back() + dirtyRangesMergeGap))
+		{
+			ASSERT(vtxIdx >= _dirtyRanges[_dirtyRanges.size() - 2] + _dirtyRanges.back());
+			_dirtyRanges.back() = vtxIdx - _dirtyRanges[_dirtyRanges.size() - 2] + 1;
+		}
+		else
+		{
+			_dirtyRanges.push_back(vtxIdx);
+			_dirtyRanges.push_back(1);
+		}
+	}
+
 #ifdef __EMSCRIPTEN__ 
 	emscripten::val Triangles() { return emscripten::val(emscripten::typed_memory_view(_triangles.size() * sizeof(int), (char const *) _triangles.data())); }
-	emscripten::val Vertices() { return emscripten::val(emscripten::typed_memory_view(_vertices.size() * sizeof(Vector3), (char const *) _vertices.data())); }
-	emscripten::val Normals() { return emscripten::val(emscripten::typed_memory_view(_normals.size() * sizeof(Vector3), (char const *) _normals.data())); }
+	emscripten::val Vertices() { return emscripten::val(emscripten::typed_memory_view(GetVerticesCount() * sizeof(Vector3), (char const *) GetVerticesData())); }
+	emscripten::val Normals() { return emscripten::val(emscripten::typed_memory_view(GetVerticesCount() * sizeof(Vector3), (char const *) GetNormalsData())); }
+	emscripten::val DirtyRanges() { return emscripten::val(emscripten::typed_memory_view(_dirtyRanges.size() * sizeof(int), (char const *) _dirtyRanges.data())); }
 #endif // __EMSCRIPTEN__ 
 
 private:
@@ -39,12 +86,22 @@ private:
 	std::vector<unsigned int> _triangles;
 	std::vector<Vector3> _vertices;
 	std::vector<Vector3> _normals;
+	std::vector<unsigned int> _fullMeshVtxsIdx;	// Local to full mesh vertex index, kept between updates to patch vertices in place
 	// Bbox
 	BBox _BBox;
 	// ID
 	unsigned int _id;
 	// Version number, to be able to trigger data update on the caller side
 	unsigned int _versionNumber;
+	// Partial update
+	static const unsigned int dirtyRangesMergeGap = 8;
+	std::vector<unsigned int> _dirtyRanges;
+	unsigned int _dirtyRangesBaseVersion;
+	// Shared buffers (the full mesh ones)
+	std::vector<Vector3> const* _sharedVertices;
+	std::vector<Vector3> const* _sharedNormals;
+	unsigned int _sharedFirstVertex;
+	unsigned int _sharedVerticesCount;
 };
 
 #endif // _SUB_MESH_H_
\ No newline at end of file
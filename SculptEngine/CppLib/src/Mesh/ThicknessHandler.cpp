@@ -6,10 +6,8 @@
 
 //#define TEMP_CLEAN_SOLUTION	// Temporary solution which works with one stitch
 
-ThicknessHandler::ThicknessHandler(Mesh& mesh): _mesh(mesh), _triangles(mesh.GrabTriangles()), _vertices(mesh.GrabVertices()), _normals(mesh.GetNormals())
+ThicknessHandler::ThicknessHandler(Mesh& mesh): _mesh(mesh), _triangles(mesh.GrabTriangles()), _vertices(mesh.GrabVertices()), _normals(mesh.GetNormals()), _verticesToTest(mesh.GrabScratchArena().GrabIndexBuffer()), _verticesMoved(mesh.GrabScratchArena().GrabIndexBuffer()), _distances(mesh.GrabScratchArena().GrabFloatBuffer())
 {
-	_verticesToTest.reserve(_mesh.GetVertices().size());
-	_verticesMoved.reserve(_mesh.GetVertices().size());
 }
 
 void ThicknessHandler::ReshapeRegardingThickness(FUSION_MODE fusionMode)
@@ -60,7 +58,7 @@ void ThicknessHandler::ReshapeRegardingThickness(FUSION_MODE fusionMode)
 							}
 							// Adjascency check
 							bool closestOppositePointIsAdjascent = false;
-							std::vector<unsigned int> const& triAround = _mesh.GetTrianglesAroundVertex(otherVtxIdx);
+							TriangleFan triAround = _mesh.GetTrianglesAroundVertex(otherVtxIdx);
 							for(unsigned int triIdx : triAround)
 							{
 								unsigned int const* triVtxIdxs = &(_triangles[triIdx * 3]);
@@ -153,7 +151,7 @@ void ThicknessHandler::ReshapeRegardingThickness(FUSION_MODE fusionMode)
 Loop ThicknessHandler::CollectRingLoop(unsigned int vtxIdx)
 {
 	LoopBuilder loopBuilder(_mesh);
-	std::vector<unsigned int> const& triAround = _mesh.GetTrianglesAroundVertex(vtxIdx);
+	TriangleFan triAround = _mesh.GetTrianglesAroundVertex(vtxIdx);
 	// Collect ring vertices
 	//printf("Edge register\n");
 	for(unsigned int triIdx : triAround)
@@ -227,7 +225,8 @@ bool ThicknessHandler::SmoothVertex(unsigned int vtxIdx)
 			_vertices[vtxIdx] = newPos;
 		}
 		// Retesselate
-		std::vector<unsigned int> triAround = _mesh.GetTrianglesAroundVertex(vtxIdx);
+		TriangleFan triAroundFan = _mesh.GetTrianglesAroundVertex(vtxIdx);
+		std::vector<unsigned int> triAround(triAroundFan.begin(), triAroundFan.end());	// Copy, as retessellation below changes the list
 		for(unsigned int triIdx : triAround)
 		{
 			if(_mesh.IsTriangleToBeRemoved(triIdx))
@@ -35,9 +35,9 @@ private:
 	std::vector<unsigned int>& _triangles;
 	std::vector<Vector3>& _vertices;
 	std::vector<Vector3> const& _normals;
-	std::vector<unsigned int> _verticesToTest;
-	std::vector<unsigned int> _verticesMoved;
-	std::vector<float> _distances;
+	std::vector<unsigned int>& _verticesToTest;	// Buffers from the mesh scratch arena
+	std::vector<unsigned int>& _verticesMoved;
+	std::vector<float>& _distances;
 };
 
 #endif // _THICKNESS_HANDLER_H_
\ No newline at end of file
@@ -0,0 +1,140 @@
+﻿#include "TrianglesAroundVertices.h"
+#include <string.h>
+#include "Math\Math.h"
+
+const size_t pageSlotCount = 1 << 16;	// Page size used for lists relocated while editing (build and compaction allocate one page fitting everything)
+const unsigned int listSlack = 2;	// Free slots given to each list on build and compaction
+
+TrianglesAroundVertices::TrianglesAroundVertices(TrianglesAroundVertices const& other) : _curPageFreePtr(nullptr), _curPageFreeSlots(0), _allocatedSlots(0), _reservedSlots(0)
+{
+	CopyCompacted(other);
+}
+
+TrianglesAroundVertices& TrianglesAroundVertices::operator=(TrianglesAroundVertices const& other)
+{
+	if(this != &other)
+		CopyCompacted(other);
+	return *this;
+}
+
+void TrianglesAroundVertices::Build(std::vector<unsigned int> const& triangles, unsigned int nbVertices)
+{
+	Clear();
+	_entries.resize(nbVertices);
+	// Count triangles around each vertex
+	for(unsigned int vtxIdx : triangles)
+		_entries[vtxIdx]._capacity++;
+	// Give each vertex its range in a single page
+	size_t nbSlots = 0;
+	for(VertexEntry& entry : _entries)
+	{
+		entry._capacity += listSlack;
+		nbSlots += entry._capacity;
+	}
+	unsigned int* data = AllocateSlots((unsigned int) nbSlots);
+	for(VertexEntry& entry : _entries)
+	{
+		entry._data = data;
+		data += entry._capacity;
+	}
+	_reservedSlots = nbSlots;
+	// Fill (in triangle order)
+	unsigned int triCount = (unsigned int) triangles.size() / 3;
+	for(unsigned int triIdx = 0; triIdx < triCount; ++triIdx)
+	{
+		unsigned int const* vtxsIdx = &(triangles[triIdx * 3]);
+		for(int i = 0; i < 3; ++i)
+		{
+			VertexEntry& entry = _entries[vtxsIdx[i]];
+			entry._data[entry._count++] = triIdx;
+		}
+	}
+}
+
+void TrianglesAroundVertices::Clear()
+{
+	_entries.clear();
+	_pages.clear();
+	_curPageFreePtr = nullptr;
+	_curPageFreeSlots = 0;
+	_allocatedSlots = 0;
+	_reservedSlots = 0;
+}
+
+void TrianglesAroundVertices::MoveVertex(unsigned int srcVtxIdx, unsigned int dstVtxIdx)
+{
+	ASSERT(srcVtxIdx != dstVtxIdx);
+	ReleaseSlots(_entries[dstVtxIdx]);
+	_entries[dstVtxIdx] = _entries[srcVtxIdx];
+	_entries[srcVtxIdx] = VertexEntry();	// Slots are now owned by dstVtxIdx, nothing to release
+}
+
+void TrianglesAroundVertices::Compact()
+{
+	CopyCompacted(*this);
+}
+
+void TrianglesAroundVertices::Reorder(std::vector<unsigned int> const& newOrder)
+{
+	ASSERT(newOrder.size() == _entries.size());
+	std::vector<VertexEntry> entries;
+	entries.reserve(_entries.size());
+	for(unsigned int oldVtxIdx : newOrder)
+		entries.push_back(_entries[oldVtxIdx]);
+	_entries.swap(entries);
+	Compact();	// Lists memory now follows vertices order
+}
+
+unsigned int* TrianglesAroundVertices::AllocateSlots(unsigned int nbSlots)
+{
+	if(nbSlots > _curPageFreeSlots)
+	{	// What remains in the current page is lost, start a new one
+		size_t newPageSlotCount = max(pageSlotCount, size_t(nbSlots));
+		_pages.push_back(std::unique_ptr<unsigned int[]>(new unsigned int[newPageSlotCount]));
+		_curPageFreePtr = _pages.back().get();
+		_curPageFreeSlots = newPageSlotCount;
+		_allocatedSlots += newPageSlotCount;
+	}
+	unsigned int* slots = _curPageFreePtr;
+	_curPageFreePtr += nbSlots;
+	_curPageFreeSlots -= nbSlots;
+	return slots;
+}
+
+void TrianglesAroundVertices::Grow(VertexEntry& entry)
+{
+	unsigned int newCapacity = entry._capacity + (entry._capacity / 2) + 4;
+	unsigned int* newData = AllocateSlots(newCapacity);
+	if(entry._count != 0)
+		memcpy(newData, entry._data, entry._count * sizeof(unsigned int));
+	_reservedSlots += newCapacity - entry._capacity;
+	entry._data = newData;
+	entry._capacity = newCapacity;
+}
+
+void TrianglesAroundVertices::CopyCompacted(TrianglesAroundVertices const& other)
+{
+	std::vector<VertexEntry> entries(other._entries.size());
+	size_t nbSlots = 0;
+	for(VertexEntry const& entry : other._entries)
+		nbSlots += entry._count + listSlack;
+	std::unique_ptr<unsigned int[]> page(new unsigned int[max(nbSlots, size_t(1))]);
+	unsigned int* data = page.get();
+	for(unsigned int vtxIdx = 0; vtxIdx < entries.size(); ++vtxIdx)
+	{
+		VertexEntry const& otherEntry = other._entries[vtxIdx];
+		VertexEntry& entry = entries[vtxIdx];
+		entry._data = data;
+		entry._count = otherEntry._count;
+		entry._capacity = otherEntry._count + listSlack;
+		if(otherEntry._count != 0)
+			memcpy(data, otherEntry._data, otherEntry._count * sizeof(unsigned int));
+		data += entry._capacity;
+	}
+	// Only now release our previous data ("other" could be ourself when compacting)
+	Clear();
+	_entries.swap(entries);
+	_pages.push_back(std::move(page));
+	_allocatedSlots = max(nbSlots, size_t(1));
+	_reservedSlots = nbSlots;
+}
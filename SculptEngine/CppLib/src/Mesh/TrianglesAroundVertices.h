@@ -0,0 +1,123 @@
+﻿#ifndef _TRIANGLES_AROUND_VERTICES_H_
+#define _TRIANGLES_AROUND_VERTICES_H_
+
+#include <vector>
+#include <memory>
+#include "SculptEngine.h"
+
+class TrianglesAroundVertices;
+
+// Live view on the triangles around one vertex (follows the list if it is relocated), with a std::vector like read interface
+class TriangleFan
+{
+public:
+	TriangleFan(TrianglesAroundVertices const& owner, unsigned int vtxIdx) : _owner(&owner), _vtxIdx(vtxIdx) {}
+
+	unsigned int size() const;
+	bool empty() const { return size() == 0; }
+	unsigned int operator[](unsigned int index) const { ASSERT(index < size()); return begin()[index]; }
+	unsigned int front() const { return (*this)[0]; }
+	unsigned int back() const { return (*this)[size() - 1]; }
+	unsigned int const* begin() const;
+	unsigned int const* end() const { return begin() + size(); }
+
+private:
+	TrianglesAroundVertices const* _owner;
+	unsigned int _vtxIdx;
+};
+
+// For each vertex, tells the triangles around it. Compressed sparse row like storage: all lists live in a few big pages instead of one heap block per vertex.
+// Each list has a small slack to absorb retessellation edits, a list that outgrows it is relocated at the end of the pages (its old slots are lost until next compaction).
+// Pages never move, so a list address stays valid as long as that very list doesn't grow (same rule as a std::vector).
+class TrianglesAroundVertices
+{
+public:
+	TrianglesAroundVertices() : _curPageFreePtr(nullptr), _curPageFreeSlots(0), _allocatedSlots(0), _reservedSlots(0) {}
+	TrianglesAroundVertices(TrianglesAroundVertices const& other);	// Copy is compacted
+	TrianglesAroundVertices& operator=(TrianglesAroundVertices const& other);
+
+	void Build(std::vector<unsigned int> const& triangles, unsigned int nbVertices);
+	void Clear();
+
+	// std::vector like read interface (it stands where a vector of vectors used to be)
+	unsigned int size() const { return (unsigned int) _entries.size(); }
+	TriangleFan operator[](unsigned int vtxIdx) const { ASSERT(vtxIdx < _entries.size()); return TriangleFan(*this, vtxIdx); }
+
+	unsigned int GetCount(unsigned int vtxIdx) const { return _entries[vtxIdx]._count; }
+	unsigned int const* GetData(unsigned int vtxIdx) const { return _entries[vtxIdx]._data; }
+	unsigned int* GrabData(unsigned int vtxIdx) { return _entries[vtxIdx]._data; }
+
+	// Vertex related
+	void AddVertex() { _entries.push_back(VertexEntry()); }
+	void MoveVertex(unsigned int srcVtxIdx, unsigned int dstVtxIdx);	// "dstVtxIdx" takes the list of "srcVtxIdx" (its own one is dropped), "srcVtxIdx" ends up empty
+	void PopBackVertex() { ASSERT(_entries.empty() == false); ReleaseSlots(_entries.back()); _entries.pop_back(); }
+
+	// Triangle list related
+	void Add(unsigned int vtxIdx, unsigned int triIdx)
+	{
+		VertexEntry& entry = _entries[vtxIdx];
+		if(entry._count == entry._capacity)
+			Grow(entry);
+		entry._data[entry._count++] = triIdx;
+	}
+	bool Remove(unsigned int vtxIdx, unsigned int triIdx)	// Last element takes the place of the removed one
+	{
+		VertexEntry& entry = _entries[vtxIdx];
+		for(unsigned int i = 0; i < entry._count; ++i)
+		{
+			if(entry._data[i] == triIdx)
+			{
+				entry._data[i] = entry._data[--entry._count];
+				return true;
+			}
+		}
+		return false;
+	}
+	bool Change(unsigned int vtxIdx, unsigned int oldTriIdx, unsigned int newTriIdx)
+	{
+		VertexEntry& entry = _entries[vtxIdx];
+		for(unsigned int i = 0; i < entry._count; ++i)
+		{
+			if(entry._data[i] == oldTriIdx)
+			{
+				entry._data[i] = newTriIdx;
+				return true;
+			}
+		}
+		return false;
+	}
+	void ClearVertex(unsigned int vtxIdx) { _entries[vtxIdx]._count = 0; }
+	void Shrink(unsigned int vtxIdx, unsigned int newCount) { ASSERT(newCount <= _entries[vtxIdx]._count); _entries[vtxIdx]._count = newCount; }
+
+	// Memory related
+	bool HasToCompact() const { return _reservedSlots < _allocatedSlots / 2; }	// More than half of the slots are lost
+	void Compact();
+	void Reorder(std::vector<unsigned int> const& newOrder);	// newOrder[newVtxIdx] = oldVtxIdx, lists are compacted in the new order
+	size_t GetMemoryUsage() const { return _entries.capacity() * sizeof(VertexEntry) + _allocatedSlots * sizeof(unsigned int) + _pages.capacity() * sizeof(std::unique_ptr<unsigned int[]>); }
+
+private:
+	struct VertexEntry
+	{
+		VertexEntry() : _data(nullptr), _count(0), _capacity(0) {}
+		unsigned int* _data;
+		unsigned int _count;
+		unsigned int _capacity;
+	};
+
+	unsigned int* AllocateSlots(unsigned int nbSlots);
+	void ReleaseSlots(VertexEntry& entry) { _reservedSlots -= entry._capacity; entry._data = nullptr; entry._count = 0; entry._capacity = 0; }
+	void Grow(VertexEntry& entry);
+	void CopyCompacted(TrianglesAroundVertices const& other);
+
+	std::vector<VertexEntry> _entries;
+	std::vector<std::unique_ptr<unsigned int[]>> _pages;
+	unsigned int* _curPageFreePtr;
+	size_t _curPageFreeSlots;
+	size_t _allocatedSlots;	// Slots in all pages
+	size_t _reservedSlots;	// Slots owned by vertex lists (the remaining being lost, or free in the current page)
+};
+
+inline unsigned int TriangleFan::size() const { return _owner->GetCount(_vtxIdx); }
+inline unsigned int const* TriangleFan::begin() const { return _owner->GetData(_vtxIdx); }
+
+#endif // _TRIANGLES_AROUND_VERTICES_H_
@@ -0,0 +1,607 @@
+﻿#include "TrianglesBVH.h"
+#include "Mesh.h"
+#include "RayKernels.h"
+#include <algorithm>
+
+const unsigned int maxTrianglesPerLeaf = 4;	// No split is tried below that
+const unsigned int maxTrianglesPerLeafWithoutGoodSplit = 16;	// Split anyway past that, even if the surface area heuristic says it doesn't pay
+const unsigned int maxTrianglesPerLeafBeforeRebuild = 32;	// A leaf receiving inserted triangles is rebuilt past that
+const unsigned int nbSAHBins = 16;
+
+static float GetAxis(Vector3 const& vector, unsigned int axis)
+{
+	return (axis == 0) ? vector.x : ((axis == 1) ? vector.y : vector.z);
+}
+
+static float GetHalfArea(BBox const& bbox)
+{
+	if(!bbox.IsValid())
+		return 0.0f;
+	Vector3 size = bbox.Size();
+	return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+void TrianglesBVH::Build(Mesh const& mesh)
+{
+	unsigned int nbTriangles = (unsigned int) mesh.GetTriangles().size() / 3;
+	std::vector<BuildTriangle> buildTris;
+	buildTris.reserve(nbTriangles);
+	for(unsigned int triIdx = 0; triIdx < nbTriangles; ++triIdx)
+	{
+		if(!mesh.IsTriangleToBeRemoved(triIdx))
+		{
+			BuildTriangle buildTri;
+			buildTri._bbox = GetTriangleBBox(mesh, triIdx);
+			buildTri._centroid = buildTri._bbox.Center();
+			buildTri._triIdx = triIdx;
+			buildTris.push_back(buildTri);
+		}
+	}
+	_nodes.clear();
+	_nodes.reserve((buildTris.size() / maxTrianglesPerLeaf) * 2 + 1);
+	_nodesTris = IndexListsPool();
+	_trisLeaf.clear();
+	_trisLeaf.resize(nbTriangles, UNDEFINED_NODE_IDX);
+	_leavesToRefit.clear();
+	_trisToInsert.clear();
+	AddNode(UNDEFINED_NODE_IDX);
+	BuildNode(0, buildTris, 0, (unsigned int) buildTris.size());
+	_nbTrianglesAtBuild = (unsigned int) buildTris.size();
+	_nbInsertedSinceBuild = 0;
+	_hasToRefitAll = false;
+}
+
+unsigned int TrianglesBVH::AddNode(unsigned int parentIdx)
+{
+	Node node;
+	node._parentIdx = parentIdx;
+	node._firstChildIdx = UNDEFINED_NODE_IDX;
+	node._hasToRefit = false;
+	_nodes.push_back(node);
+	_nodesTris.AddList();
+	return (unsigned int) _nodes.size() - 1;
+}
+
+void TrianglesBVH::BuildNode(unsigned int nodeIdx, std::vector<BuildTriangle>& buildTris, unsigned int begin, unsigned int end)
+{	// Note: nodes are added while building, don't keep a reference on one across the recursion
+	BBox bbox;
+	BBox centroidsBBox;
+	for(unsigned int i = begin; i < end; ++i)
+	{
+		bbox.Encapsulate(buildTris[i]._bbox);
+		centroidsBBox.Encapsulate(buildTris[i]._centroid);
+	}
+	_nodes[nodeIdx]._bbox = bbox;
+	unsigned int nbTriangles = end - begin;
+	unsigned int splitPos = begin;	// Stays at begin if the node is a leaf
+	if(nbTriangles > maxTrianglesPerLeaf)
+	{
+		// Binned SAH: the split minimizing the children area weighted by their triangles count, tried on the bins boundaries of each axis
+		float bestCost = FLT_MAX;
+		unsigned int bestAxis = 3;
+		unsigned int bestBin = 0;
+		float bestBinScale = 0.0f;
+		for(unsigned int axis = 0; axis < 3; ++axis)
+		{
+			float centroidsMin = GetAxis(centroidsBBox.Min(), axis);
+			float extent = GetAxis(centroidsBBox.Max(), axis) - centroidsMin;
+			if(extent <= 0.0f)
+				continue;
+			float binScale = float(nbSAHBins) / extent;
+			BBox binsBBox[nbSAHBins];
+			unsigned int binsCount[nbSAHBins] = {};
+			for(unsigned int i = begin; i < end; ++i)
+			{
+				unsigned int bin = std::min(nbSAHBins - 1, (unsigned int) ((GetAxis(buildTris[i]._centroid, axis) - centroidsMin) * binScale));
+				binsBBox[bin].Encapsulate(buildTris[i]._bbox);
+				++binsCount[bin];
+			}
+			// Sweep from the right, then from the left, to get both sides of each boundary
+			float rightArea[nbSAHBins];
+			unsigned int rightCount[nbSAHBins];
+			BBox sideBBox;
+			unsigned int sideCount = 0;
+			for(unsigned int bin = nbSAHBins - 1; bin > 0; --bin)
+			{
+				if(binsCount[bin] != 0)
+					sideBBox.Encapsulate(binsBBox[bin]);
+				sideCount += binsCount[bin];
+				rightArea[bin] = GetHalfArea(sideBBox);
+				rightCount[bin] = sideCount;
+			}
+			sideBBox.Reset();
+			sideCount = 0;
+			for(unsigned int bin = 0; bin < nbSAHBins - 1; ++bin)
+			{
+				if(binsCount[bin] != 0)
+					sideBBox.Encapsulate(binsBBox[bin]);
+				sideCount += binsCount[bin];
+				if((sideCount == 0) || (rightCount[bin + 1] == 0))
+					continue;
+				float cost = float(sideCount) * GetHalfArea(sideBBox) + float(rightCount[bin + 1]) * rightArea[bin + 1];
+				if(cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestBin = bin;
+					bestBinScale = binScale;
+				}
+			}
+		}
+		float nodeArea = GetHalfArea(bbox);
+		bool splitPays = (bestAxis < 3) && ((nodeArea + bestCost) < (float(nbTriangles) * nodeArea));	// Traversing a node costs about as much as a triangle test
+		if(splitPays || (nbTriangles > maxTrianglesPerLeafWithoutGoodSplit))
+		{
+			if(bestAxis < 3)
+			{
+				float centroidsMin = GetAxis(centroidsBBox.Min(), bestAxis);
+				auto itSplit = std::partition(buildTris.begin() + begin, buildTris.begin() + end, [&](BuildTriangle const& buildTri)
+				{
+					return std::min(nbSAHBins - 1, (unsigned int) ((GetAxis(buildTri._centroid, bestAxis) - centroidsMin) * bestBinScale)) <= bestBin;
+				});
+				splitPos = (unsigned int) (itSplit - buildTris.begin());
+			}
+			if((splitPos == begin) || (splitPos == end))
+				splitPos = begin + nbTriangles / 2;	// All centroids at the same place
+		}
+	}
+	if(splitPos == begin)
+	{	// Leaf
+		std::vector<unsigned int> trisIdx(nbTriangles);
+		for(unsigned int i = 0; i < nbTriangles; ++i)
+		{
+			trisIdx[i] = buildTris[begin + i]._triIdx;
+			_trisLeaf[trisIdx[i]] = nodeIdx;
+		}
+		_nodesTris.Append(nodeIdx, trisIdx);
+		return;
+	}
+	unsigned int firstChildIdx = AddNode(nodeIdx);
+	AddNode(nodeIdx);
+	_nodes[nodeIdx]._firstChildIdx = firstChildIdx;
+	BuildNode(firstChildIdx, buildTris, begin, splitPos);
+	BuildNode(firstChildIdx + 1, buildTris, splitPos, end);
+}
+
+void TrianglesBVH::RebuildLeaf(Mesh const& mesh, unsigned int leafIdx)
+{
+	IndexList leafTris = _nodesTris.GetList(leafIdx);
+	std::vector<BuildTriangle> buildTris(leafTris.size());
+	for(unsigned int i = 0; i < leafTris.size(); ++i)
+	{
+		buildTris[i]._bbox = GetTriangleBBox(mesh, leafTris[i]);
+		buildTris[i]._centroid = buildTris[i]._bbox.Center();
+		buildTris[i]._triIdx = leafTris[i];
+	}
+	_nodesTris.Release(leafIdx);
+	BuildNode(leafIdx, buildTris, 0, (unsigned int) buildTris.size());	// Parents already encapsulate these triangles
+}
+
+unsigned int TrianglesBVH::InsertTriangle(Mesh const& mesh, unsigned int triIdx)
+{
+	BBox triBBox = GetTriangleBBox(mesh, triIdx);
+	unsigned int nodeIdx = 0;
+	while(true)
+	{
+		Node& node = _nodes[nodeIdx];
+		node._bbox.Encapsulate(triBBox);
+		if(node.IsLeaf())
+			break;
+		// Go down the child whose area grows the least
+		float bestGrowth = FLT_MAX;
+		unsigned int bestChildIdx = node._firstChildIdx;
+		for(unsigned int childIdx = node._firstChildIdx; childIdx < node._firstChildIdx + 2; ++childIdx)
+		{
+			BBox grownBBox(triBBox);
+			if(_nodes[childIdx]._bbox.IsValid())
+				grownBBox.Encapsulate(_nodes[childIdx]._bbox);
+			float growth = GetHalfArea(grownBBox) - GetHalfArea(_nodes[childIdx]._bbox);
+			if(growth < bestGrowth)
+			{
+				bestGrowth = growth;
+				bestChildIdx = childIdx;
+			}
+		}
+		nodeIdx = bestChildIdx;
+	}
+	_nodesTris.Append(nodeIdx, &triIdx, 1);
+	_trisLeaf[triIdx] = nodeIdx;
+	return nodeIdx;
+}
+
+void TrianglesBVH::SetVerticesMoved(Mesh const& mesh, std::vector<unsigned int> const& vtxsIdx)
+{
+	if(_hasToRefitAll)
+		return;
+	for(unsigned int vtxIdx : vtxsIdx)
+	{
+		for(unsigned int triIdx : mesh.GetTrianglesAroundVertex(vtxIdx))
+		{
+			if((triIdx < _trisLeaf.size()) && (_trisLeaf[triIdx] != UNDEFINED_NODE_IDX))
+				SetLeafHasToRefit(_trisLeaf[triIdx]);
+		}
+	}
+}
+
+void TrianglesBVH::SetLeafHasToRefit(unsigned int leafIdx)
+{
+	if(!_nodes[leafIdx]._hasToRefit)
+	{
+		_nodes[leafIdx]._hasToRefit = true;
+		_leavesToRefit.push_back(leafIdx);
+	}
+}
+
+void TrianglesBVH::Update(Mesh const& mesh)
+{
+	if(_nodes.empty())
+		return;
+	unsigned int nbTriangles = (unsigned int) mesh.GetTriangles().size() / 3;
+	if(_trisLeaf.size() < nbTriangles)
+		_trisLeaf.resize(nbTriangles, UNDEFINED_NODE_IDX);
+	// Recycled triangles leave their previous leaf before being inserted again
+	std::sort(_trisToInsert.begin(), _trisToInsert.end());
+	_trisToInsert.erase(std::unique(_trisToInsert.begin(), _trisToInsert.end()), _trisToInsert.end());
+	for(unsigned int triIdx : _trisToInsert)
+	{
+		unsigned int leafIdx = _trisLeaf[triIdx];
+		if(leafIdx != UNDEFINED_NODE_IDX)
+		{
+			IndexList leafTris = _nodesTris.GetList(leafIdx);
+			for(unsigned int i = 0; i < leafTris.size(); ++i)
+			{
+				if(leafTris[i] == triIdx)
+				{
+					_nodesTris.RemoveAt(leafIdx, i);
+					break;
+				}
+			}
+			_trisLeaf[triIdx] = UNDEFINED_NODE_IDX;
+			SetLeafHasToRefit(leafIdx);
+		}
+	}
+	// Too many insertions, rebuild it all
+	if(_nbInsertedSinceBuild + _trisToInsert.size() > _nbTrianglesAtBuild / 2)
+	{
+		Build(mesh);
+		return;
+	}
+	// Refit first, so that insertions go down up to date nodes
+	if(_hasToRefitAll)
+		RefitAll(mesh, 0);
+	else
+	{
+		for(unsigned int leafIdx : _leavesToRefit)
+		{
+			RefitLeaf(mesh, leafIdx);
+			RefitUpToRoot(_nodes[leafIdx]._parentIdx);
+		}
+	}
+	_leavesToRefit.clear();
+	_hasToRefitAll = false;
+	// Insert new triangles
+	std::vector<unsigned int> leavesToRebuild;
+	for(unsigned int triIdx : _trisToInsert)
+	{
+		if(mesh.IsTriangleToBeRemoved(triIdx))
+			continue;
+		unsigned int leafIdx = InsertTriangle(mesh, triIdx);
+		if(_nodesTris.GetCount(leafIdx) == maxTrianglesPerLeafBeforeRebuild + 1)
+			leavesToRebuild.push_back(leafIdx);
+	}
+	_nbInsertedSinceBuild += (unsigned int) _trisToInsert.size();
+	_trisToInsert.clear();
+	for(unsigned int leafIdx : leavesToRebuild)
+		RebuildLeaf(mesh, leafIdx);
+	if(_nodesTris.HasToCompact())
+		_nodesTris.Compact();
+}
+
+void TrianglesBVH::RefitLeaf(Mesh const& mesh, unsigned int leafIdx)
+{	// Triangles pending removal are kept in the bbox, queries can be asked to hit them
+	BBox& bbox = _nodes[leafIdx]._bbox;
+	bbox.Reset();
+	for(unsigned int triIdx : _nodesTris.GetList(leafIdx))
+		bbox.Encapsulate(GetTriangleBBox(mesh, triIdx));
+	_nodes[leafIdx]._hasToRefit = false;
+}
+
+void TrianglesBVH::RefitUpToRoot(unsigned int nodeIdx)
+{
+	while(nodeIdx != UNDEFINED_NODE_IDX)
+	{
+		Node& node = _nodes[nodeIdx];
+		BBox bbox(_nodes[node._firstChildIdx]._bbox);
+		if(_nodes[node._firstChildIdx + 1]._bbox.IsValid())
+			bbox.Encapsulate(_nodes[node._firstChildIdx + 1]._bbox);
+		if((bbox.Min() == node._bbox.Min()) && (bbox.Max() == node._bbox.Max()))
+			break;	// Upper nodes won't change either
+		node._bbox = bbox;
+		nodeIdx = node._parentIdx;
+	}
+}
+
+void TrianglesBVH::RefitAll(Mesh const& mesh, unsigned int nodeIdx)
+{
+	if(_nodes[nodeIdx].IsLeaf())
+	{
+		RefitLeaf(mesh, nodeIdx);
+		return;
+	}
+	unsigned int firstChildIdx = _nodes[nodeIdx]._firstChildIdx;
+	RefitAll(mesh, firstChildIdx);
+	RefitAll(mesh, firstChildIdx + 1);
+	BBox& bbox = _nodes[nodeIdx]._bbox;
+	bbox = _nodes[firstChildIdx]._bbox;
+	if(_nodes[firstChildIdx + 1]._bbox.IsValid())
+		bbox.Encapsulate(_nodes[firstChildIdx + 1]._bbox);
+}
+
+void TrianglesBVH::RemapIndices(Mesh const& mesh)
+{
+	for(unsigned int nodeIdx = 0; nodeIdx < _nodes.size(); ++nodeIdx)
+	{
+		unsigned int* trisIdx = _nodesTris.GrabData(nodeIdx);
+		unsigned int initialNbTriangles = _nodesTris.GetCount(nodeIdx);
+		unsigned int nbTriangles = initialNbTriangles;
+		for(unsigned int i = 0; i < nbTriangles;)
+		{
+			unsigned int& triIdx = trisIdx[i];
+			if(mesh.IsTriangleToBeRemoved(triIdx))
+				triIdx = trisIdx[--nbTriangles];	// Remove element
+			else
+			{
+				if(mesh.TriHasToMove(triIdx))
+					triIdx = mesh.GetNewTriIdx(triIdx);	// Remap element
+				++i;
+			}
+		}
+		if(nbTriangles != initialNbTriangles)
+		{
+			_nodesTris.Shrink(nodeIdx, nbTriangles);
+			SetLeafHasToRefit(nodeIdx);
+		}
+	}
+	for(unsigned int i = 0; i < _trisToInsert.size();)
+	{
+		unsigned int& triIdx = _trisToInsert[i];
+		if(mesh.IsTriangleToBeRemoved(triIdx))
+		{
+			triIdx = _trisToInsert.back();
+			_trisToInsert.pop_back();
+		}
+		else
+		{
+			if(mesh.TriHasToMove(triIdx))
+				triIdx = mesh.GetNewTriIdx(triIdx);
+			++i;
+		}
+	}
+	// Leaves content changed, build again the triangles to leaf table
+	for(unsigned int& leafIdx : _trisLeaf)
+		leafIdx = UNDEFINED_NODE_IDX;
+	for(unsigned int nodeIdx = 0; nodeIdx < _nodes.size(); ++nodeIdx)
+	{
+		for(unsigned int triIdx : _nodesTris.GetList(nodeIdx))
+			_trisLeaf[triIdx] = nodeIdx;
+	}
+}
+
+bool TrianglesBVH::GetClosestIntersection(Mesh const& mesh, Ray const& ray, bool cullBackFace, unsigned int& triIdx, float& distance) const
+{
+	triIdx = UNDEFINED_NEW_ID;
+	if(_nodes.empty())
+		return false;
+	std::vector<Vector3> const& vertices = mesh.GetVertices();
+	std::vector<unsigned int> const& triangles = mesh.GetTriangles();
+	std::vector<BSphere> const& trisBSphere = mesh.GetTrisBSphere();
+	Ray closestRay(ray);	// Its length is shrunk to the closest intersection found so far
+	std::vector<unsigned int> hitTrisIdx;	// Ray kernel output, for one leaf
+	std::vector<float> hitDistances;
+	std::vector<std::pair<unsigned int, float>> nodesToVisit;	// Node and entry distance
+	nodesToVisit.reserve(64);
+	float entryDistance;
+	if(closestRay.Intersects(_nodes[0]._bbox, entryDistance))
+		nodesToVisit.push_back(std::make_pair(0, entryDistance));
+	while(!nodesToVisit.empty())
+	{
+		unsigned int nodeIdx = nodesToVisit.back().first;
+		entryDistance = nodesToVisit.back().second;
+		nodesToVisit.pop_back();
+		if(entryDistance > closestRay.GetLength())
+			continue;	// Something closer was found meanwhile
+		Node const& node = _nodes[nodeIdx];
+		if(node.IsLeaf())
+		{
+			IndexList leafTris = _nodesTris.GetList(nodeIdx);
+			if(hitTrisIdx.size() < leafTris.size())
+			{
+				hitTrisIdx.resize(leafTris.size());
+				hitDistances.resize(leafTris.size());
+			}
+			RayTrisJob job = { vertices.data(), triangles.data(), trisBSphere.data(), leafTris.begin(), leafTris.size(), cullBackFace };
+			unsigned int nbHits = IntersectRayTriangles(closestRay, job, hitTrisIdx.data(), hitDistances.data());
+			for(unsigned int i = 0; i < nbHits; ++i)
+			{
+				unsigned int leafTriIdx = hitTrisIdx[i];
+				float triDistance = hitDistances[i];
+				if(mesh.IsTriangleToBeRemoved(leafTriIdx) || (triDistance > closestRay.GetLength()))
+					continue;
+				// On a tie, keep the lowest triangle index (same as VisitorGetClosestIntersection)
+				if((triIdx == UNDEFINED_NEW_ID) || (triDistance < closestRay.GetLength()) || (leafTriIdx < triIdx))
+				{
+					closestRay.SetLength(triDistance);
+					triIdx = leafTriIdx;
+				}
+			}
+		}
+		else
+		{	// Push the farthest child first, so that the closest is visited first
+			float firstEntryDistance, secondEntryDistance;
+			bool hitFirst = closestRay.Intersects(_nodes[node._firstChildIdx]._bbox, firstEntryDistance);
+			bool hitSecond = closestRay.Intersects(_nodes[node._firstChildIdx + 1]._bbox, secondEntryDistance);
+			if(hitFirst && hitSecond && (firstEntryDistance < secondEntryDistance))
+			{
+				nodesToVisit.push_back(std::make_pair(node._firstChildIdx + 1, secondEntryDistance));
+				nodesToVisit.push_back(std::make_pair(node._firstChildIdx, firstEntryDistance));
+			}
+			else
+			{
+				if(hitFirst)
+					nodesToVisit.push_back(std::make_pair(node._firstChildIdx, firstEntryDistance));
+				if(hitSecond)
+					nodesToVisit.push_back(std::make_pair(node._firstChildIdx + 1, secondEntryDistance));
+			}
+		}
+	}
+	distance = closestRay.GetLength();
+	return triIdx != UNDEFINED_NEW_ID;
+}
+
+void TrianglesBVH::GetPacketClosestIntersections(Mesh const& mesh, Ray const* rays, unsigned int nbRays, bool cullBackFace, unsigned int* trisIdx, float* distances) const
+{
+	RayPacket packet(rays, nbRays);	// Rays length is shrunk to the closest intersection found so far
+	for(unsigned int rayIdx = 0; rayIdx < nbRays; ++rayIdx)
+		trisIdx[rayIdx] = UNDEFINED_NEW_ID;
+	if(!_nodes.empty())
+	{
+		std::vector<Vector3> const& vertices = mesh.GetVertices();
+		std::vector<unsigned int> const& triangles = mesh.GetTriangles();
+		std::vector<BSphere> const& trisBSphere = mesh.GetTrisBSphere();
+		std::vector<unsigned int> hitTrisIdx;	// Ray kernel output, for one leaf and one ray
+		std::vector<float> hitDistances;
+		struct NodeToVisit
+		{
+			unsigned int _nodeIdx;
+			unsigned int _raysMask;	// Rays of the packet reaching the node
+			float _entryDistance;	// Closest entry among them
+		};
+		std::vector<NodeToVisit> nodesToVisit;
+		nodesToVisit.reserve(64);
+		NodeToVisit root = { 0, 0, 0.0f };
+		root._raysMask = packet.GetRaysReaching(_nodes[0]._bbox, packet.GetAllRaysMask(), root._entryDistance);
+		if(root._raysMask != 0)
+			nodesToVisit.push_back(root);
+		while(!nodesToVisit.empty())
+		{
+			NodeToVisit toVisit = nodesToVisit.back();
+			nodesToVisit.pop_back();
+			if(toVisit._entryDistance > packet.GetMaxLength(toVisit._raysMask))
+				continue;	// Each of its rays found something closer meanwhile
+			Node const& node = _nodes[toVisit._nodeIdx];
+			if(node.IsLeaf())
+			{
+				IndexList leafTris = _nodesTris.GetList(toVisit._nodeIdx);
+				if(hitTrisIdx.size() < leafTris.size())
+				{
+					hitTrisIdx.resize(leafTris.size());
+					hitDistances.resize(leafTris.size());
+				}
+				RayTrisJob job = { vertices.data(), triangles.data(), trisBSphere.data(), leafTris.begin(), leafTris.size(), cullBackFace };
+				float entryDistance;
+				unsigned int raysMask = packet.GetRaysReaching(node._bbox, toVisit._raysMask, entryDistance);	// Rays still reaching the leaf
+				for(unsigned int rayIdx = 0; rayIdx < nbRays; ++rayIdx)
+				{
+					if((raysMask & (1u << rayIdx)) == 0)
+						continue;
+					Ray const& closestRay = packet.GetRay(rayIdx);
+					unsigned int nbHits = IntersectRayTriangles(closestRay, job, hitTrisIdx.data(), hitDistances.data());
+					for(unsigned int i = 0; i < nbHits; ++i)
+					{
+						unsigned int leafTriIdx = hitTrisIdx[i];
+						float triDistance = hitDistances[i];
+						if(mesh.IsTriangleToBeRemoved(leafTriIdx) || (triDistance > closestRay.GetLength()))
+							continue;
+						// On a tie, keep the lowest triangle index (same as VisitorGetClosestIntersection)
+						if((trisIdx[rayIdx] == UNDEFINED_NEW_ID) || (triDistance < closestRay.GetLength()) || (leafTriIdx < trisIdx[rayIdx]))
+						{
+							packet.SetRayLength(rayIdx, triDistance);
+							trisIdx[rayIdx] = leafTriIdx;
+						}
+					}
+				}
+			}
+			else
+			{	// Push the farthest child first, so that the closest is visited first
+				NodeToVisit first = { node._firstChildIdx, 0, 0.0f };
+				NodeToVisit second = { node._firstChildIdx + 1, 0, 0.0f };
+				first._raysMask = packet.GetRaysReaching(_nodes[first._nodeIdx]._bbox, toVisit._raysMask, first._entryDistance);
+				second._raysMask = packet.GetRaysReaching(_nodes[second._nodeIdx]._bbox, toVisit._raysMask, second._entryDistance);
+				if((first._raysMask != 0) && (second._raysMask != 0) && (first._entryDistance < second._entryDistance))
+				{
+					nodesToVisit.push_back(second);
+					nodesToVisit.push_back(first);
+				}
+				else
+				{
+					if(first._raysMask != 0)
+						nodesToVisit.push_back(first);
+					if(second._raysMask != 0)
+						nodesToVisit.push_back(second);
+				}
+			}
+		}
+	}
+	for(unsigned int rayIdx = 0; rayIdx < nbRays; ++rayIdx)
+		distances[rayIdx] = packet.GetRay(rayIdx).GetLength();
+}
+
+void TrianglesBVH::GetIntersections(Mesh const& mesh, Ray const& ray, bool cullBackFace, bool intersectTriToRemove, std::vector<float>& intersectionDists, std::vector<unsigned int>& intersectionTriangles) const
+{
+	if(_nodes.empty())
+		return;
+	std::vector<Vector3> const& vertices = mesh.GetVertices();
+	std::vector<unsigned int> const& triangles = mesh.GetTriangles();
+	std::vector<BSphere> const& trisBSphere = mesh.GetTrisBSphere();
+	std::vector<unsigned int> hitTrisIdx;	// Ray kernel output, for one leaf
+	std::vector<float> hitDistances;
+	std::vector<unsigned int> nodesToVisit;
+	nodesToVisit.reserve(64);
+	nodesToVisit.push_back(0);
+	while(!nodesToVisit.empty())
+	{
+		unsigned int nodeIdx = nodesToVisit.back();
+		nodesToVisit.pop_back();
+		Node const& node = _nodes[nodeIdx];
+		if(!ray.Intersects(node._bbox))
+			continue;
+		if(node.IsLeaf())
+		{
+			IndexList leafTris = _nodesTris.GetList(nodeIdx);
+			if(hitTrisIdx.size() < leafTris.size())
+			{
+				hitTrisIdx.resize(leafTris.size());
+				hitDistances.resize(leafTris.size());
+			}
+			RayTrisJob job = { vertices.data(), triangles.data(), trisBSphere.data(), leafTris.begin(), leafTris.size(), cullBackFace };
+			unsigned int nbHits = IntersectRayTriangles(ray, job, hitTrisIdx.data(), hitDistances.data());
+			for(unsigned int i = 0; i < nbHits; ++i)
+			{
+				if(!mesh.IsTriangleToBeRemoved(hitTrisIdx[i]) || intersectTriToRemove)
+				{
+					intersectionDists.push_back(hitDistances[i]);
+					intersectionTriangles.push_back(hitTrisIdx[i]);
+				}
+			}
+		}
+		else
+		{
+			nodesToVisit.push_back(node._firstChildIdx);
+			nodesToVisit.push_back(node._firstChildIdx + 1);
+		}
+	}
+}
+
+BBox TrianglesBVH::GetTriangleBBox(Mesh const& mesh, unsigned int triIdx)
+{
+	std::vector<Vector3> const& vertices = mesh.GetVertices();
+	unsigned int const* vtxsIdx = &(mesh.GetTriangles()[triIdx * 3]);
+	BBox bbox(vertices[vtxsIdx[0]], vertices[vtxsIdx[1]]);
+	bbox.Encapsulate(vertices[vtxsIdx[2]]);
+	return bbox;
+}
+
+size_t TrianglesBVH::GetMemoryUsage() const
+{
+	return _nodes.capacity() * sizeof(Node) + _nodesTris.GetMemoryUsage() + (_trisLeaf.capacity() + _leavesToRefit.capacity() + _trisToInsert.capacity()) * sizeof(unsigned int);
+}
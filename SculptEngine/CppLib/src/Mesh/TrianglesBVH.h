@@ -0,0 +1,79 @@
+﻿#ifndef _TRIANGLES_BVH_H_
+#define _TRIANGLES_BVH_H_
+
+#include <vector>
+#include "Math\Math.h"
+#include "Collisions\BBox.h"
+#include "Collisions\Ray.h"
+#include "IndexListsPool.h"
+
+class Mesh;
+
+const unsigned int UNDEFINED_NODE_IDX = 0xFFFFFFFF;
+
+// Bounding volume hierarchy on the mesh triangles, an alternative to the octree for ray queries (see Mesh::SetUseBVH).
+// Nodes bound whole triangles (octree cells take triangles by their first vertex, then their content bboxes overlap a lot), and are split using a binned surface area heuristic.
+// Between two queries, changes are only recorded. Update() then refits the leaves whose triangles moved, and inserts the triangles created by retessellation (a leaf growing too big is rebuilt alone).
+class TrianglesBVH
+{
+public:
+	TrianglesBVH() : _nbTrianglesAtBuild(0), _nbInsertedSinceBuild(0), _hasToRefitAll(false) {}
+
+	void Build(Mesh const& mesh);
+
+	// Changes tracking
+	void SetHasToRefitAll() { _hasToRefitAll = true; }
+	void SetVerticesMoved(Mesh const& mesh, std::vector<unsigned int> const& vtxsIdx);	// Leaves holding the triangles around these vertices will be refitted
+	void AddTrianglesToInsert(std::vector<unsigned int> const& trisIdx) { _trisToInsert.insert(_trisToInsert.end(), trisIdx.begin(), trisIdx.end()); }	// Created or recycled triangles
+	bool HasToUpdate() const { return _hasToRefitAll || !_leavesToRefit.empty() || !_trisToInsert.empty(); }
+	void Update(Mesh const& mesh);
+	void RemapIndices(Mesh const& mesh);	// Drop the triangles pending removal and apply the mesh new triangles indices (has to be called before the mesh moves its triangles)
+
+	// Ray queries (up to date tree expected, see Update())
+	bool GetClosestIntersection(Mesh const& mesh, Ray const& ray, bool cullBackFace, unsigned int& triIdx, float& distance) const;
+	void GetPacketClosestIntersections(Mesh const& mesh, Ray const* rays, unsigned int nbRays, bool cullBackFace, unsigned int* trisIdx, float* distances) const;	// Same for up to RAY_PACKET_SIZE rays traversing the tree together, "trisIdx" is UNDEFINED_NEW_ID for the rays without hit
+	void GetIntersections(Mesh const& mesh, Ray const& ray, bool cullBackFace, bool intersectTriToRemove, std::vector<float>& intersectionDists, std::vector<unsigned int>& intersectionTriangles) const;	// All hits, in no particular order
+
+	// Stats
+	unsigned int GetNodesCount() const { return (unsigned int) _nodes.size(); }
+	size_t GetMemoryUsage() const;
+
+private:
+	struct Node
+	{
+		bool IsLeaf() const { return _firstChildIdx == UNDEFINED_NODE_IDX; }
+
+		BBox _bbox;
+		unsigned int _parentIdx;
+		unsigned int _firstChildIdx;	// Children are 2 consecutive nodes
+		bool _hasToRefit;
+	};
+
+	struct BuildTriangle
+	{
+		BBox _bbox;
+		Vector3 _centroid;
+		unsigned int _triIdx;
+	};
+
+	unsigned int AddNode(unsigned int parentIdx);
+	void BuildNode(unsigned int nodeIdx, std::vector<BuildTriangle>& buildTris, unsigned int begin, unsigned int end);
+	void RebuildLeaf(Mesh const& mesh, unsigned int leafIdx);
+	unsigned int InsertTriangle(Mesh const& mesh, unsigned int triIdx);	// Returns the leaf it landed in
+	void SetLeafHasToRefit(unsigned int leafIdx);
+	void RefitLeaf(Mesh const& mesh, unsigned int leafIdx);
+	void RefitUpToRoot(unsigned int nodeIdx);
+	void RefitAll(Mesh const& mesh, unsigned int nodeIdx);
+	static BBox GetTriangleBBox(Mesh const& mesh, unsigned int triIdx);
+
+	std::vector<Node> _nodes;	// Root is the first one
+	IndexListsPool _nodesTris;	// One list per node, only leaves have triangles
+	std::vector<unsigned int> _trisLeaf;	// Leaf holding each triangle (UNDEFINED_NODE_IDX if none)
+	std::vector<unsigned int> _leavesToRefit;
+	std::vector<unsigned int> _trisToInsert;
+	unsigned int _nbTrianglesAtBuild;
+	unsigned int _nbInsertedSinceBuild;	// Insertions degrade the tree quality, it is fully rebuilt once there were too many
+	bool _hasToRefitAll;
+};
+
+#endif // _TRIANGLES_BVH_H_
@@ -0,0 +1,465 @@
+﻿#include "Benchmarks.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "Mesh\Mesh.h"
+#include "Mesh\MeshLoader.h"
+#include "Math\SimdTraits.h"
+#include "Brushes\BrushDraw.h"
+#include "Brushes\BrushInflate.h"
+
+const int benchmarkRaysCount = 100000;
+const int benchmarkNormalsRecomputeCount = 20;
+const int benchmarkStrokesCount = 200;
+const float normalsKernelsTolerance = 1e-5f;	// On unit normals, and on bounding spheres relatively to their radius
+const int scratchArenaStrokesCount = 100;
+const int scratchArenaWarmUpStrokesCount = 25;	// Until the buffers reach the size the replay dabs need
+
+static double GetTime()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static float RandomRange(float minValue, float maxValue)
+{
+	return minValue + (maxValue - minValue) * (float(rand()) / float(RAND_MAX));
+}
+
+static Ray RandomRayTowardMesh(Mesh& mesh)
+{	// From a point around the mesh toward a point inside it
+	BBox const& bbox = mesh.GetBBox();
+	float radius = bbox.Size().Length();
+	Vector3 target(RandomRange(bbox.Min().x, bbox.Max().x), RandomRange(bbox.Min().y, bbox.Max().y), RandomRange(bbox.Min().z, bbox.Max().z));
+	Vector3 direction(RandomRange(-1.0f, 1.0f), RandomRange(-1.0f, 1.0f), RandomRange(-1.0f, 1.0f));
+	if(direction.Length() < EPSILON)
+		direction = Vector3(0.0f, 0.0f, 1.0f);
+	direction.Normalize();
+	return Ray(target - direction * radius, direction, radius * 2.0f);
+}
+
+static void CameraRaysTowardMesh(Mesh& mesh, int resolution, std::vector<Ray>& rays)
+{	// Screen of "resolution" x "resolution" rays from a point in front of the mesh, row by row (so that consecutive rays are coherent, as for picking)
+	BBox const& bbox = mesh.GetBBox();
+	float radius = bbox.Size().Length();
+	Vector3 eye = bbox.Center() + Vector3(0.0f, 0.0f, radius);
+	for(int y = 0; y < resolution; ++y)
+	{
+		for(int x = 0; x < resolution; ++x)
+		{
+			Vector3 target = bbox.Center() + Vector3(bbox.Size().x * (float(x) / float(resolution - 1) - 0.5f), bbox.Size().y * (float(y) / float(resolution - 1) - 0.5f), 0.0f);
+			Vector3 direction = target - eye;
+			direction.Normalize();
+			rays.push_back(Ray(eye, direction, radius * 2.0f));
+		}
+	}
+}
+
+static Mesh* GenerateDenseSphere(int nbRings, float radius)
+{	// GenSphere resolution is fixed and low, a dense mesh is needed for memory layout to matter
+	std::vector<Vector3> vertices;
+	std::vector<unsigned int> triangles;
+	int nbSegments = nbRings * 2;
+	vertices.push_back(Vector3(0.0f, radius, 0.0f));
+	for(int ring = 1; ring < nbRings; ++ring)
+	{
+		float theta = float(M_PI) * float(ring) / float(nbRings);
+		for(int segment = 0; segment < nbSegments; ++segment)
+		{
+			float phi = 2.0f * float(M_PI) * float(segment) / float(nbSegments);
+			vertices.push_back(Vector3(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi)) * radius);
+		}
+	}
+	vertices.push_back(Vector3(0.0f, -radius, 0.0f));
+	unsigned int lastVtxIdx = (unsigned int) vertices.size() - 1;
+	for(int segment = 0; segment < nbSegments; ++segment)
+	{
+		unsigned int next = (segment + 1) % nbSegments;
+		unsigned int tris[] = { 0, 1 + next, 1 + (unsigned int) segment };
+		triangles.insert(triangles.end(), tris, tris + 3);
+	}
+	for(int ring = 1; ring < nbRings - 1; ++ring)
+	{
+		unsigned int ringStart = 1 + (ring - 1) * nbSegments;
+		for(int segment = 0; segment < nbSegments; ++segment)
+		{
+			unsigned int next = (segment + 1) % nbSegments;
+			unsigned int a = ringStart + segment, b = ringStart + next, c = a + nbSegments, d = b + nbSegments;
+			unsigned int tris[] = { a, b, c, b, d, c };
+			triangles.insert(triangles.end(), tris, tris + 6);
+		}
+	}
+	unsigned int lastRingStart = 1 + (nbRings - 2) * nbSegments;
+	for(int segment = 0; segment < nbSegments; ++segment)
+	{
+		unsigned int next = (segment + 1) % nbSegments;
+		unsigned int tris[] = { lastRingStart + segment, lastRingStart + next, lastVtxIdx };
+		triangles.insert(triangles.end(), tris, tris + 3);
+	}
+	return new Mesh(triangles, vertices, 0, true, false, false, false, false);
+}
+
+static void SculptRandomStrokes(Mesh& mesh, int nbStrokes)
+{	// Retessellation recycles and appends vertices and triangles all over the buffers
+	BrushDraw brushDraw(mesh);
+	BrushInflate brushInflate(mesh);
+	Brush* brushes[] = { &brushDraw, &brushInflate };
+	float meshRadius = mesh.GetBBox().Size().Length() * 0.5f;
+	unsigned int nbExtractedTris = 0;
+	unsigned int nbExtractedVtxs = 0;
+	for(int strokeIdx = 0; strokeIdx < nbStrokes; ++strokeIdx)
+	{
+		Brush& brush = *brushes[strokeIdx % 2];
+		float radius = meshRadius * RandomRange(0.02f, 0.05f);
+		Ray startRay = RandomRayTowardMesh(mesh);
+		Vector3 offset = Vector3(RandomRange(-1.0f, 1.0f), RandomRange(-1.0f, 1.0f), RandomRange(-1.0f, 1.0f)) * (meshRadius * 0.02f);
+		brush.StartStroke();
+		for(int step = 0; step < 20; ++step)
+			brush.UpdateStroke(Ray(startRay.GetOrigin() + offset * float(step), startRay.GetDirection(), startRay.GetLength()), radius, 0.3f);
+		brush.EndStroke();
+		nbExtractedTris += mesh.GetOctreeExtractedTrisCount();
+		nbExtractedVtxs += mesh.GetOctreeExtractedVtxsCount();
+	}
+	printf("Octree extractions per stroke: %.1f triangles, %.1f vertices\n", float(nbExtractedTris) / nbStrokes, float(nbExtractedVtxs) / nbStrokes);
+}
+
+static double SculptFastStrokes(Mesh& mesh, int nbStrokes, bool batchStrokeSamples)
+{	// Few UpdateStroke calls far from each other, each one is made of many time aliasing samples (returns the time spent in UpdateStroke)
+	BrushDraw brushDraw(mesh);
+	BrushInflate brushInflate(mesh);
+	Brush* brushes[] = { &brushDraw, &brushInflate };
+	brushDraw.SetBatchStrokeSamples(batchStrokeSamples);
+	brushInflate.SetBatchStrokeSamples(batchStrokeSamples);
+	float meshRadius = mesh.GetBBox().Size().Length() * 0.5f;
+	double updateTime = 0.0;
+	for(int strokeIdx = 0; strokeIdx < nbStrokes; ++strokeIdx)
+	{
+		Brush& brush = *brushes[strokeIdx % 2];
+		float radius = meshRadius * RandomRange(0.02f, 0.05f);
+		Ray startRay = RandomRayTowardMesh(mesh);
+		Vector3 offset = Vector3(RandomRange(-1.0f, 1.0f), RandomRange(-1.0f, 1.0f), RandomRange(-1.0f, 1.0f)) * (radius * 6.0f);	// About 15 samples per UpdateStroke
+		brush.StartStroke();
+		for(int step = 0; step < 5; ++step)
+		{
+			double begin = GetTime();
+			brush.UpdateStroke(Ray(startRay.GetOrigin() + offset * float(step), startRay.GetDirection(), startRay.GetLength()), radius, 0.3f);
+			updateTime += GetTime() - begin;
+		}
+		brush.EndStroke();
+	}
+	return updateTime;
+}
+
+static void TimeMeshQueries(Mesh& mesh, char const* label)
+{
+	// Full normals recompute (first, so that rays see up to date triangles normal and bounding sphere)
+	double begin = GetTime();
+	for(int i = 0; i < benchmarkNormalsRecomputeCount; ++i)
+		mesh.RecomputeNormals(false, false);
+	double normalsTime = GetTime() - begin;
+	// Ray intersections (VisitorGetIntersection)
+	srand(1);
+	int nbHits = 0;
+	begin = GetTime();
+	for(int i = 0; i < benchmarkRaysCount; ++i)
+	{
+		Vector3 intersectionPos;
+		if(mesh.GetClosestIntersectionPoint(RandomRayTowardMesh(mesh), intersectionPos, nullptr, true))
+			++nbHits;
+	}
+	double raysTime = GetTime() - begin;
+	printf("%-10s %d rays in %.3fs (%d hits), %d normals recompute in %.3fs\n", label, benchmarkRaysCount, raysTime, nbHits, benchmarkNormalsRecomputeCount, normalsTime);
+}
+
+struct NormalsSnapshot
+{
+	std::vector<Vector3> trisNormal;
+	std::vector<BSphere> trisBSphere;
+	std::vector<Vector3> vtxsNormal;
+
+	NormalsSnapshot(Mesh const& mesh) : trisNormal(mesh.GetTrisNormal()), trisBSphere(mesh.GetTrisBSphere()), vtxsNormal(mesh.GetNormals()) {}
+};
+
+static float CompareNormals(NormalsSnapshot const& scalar, Mesh const& mesh, char const* label)
+{	// Largest difference between the scalar results and the ones of the mesh, which must have the same triangles and vertices
+	std::vector<Vector3> const& trisNormal = mesh.GetTrisNormal();
+	std::vector<BSphere> const& trisBSphere = mesh.GetTrisBSphere();
+	std::vector<Vector3> const& vtxsNormal = mesh.GetNormals();
+	float maxTriNormalDelta = 0.0f;
+	float maxTriBSphereDelta = 0.0f;
+	float maxVtxNormalDelta = 0.0f;
+	for(unsigned int i = 0; i < (unsigned int) trisNormal.size(); ++i)
+	{
+		maxTriNormalDelta = std::max(maxTriNormalDelta, (trisNormal[i] - scalar.trisNormal[i]).Length());
+		BSphere const& bsphere = trisBSphere[i];
+		BSphere const& scalarBSphere = scalar.trisBSphere[i];
+		float radius = std::max(scalarBSphere.GetRadius(), EPSILON);
+		maxTriBSphereDelta = std::max(maxTriBSphereDelta, ((bsphere.GetCenter() - scalarBSphere.GetCenter()).Length() + fabsf(bsphere.GetRadius() - scalarBSphere.GetRadius())) / radius);
+	}
+	for(unsigned int i = 0; i < (unsigned int) vtxsNormal.size(); ++i)
+		maxVtxNormalDelta = std::max(maxVtxNormalDelta, (vtxsNormal[i] - scalar.vtxsNormal[i]).Length());
+	printf("%-8s %-9s against scalar: %g triangles normal, %g triangles bsphere, %g vertices normal (max difference)\n", label, GetSimdKernelName(GetSimdKernelType()), maxTriNormalDelta, maxTriBSphereDelta, maxVtxNormalDelta);
+	return std::max(maxTriNormalDelta, std::max(maxTriBSphereDelta, maxVtxNormalDelta));
+}
+
+static void SetHasToRecomputeSomeNormals(Mesh& mesh)
+{	// One vertex out of three, as a stroke would (their triangles and the triangles' vertices follow)
+	for(unsigned int vtxIdx = 0; vtxIdx < (unsigned int) mesh.GetVertices().size(); vtxIdx += 3)
+		mesh.SetHasToRecomputeNormal(vtxIdx);
+}
+
+void CheckNormalsKernels()
+{
+	printf("*** Normals kernels check ***\n");
+	std::unique_ptr<Mesh> mesh(GenerateDenseSphere(400, 100.0f));
+	srand(0);
+	SculptRandomStrokes(*mesh, benchmarkStrokesCount / 4);	// Triangles of all shapes and sizes, in no particular order
+	// Full recompute
+	ForceScalarKernels(true);
+	mesh->RecomputeNormals(false, false);
+	NormalsSnapshot fullScalar(*mesh);
+	ForceScalarKernels(false);
+	mesh->RecomputeNormals(false, false);
+	float fullDelta = CompareNormals(fullScalar, *mesh, "full");
+	// Reduced recompute, on the same subset
+	ForceScalarKernels(true);
+	SetHasToRecomputeSomeNormals(*mesh);
+	mesh->RecomputeNormals(true, false);
+	NormalsSnapshot reducedScalar(*mesh);
+	ForceScalarKernels(false);
+	SetHasToRecomputeSomeNormals(*mesh);
+	mesh->RecomputeNormals(true, false);
+	float reducedDelta = CompareNormals(reducedScalar, *mesh, "reduced");
+	ASSERT(fullDelta <= normalsKernelsTolerance);
+	ASSERT(reducedDelta <= normalsKernelsTolerance);
+	if((fullDelta > normalsKernelsTolerance) || (reducedDelta > normalsKernelsTolerance))
+		printf("Normals kernels differ from the scalar ones by more than %g\n", normalsKernelsTolerance);
+}
+
+void CheckScratchArenaSteadyState()
+{
+	printf("*** Scratch arena check ***\n");
+	std::unique_ptr<Mesh> mesh(GenerateDenseSphere(400, 100.0f));
+	BrushDraw brushDraw(*mesh);
+	BrushInflate brushInflate(*mesh);
+	Brush* brushes[] = { &brushDraw, &brushInflate };
+	float meshRadius = mesh->GetBBox().Size().Length() * 0.5f;
+	float radius = meshRadius * 0.03f;	// Same dab size all along, so that the first dab of a stroke needs as much scratch memory as the next ones
+	srand(0);
+	int nbAllocatingStrokes = 0;
+	for(int strokeIdx = 0; strokeIdx < scratchArenaStrokesCount; ++strokeIdx)
+	{
+		Brush& brush = *brushes[strokeIdx % 2];
+		Ray startRay = RandomRayTowardMesh(*mesh);
+		Vector3 offset = Vector3(RandomRange(-1.0f, 1.0f), RandomRange(-1.0f, 1.0f), RandomRange(-1.0f, 1.0f)) * (meshRadius * 0.02f);
+		brush.StartStroke();
+		brush.UpdateStroke(startRay, radius, 0.3f);
+		unsigned int nbAllocations = mesh->GrabScratchArena().GetAllocationCount();
+		for(int step = 1; step < 20; ++step)
+			brush.UpdateStroke(Ray(startRay.GetOrigin() + offset * float(step), startRay.GetDirection(), startRay.GetLength()), radius, 0.3f);
+		if((strokeIdx >= scratchArenaWarmUpStrokesCount) && (mesh->GrabScratchArena().GetAllocationCount() != nbAllocations))
+			++nbAllocatingStrokes;
+		brush.EndStroke();
+	}
+	printf("%d strokes after %d warm up ones, %d of them allocating scratch buffers after their first dab (%d allocations, %.1f KB)\n", scratchArenaStrokesCount - scratchArenaWarmUpStrokesCount, scratchArenaWarmUpStrokesCount, nbAllocatingStrokes, mesh->GrabScratchArena().GetAllocationCount(), float(mesh->GrabScratchArena().GetMemoryUsage()) / 1024.0f);
+	ASSERT(nbAllocatingStrokes == 0);
+}
+
+void BenchmarkMeshLayout()
+{
+	printf("*** Mesh layout benchmark ***\n");
+	std::unique_ptr<Mesh> mesh(GenerateDenseSphere(400, 100.0f));
+	TimeMeshQueries(*mesh, "loaded");
+	mesh->SetReorderThreshold(0.0f);	// Let strokes scatter vertices and triangles
+	srand(0);
+	SculptRandomStrokes(*mesh, benchmarkStrokesCount);
+	printf("%d strokes: %d vertices, %d triangles, %d of them added or moved\n", benchmarkStrokesCount, (int) mesh->GetVertices().size(), (int) mesh->GetTriangles().size() / 3, (int) mesh->GetScatteredElementsCount());
+	TimeMeshQueries(*mesh, "sculpted");
+	double begin = GetTime();
+	mesh->ReorderPerCell();
+	printf("Reordered in %.3fs\n", GetTime() - begin);
+	TimeMeshQueries(*mesh, "reordered");
+}
+
+static void TimeRayQueries(Mesh& mesh, char const* label)
+{	// Same rays through both structures and both kernels (the first query after a change also pays the BVH update)
+	for(int useBVH = 0; useBVH < 2; ++useBVH)
+	{
+		mesh.SetUseBVH(useBVH != 0);
+		for(int scalarKernels = 1; scalarKernels >= 0; --scalarKernels)
+		{
+			ForceScalarKernels(scalarKernels != 0);
+			srand(1);
+			int nbHits = 0;
+			double begin = GetTime();
+			for(int i = 0; i < benchmarkRaysCount; ++i)
+			{
+				Vector3 intersectionPos;
+				if(mesh.GetClosestIntersectionPoint(RandomRayTowardMesh(mesh), intersectionPos, nullptr, true))
+					++nbHits;
+			}
+			printf("%-10s %-6s %-9s %d rays in %.3fs (%d hits)\n", label, useBVH ? "BVH" : "octree", GetSimdKernelName(GetSimdKernelType()), benchmarkRaysCount, GetTime() - begin, nbHits);
+		}
+	}
+}
+
+static void TimePacketRayQueries(Mesh& mesh, char const* label)
+{	// Coherent rays, one at a time then by packets
+	std::vector<Ray> rays;
+	CameraRaysTowardMesh(mesh, 320, rays);
+	std::vector<RayHit> hits;
+	for(int useBVH = 0; useBVH < 2; ++useBVH)
+	{
+		mesh.SetUseBVH(useBVH != 0);
+		int nbHits = 0;
+		double begin = GetTime();
+		for(Ray const& ray : rays)
+		{
+			Vector3 intersectionPos;
+			if(mesh.GetClosestIntersectionPoint(ray, intersectionPos, nullptr, true))
+				++nbHits;
+		}
+		printf("%-10s %-6s single %d camera rays in %.3fs (%d hits)\n", label, useBVH ? "BVH" : "octree", (int) rays.size(), GetTime() - begin, nbHits);
+		nbHits = 0;
+		begin = GetTime();
+		mesh.IntersectRays(rays, hits, true);
+		for(RayHit const& hit : hits)
+		{
+			if(hit.hasHit)
+				++nbHits;
+		}
+		printf("%-10s %-6s packet %d camera rays in %.3fs (%d hits)\n", label, useBVH ? "BVH" : "octree", (int) rays.size(), GetTime() - begin, nbHits);
+	}
+}
+
+static void BenchmarkRayQueries(Mesh& mesh, char const* meshName)
+{
+	printf("%s: %d vertices, %d triangles\n", meshName, (int) mesh.GetVertices().size(), (int) mesh.GetTriangles().size() / 3);
+	double begin = GetTime();
+	mesh.SetUseBVH(true);
+	printf("BVH built in %.3fs\n", GetTime() - begin);
+	TimeRayQueries(mesh, "loaded");
+	TimePacketRayQueries(mesh, "loaded");
+	// Sculpt with the BVH on (it was left on), so that it goes through refits and insertions instead of being built again
+	srand(0);
+	begin = GetTime();
+	SculptRandomStrokes(mesh, benchmarkStrokesCount / 4);
+	printf("%d strokes in %.3fs: %d triangles\n", benchmarkStrokesCount / 4, GetTime() - begin, (int) mesh.GetTriangles().size() / 3);
+	srand(1);
+	int nbHits = 0;
+	begin = GetTime();
+	for(int i = 0; i < benchmarkRaysCount; ++i)
+	{
+		Vector3 intersectionPos;
+		if(mesh.GetClosestIntersectionPoint(RandomRayTowardMesh(mesh), intersectionPos, nullptr, true))
+			++nbHits;
+	}
+	printf("%-10s %-6s %-9s %d rays in %.3fs (%d hits)\n", "sculpted", "BVH", GetSimdKernelName(GetSimdKernelType()), benchmarkRaysCount, GetTime() - begin, nbHits);	// Updated tree
+	TimeRayQueries(mesh, "sculpted");	// Freshly built tree
+	TimePacketRayQueries(mesh, "sculpted");
+}
+
+void BenchmarkAccelerationStructures()
+{
+	printf("*** Acceleration structures benchmark ***\n");
+	{
+		std::unique_ptr<Mesh> mesh(GenerateDenseSphere(400, 100.0f));
+		BenchmarkRayQueries(*mesh, "dense sphere");
+	}
+	// Large scan meshes, skipped if not found
+	char const* scanFilenames[] = { "C:\\data\\from clara.io\\head-scan.obj", "C:\\data\\from turbosquid\\ConceptDragon_highpoly.OBJ" };
+	for(char const* filename : scanFilenames)
+	{
+		MeshLoader meshLoader;
+		std::unique_ptr<Mesh> mesh(meshLoader.LoadFromFile(filename));
+		if(mesh != nullptr)
+			BenchmarkRayQueries(*mesh, filename);
+	}
+}
+
+void BenchmarkOctreeLooseness()
+{
+	printf("*** Octree looseness benchmark ***\n");
+	float loosenessValues[] = { 1.0f, 1.25f, 1.5f, 2.0f };
+	for(float looseness : loosenessValues)
+	{
+		std::unique_ptr<Mesh> mesh(GenerateDenseSphere(400, 100.0f));
+		mesh->SetOctreeLooseness(looseness);
+		printf("Looseness %.2f\n", looseness);
+		srand(0);
+		double begin = GetTime();
+		SculptRandomStrokes(*mesh, benchmarkStrokesCount);
+		printf("%d strokes in %.3fs\n", benchmarkStrokesCount, GetTime() - begin);
+		TimeMeshQueries(*mesh, "sculpted");
+	}
+}
+
+void BenchmarkOctreeLeafCapacity()
+{
+	printf("*** Octree leaf capacity benchmark ***\n");
+	int nbRingsValues[] = { 112, 400, 1120 };	// About 50K, 640K and 5M triangles
+	for(int nbRings : nbRingsValues)
+	{
+		std::unique_ptr<Mesh> mesh(GenerateDenseSphere(nbRings, 100.0f));
+		printf("%d triangles\n", (int) (mesh->GetTriangles().size() / 3));
+		TimeMeshQueries(*mesh, "default capacity");
+		double begin = GetTime();
+		unsigned int leafCapacity = mesh->AutoTuneOctreeLeafCapacity();
+		printf("Auto tuned leaf capacity %d in %.3fs\n", leafCapacity, GetTime() - begin);
+		TimeMeshQueries(*mesh, "tuned capacity");
+		mesh->UpdateSubMeshes();
+		printf("%d sub meshes\n", mesh->GetSubMeshCount());
+	}
+}
+
+void BenchmarkStrokeSamplesBatching()
+{
+	printf("*** Stroke samples batching benchmark ***\n");
+	std::vector<Ray> rays;
+	std::vector<RayHit> hits[2];
+	for(int batch = 0; batch < 2; ++batch)
+	{
+		std::unique_ptr<Mesh> mesh(GenerateDenseSphere(400, 100.0f));
+		srand(0);	// Same strokes for both
+		double updateTime = SculptFastStrokes(*mesh, benchmarkStrokesCount / 2, batch != 0);
+		printf("%-10s %d strokes, UpdateStroke in %.3fs: %d triangles\n", batch ? "batched" : "per sample", benchmarkStrokesCount / 2, updateTime, (int) mesh->GetTriangles().size() / 3);
+		if(rays.empty())
+			CameraRaysTowardMesh(*mesh, 320, rays);
+		mesh->IntersectRays(rays, hits[batch], true);
+	}
+	// Both results seen from the same camera
+	float maxDelta = 0.0f;
+	float sumDelta = 0.0f;
+	int nbCompared = 0;
+	int nbDiffering = 0;
+	int nbMismatches = 0;
+	for(unsigned int i = 0; i < (unsigned int) rays.size(); ++i)
+	{
+		if(hits[0][i].hasHit != hits[1][i].hasHit)
+			++nbMismatches;
+		else if(hits[0][i].hasHit)
+		{
+			float delta = fabsf(hits[0][i].distance - hits[1][i].distance);
+			maxDelta = std::max(maxDelta, delta);
+			sumDelta += delta;
+			++nbCompared;
+			if(delta > 1.0f)
+				++nbDiffering;
+		}
+	}
+	printf("Depth difference on %d pixels: %.4f average, %.4f max (sphere radius 100), %d pixels above 1.0, %d hit mismatches\n", nbCompared, (nbCompared != 0) ? sumDelta / float(nbCompared) : 0.0f, maxDelta, nbDiffering, nbMismatches);
+}
+
+void RunBenchmarks()
+{
+	CheckNormalsKernels();
+	CheckScratchArenaSteadyState();
+	BenchmarkMeshLayout();
+	BenchmarkAccelerationStructures();
+	BenchmarkOctreeLooseness();
+	BenchmarkOctreeLeafCapacity();
+	BenchmarkStrokeSamplesBatching();
+}
@@ -0,0 +1,15 @@
+﻿#ifndef _BENCHMARKS_H_
+#define _BENCHMARKS_H_
+
+// Sculpt engine timings printed on the console (no rendering involved)
+void RunBenchmarks();
+
+void CheckNormalsKernels();	// Full and reduced normals recompute with the SIMD kernels against the scalar ones, prints (and asserts) the largest difference
+void CheckScratchArenaSteadyState();	// Strokes replayed with a constant dab size, prints (and asserts) how many of them still allocate scratch buffers after their first dab
+void BenchmarkMeshLayout();	// Ray intersections and normals recompute, on a sculpted mesh then once reordered per octree cell
+void BenchmarkAccelerationStructures();	// Ray intersections through the octree and the BVH (scalar and SIMD ray kernels), on a dense sphere and on scan meshes if found
+void BenchmarkOctreeLooseness();	// Strokes time and octree extractions per stroke, from a strict to a loose octree
+void BenchmarkOctreeLeafCapacity();	// Queries time before and after auto tuning the octree leaf capacity, from a small to a huge mesh
+void BenchmarkStrokeSamplesBatching();	// Fast strokes replayed with and without batching their time aliasing samples, then compared from a camera
+
+#endif // _BENCHMARKS_H_
@@ -8,6 +8,7 @@
 //#define NO_MESH_UPDATE	// To use to profile sculpt engine itself
 #define MULTI_SCREEN
 //#define DEBUG_HUD
+//#define RUN_BENCHMARKS	// Print sculpt engine timings in the console then quit
 
 #include <osg/Geode>
 #include <osg/ShapeDrawable>
@@ -46,6 +47,10 @@
 #include "OgsSubMesh.h"
 #endif // USE_SUBMESHES
 
+#ifdef RUN_BENCHMARKS
+#include "Benchmarks.h"
+#endif // RUN_BENCHMARKS
+
 #ifdef PLAY_RECORDER
 #include "Recorder\CommandRecorder.h"
 #include <windows.h>
@@ -984,6 +989,11 @@ int main(int, char **)
 	_CrtSetBreakAlloc(-1);
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 
+#ifdef RUN_BENCHMARKS
+	RunBenchmarks();
+	return 0;
+#endif // RUN_BENCHMARKS
+
 	// construct the viewer.
 	_viewer = new osgViewer::Viewer();
 #ifdef MULTI_SCREEN
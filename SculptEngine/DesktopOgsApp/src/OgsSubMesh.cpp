@@ -25,26 +25,43 @@ void OgsSubMesh::Update()
     unsigned int curVersionNumber = _subMesh->GetVersionNumber();
     if(_versionNumber != curVersionNumber)  // Only update data if sub mesh has been updated
     {
+		if(_subMesh->CanPartialUpdateFrom(_versionNumber))
+			PatchMesh();	// Only some vertices moved
+		else
+			RebuildMesh();
         _versionNumber = curVersionNumber;
-		RebuildMesh();
     }
 }
 
+void OgsSubMesh::PatchMesh()
+{
+	// Transfer modified vertices and normals ranges only
+	Vector3 const* vertices = _subMesh->GetVerticesData();
+	Vector3 const* normals = _subMesh->GetNormalsData();
+	std::vector<unsigned int> const& dirtyRanges = _subMesh->GetDirtyRanges();
+	ASSERT(_vertexArray->size() == _subMesh->GetVerticesCount());
+	for(unsigned int i = 0; i < dirtyRanges.size(); i += 2)
+	{
+		memcpy((void*) &((*_vertexArray)[dirtyRanges[i]]), &(vertices[dirtyRanges[i]]), dirtyRanges[i + 1] * sizeof(Vector3));
+		memcpy((void*) &((*_normalArray)[dirtyRanges[i]]), &(normals[dirtyRanges[i]]), dirtyRanges[i + 1] * sizeof(Vector3));
+	}
+	_vertexArray->dirty();
+	_normalArray->dirty();
+}
+
 void OgsSubMesh::RebuildMesh()
 {
 	// Transfer vertices
-	std::vector<Vector3> const& vertices = _subMesh->GetVertices();
-	_vertexArray->resize(vertices.size());
-	memcpy((void*) _vertexArray->getDataPointer(), vertices.data(), vertices.size() * sizeof(Vector3));
+	_vertexArray->resize(_subMesh->GetVerticesCount());
+	memcpy((void*) _vertexArray->getDataPointer(), _subMesh->GetVerticesData(), _subMesh->GetVerticesCount() * sizeof(Vector3));
 	if(_subMeshOsgNode->getVertexArray() == nullptr)
 		_subMeshOsgNode->setVertexArray(_vertexArray);
 	else
 		_vertexArray->dirty();
 
 	// Transfer normals
-	std::vector<Vector3> const& normals = _subMesh->GetNormals();
-	_normalArray->resize(normals.size());
-	memcpy((void*) _normalArray->getDataPointer(), normals.data(), normals.size() * sizeof(Vector3));
+	_normalArray->resize(_subMesh->GetVerticesCount());
+	memcpy((void*) _normalArray->getDataPointer(), _subMesh->GetNormalsData(), _subMesh->GetVerticesCount() * sizeof(Vector3));
 	if(_subMeshOsgNode->getNormalArray() == nullptr)
 		_subMeshOsgNode->setNormalArray(_normalArray, osg::Array::BIND_PER_VERTEX);
 	else
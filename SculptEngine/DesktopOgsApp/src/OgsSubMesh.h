@@ -18,6 +18,7 @@ public:
 
 private:
 	void RebuildMesh();
+	void PatchMesh();
 
 	osg::ref_ptr<osg::Vec3Array> _vertexArray = nullptr;
 	osg::ref_ptr<osg::Vec3Array> _normalArray = nullptr;
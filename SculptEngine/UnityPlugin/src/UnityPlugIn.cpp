@@ -14,6 +14,7 @@
 #include "Brushes\BrushDrag.h"
 #include "Brushes\BrushDig.h"
 #include "Brushes\BrushCADDrag.h"
+#include "Brushes\BrushSmooth.h"
 
 // Octree test
 #include "Mesh\Octree.h"
@@ -348,6 +349,65 @@ extern "C"
 		return false;
 	}
 
+	unsigned int Mesh_IntersectRays(void *mesh, float* meshRotAndScale3x3Matrix, float* meshPosition, float* rays, unsigned int nbRays, float* intersectionPoints, float* intersectionNormals, int* intersectionTriangles)
+	{
+#ifdef _DEBUG
+		_control87(MCW_EM, MCW_EM); // Turn off FPU exception (needed in debug build not to crash unity)
+#endif	// _DEBUG
+		Mesh* typedMesh = (Mesh*) mesh;
+		if(typedMesh != nullptr)
+		{
+			// Create world to local and local to world transforms
+			Matrix3 mtx(meshRotAndScale3x3Matrix);
+			Matrix3 invMtx(mtx);
+			invMtx.Invert();
+			Vector3 pos(meshPosition[0], meshPosition[1], meshPosition[2]);
+			// Create our rays in local mesh coordinates
+			std::vector<Ray> typedRays(nbRays);
+			for(unsigned int i = 0; i < nbRays; ++i)
+			{
+				float* ray = &(rays[i * 6]);
+				Ray& typedRay = typedRays[i];
+				typedRay = Ray(Vector3(ray[0], ray[1], ray[2]), Vector3(ray[3], ray[4], ray[5]), FLT_MAX);
+				typedRay.GrabOrigin() -= pos;
+				invMtx.Transform(typedRay.GrabOrigin());
+				invMtx.Transform(typedRay.GrabDirection());
+				typedRay.GrabDirection().Normalize();
+			}
+			// Get closest intersections
+			std::vector<RayHit> hits;
+			typedMesh->IntersectRays(typedRays, hits, true);
+			unsigned int nbHits = 0;
+			for(unsigned int i = 0; i < nbRays; ++i)
+			{
+				RayHit& hit = hits[i];
+				if(hit.hasHit)
+					++nbHits;
+				// Transform intersection point from local to world and set it on output
+				mtx.Transform(hit.point);
+				hit.point += pos;
+				intersectionPoints[i * 3] = hit.point.x;
+				intersectionPoints[i * 3 + 1] = hit.point.y;
+				intersectionPoints[i * 3 + 2] = hit.point.z;
+				if(intersectionNormals != nullptr)
+				{
+					// Transform intersection normal from local to world and set it on output
+					if(hit.hasHit)
+						mtx.Transform(hit.normal);
+					else
+						hit.normal.ResetToZero();
+					intersectionNormals[i * 3] = hit.normal.x;
+					intersectionNormals[i * 3 + 1] = hit.normal.y;
+					intersectionNormals[i * 3 + 2] = hit.normal.z;
+				}
+				if(intersectionTriangles != nullptr)
+					intersectionTriangles[i] = hit.hasHit ? (int) hit.triangle : -1;
+			}
+			return nbHits;
+		}
+		return 0;
+	}
+
 	bool Mesh_CanUndo(void *mesh)
 	{
 #ifdef _DEBUG
@@ -458,6 +518,17 @@ extern "C"
 		return nullptr;
 	}
 
+	void* BrushSmooth_Create(void *mesh)
+	{
+#ifdef _DEBUG
+		_control87(MCW_EM, MCW_EM); // Turn off FPU exception (needed in debug build not to crash unity)
+#endif	// _DEBUG
+		Mesh* typedMesh = (Mesh*) mesh;
+		if(typedMesh != nullptr)
+			return new BrushSmooth(*typedMesh);
+		return nullptr;
+	}
+
 	void Brush_StartStroke(void *brush)
 	{
 #ifdef _DEBUG
@@ -501,6 +572,36 @@ extern "C"
 			typedBrush->EndStroke();
 	}
 
+	void Brush_SetBatchStrokeSamples(void *brush, bool batchStrokeSamples)
+	{
+#ifdef _DEBUG
+		_control87(MCW_EM, MCW_EM); // Turn off FPU exception (needed in debug build not to crash unity)
+#endif	// _DEBUG
+		Brush* typedBrush = (Brush*) brush;
+		if(typedBrush != nullptr)
+			typedBrush->SetBatchStrokeSamples(batchStrokeSamples);
+	}
+
+	void BrushSmooth_SetIterations(void *brush, unsigned int nbIterations)
+	{
+#ifdef _DEBUG
+		_control87(MCW_EM, MCW_EM); // Turn off FPU exception (needed in debug build not to crash unity)
+#endif	// _DEBUG
+		BrushSmooth* typedBrush = (BrushSmooth*) brush;
+		if(typedBrush != nullptr)
+			typedBrush->SetIterations(nbIterations);
+	}
+
+	void BrushSmooth_SetTaubin(void *brush, bool taubin)
+	{
+#ifdef _DEBUG
+		_control87(MCW_EM, MCW_EM); // Turn off FPU exception (needed in debug build not to crash unity)
+#endif	// _DEBUG
+		BrushSmooth* typedBrush = (BrushSmooth*) brush;
+		if(typedBrush != nullptr)
+			typedBrush->SetTaubin(taubin);
+	}
+
 	void Brush_Delete(void *brush)
 	{
 #ifdef _DEBUG
@@ -554,6 +655,67 @@ extern "C"
 		return false;
 	}
 
+	void Mesh_SetSubMeshesShareBuffers(void *fullMesh, bool shareBuffers)
+	{
+#ifdef _DEBUG
+		_control87(MCW_EM, MCW_EM); // Turn off FPU exception (needed in debug build not to crash unity)
+#endif	// _DEBUG
+		Mesh* typedFullMesh = (Mesh*) fullMesh;
+		if(typedFullMesh != nullptr)
+			typedFullMesh->SetSubMeshesShareBuffers(shareBuffers);
+	}
+
+	void Mesh_SetUseBVH(void *fullMesh, bool useBVH)
+	{
+#ifdef _DEBUG
+		_control87(MCW_EM, MCW_EM); // Turn off FPU exception (needed in debug build not to crash unity)
+#endif	// _DEBUG
+		Mesh* typedFullMesh = (Mesh*) fullMesh;
+		if(typedFullMesh != nullptr)
+			typedFullMesh->SetUseBVH(useBVH);
+	}
+
+	void Mesh_SetOctreeLooseness(void *fullMesh, float looseness)
+	{
+#ifdef _DEBUG
+		_control87(MCW_EM, MCW_EM); // Turn off FPU exception (needed in debug build not to crash unity)
+#endif	// _DEBUG
+		Mesh* typedFullMesh = (Mesh*) fullMesh;
+		if(typedFullMesh != nullptr)
+			typedFullMesh->SetOctreeLooseness(looseness);
+	}
+
+	void Mesh_SetOctreeLeafCapacity(void *fullMesh, unsigned int maxTrianglesPerLeaf)
+	{
+#ifdef _DEBUG
+		_control87(MCW_EM, MCW_EM); // Turn off FPU exception (needed in debug build not to crash unity)
+#endif	// _DEBUG
+		Mesh* typedFullMesh = (Mesh*) fullMesh;
+		if(typedFullMesh != nullptr)
+			typedFullMesh->SetOctreeLeafCapacity(maxTrianglesPerLeaf);
+	}
+
+	unsigned int Mesh_AutoTuneOctreeLeafCapacity(void *fullMesh)
+	{
+#ifdef _DEBUG
+		_control87(MCW_EM, MCW_EM); // Turn off FPU exception (needed in debug build not to crash unity)
+#endif	// _DEBUG
+		Mesh* typedFullMesh = (Mesh*) fullMesh;
+		if(typedFullMesh != nullptr)
+			return typedFullMesh->AutoTuneOctreeLeafCapacity();
+		return 0;
+	}
+
+	void Mesh_SetSubMeshesMaxVertices(void *fullMesh, unsigned int maxVertices)
+	{
+#ifdef _DEBUG
+		_control87(MCW_EM, MCW_EM); // Turn off FPU exception (needed in debug build not to crash unity)
+#endif	// _DEBUG
+		Mesh* typedFullMesh = (Mesh*) fullMesh;
+		if(typedFullMesh != nullptr)
+			typedFullMesh->SetSubMeshesMaxVertices(maxVertices);
+	}
+
 	unsigned int SubMesh_GetID(void *subMesh)
 	{
 #ifdef _DEBUG
@@ -613,7 +775,7 @@ extern "C"
 #endif	// _DEBUG
 		SubMesh* typedSubMesh = (SubMesh*) subMesh;
 		if(typedSubMesh != nullptr)
-			return (unsigned int) typedSubMesh->GetVertices().size();
+			return typedSubMesh->GetVerticesCount();
 		return 0;
 	}
 
@@ -634,7 +796,7 @@ extern "C"
 #endif	// _DEBUG
 		SubMesh* typedSubMesh = (SubMesh*) subMesh;
 		if(typedSubMesh != nullptr)
-			memcpy(data, typedSubMesh->GetVertices().data(), typedSubMesh->GetVertices().size() * 3 * sizeof(float));
+			memcpy(data, typedSubMesh->GetVerticesData(), typedSubMesh->GetVerticesCount() * 3 * sizeof(float));
 	}
 
 	void SubMesh_FillNormals(void *subMesh, float* data)
@@ -644,7 +806,48 @@ extern "C"
 #endif	// _DEBUG
 		SubMesh* typedSubMesh = (SubMesh*) subMesh;
 		if(typedSubMesh != nullptr)
-			memcpy(data, typedSubMesh->GetNormals().data(), typedSubMesh->GetNormals().size() * 3 * sizeof(float));
+			memcpy(data, typedSubMesh->GetNormalsData(), typedSubMesh->GetVerticesCount() * 3 * sizeof(float));
+	}
+
+	int SubMesh_GetNbDirtyRanges(void *subMesh, unsigned int fromVersionNumber)
+	{
+#ifdef _DEBUG
+		_control87(MCW_EM, MCW_EM); // Turn off FPU exception (needed in debug build not to crash unity)
+#endif	// _DEBUG
+		SubMesh* typedSubMesh = (SubMesh*) subMesh;
+		if((typedSubMesh != nullptr) && typedSubMesh->CanPartialUpdateFrom(fromVersionNumber))
+			return (int) typedSubMesh->GetDirtyRanges().size() / 2;
+		return -1;
+	}
+
+	void SubMesh_GetDirtyRanges(void *subMesh, int* data)
+	{
+#ifdef _DEBUG
+		_control87(MCW_EM, MCW_EM); // Turn off FPU exception (needed in debug build not to crash unity)
+#endif	// _DEBUG
+		SubMesh* typedSubMesh = (SubMesh*) subMesh;
+		if(typedSubMesh != nullptr)
+			memcpy(data, typedSubMesh->GetDirtyRanges().data(), typedSubMesh->GetDirtyRanges().size() * sizeof(unsigned int));
+	}
+
+	void SubMesh_FillVerticesRange(void *subMesh, unsigned int firstVertex, unsigned int nbVertices, float* data)
+	{
+#ifdef _DEBUG
+		_control87(MCW_EM, MCW_EM); // Turn off FPU exception (needed in debug build not to crash unity)
+#endif	// _DEBUG
+		SubMesh* typedSubMesh = (SubMesh*) subMesh;
+		if((typedSubMesh != nullptr) && (firstVertex + nbVertices <= typedSubMesh->GetVerticesCount()))
+			memcpy(data + firstVertex * 3, typedSubMesh->GetVerticesData() + firstVertex, nbVertices * 3 * sizeof(float));
+	}
+
+	void SubMesh_FillNormalsRange(void *subMesh, unsigned int firstVertex, unsigned int nbVertices, float* data)
+	{
+#ifdef _DEBUG
+		_control87(MCW_EM, MCW_EM); // Turn off FPU exception (needed in debug build not to crash unity)
+#endif	// _DEBUG
+		SubMesh* typedSubMesh = (SubMesh*) subMesh;
+		if((typedSubMesh != nullptr) && (firstVertex + nbVertices <= typedSubMesh->GetVerticesCount()))
+			memcpy(data + firstVertex * 3, typedSubMesh->GetNormalsData() + firstVertex, nbVertices * 3 * sizeof(float));
 	}
 
 	bool CSGMerge(void *mesh, void *otherMesh, float* rotAndScale3x3Matrix, float* position)
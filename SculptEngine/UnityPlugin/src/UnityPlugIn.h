@@ -28,6 +28,7 @@ extern "C"
 	UNITYPLUGIN_API void Mesh_FillNormals(void *mesh, float* data);
 
 	UNITYPLUGIN_API bool Mesh_GetClosestIntersectionPoint(void *mesh, float* meshRotAndScale3x3Matrix, float* meshPosition, float* ray, float* intersectionPoint, float* intersectionNormal);
+	UNITYPLUGIN_API unsigned int Mesh_IntersectRays(void *mesh, float* meshRotAndScale3x3Matrix, float* meshPosition, float* rays, unsigned int nbRays, float* intersectionPoints, float* intersectionNormals, int* intersectionTriangles);	// 6 floats per ray (origin, direction), 3 per point and normal, triangle is -1 if no hit. Returns the hits count
 
 	UNITYPLUGIN_API bool Mesh_CanUndo(void *mesh);
 	UNITYPLUGIN_API bool Mesh_Undo(void *mesh);
@@ -40,9 +41,13 @@ extern "C"
 	UNITYPLUGIN_API void* BrushDrag_Create(void *mesh);
 	UNITYPLUGIN_API void* BrushDig_Create(void *mesh);
 	UNITYPLUGIN_API void* BrushCADDrag_Create(void *mesh);
+	UNITYPLUGIN_API void* BrushSmooth_Create(void *mesh);
 	UNITYPLUGIN_API void Brush_StartStroke(void *brush);
 	UNITYPLUGIN_API void Brush_UpdateStroke(void *brush, float* meshRotAndScale3x3Matrix, float* meshPosition, float* rayOrigin, float* rayDirection, float rayLength, float radius, float effectRatio);
 	UNITYPLUGIN_API void Brush_EndStroke(void *brush);
+	UNITYPLUGIN_API void Brush_SetBatchStrokeSamples(void *brush, bool batchStrokeSamples);
+	UNITYPLUGIN_API void BrushSmooth_SetIterations(void *brush, unsigned int nbIterations);	// "brush" has to be a BrushSmooth
+	UNITYPLUGIN_API void BrushSmooth_SetTaubin(void *brush, bool taubin);
 
 	UNITYPLUGIN_API void Brush_Delete(void *brush);
 
@@ -51,6 +56,12 @@ extern "C"
 	UNITYPLUGIN_API unsigned int Mesh_GetSubMeshCount(void *fullMesh);
 	UNITYPLUGIN_API void* Mesh_GetSubMesh(void *fullMesh, unsigned int index);
 	UNITYPLUGIN_API bool Mesh_IsSubMeshExist(void *fullMesh, unsigned int submeshID);
+	UNITYPLUGIN_API void Mesh_SetSubMeshesShareBuffers(void *fullMesh, bool shareBuffers);
+	UNITYPLUGIN_API void Mesh_SetUseBVH(void *fullMesh, bool useBVH);
+	UNITYPLUGIN_API void Mesh_SetOctreeLooseness(void *fullMesh, float looseness);
+	UNITYPLUGIN_API void Mesh_SetOctreeLeafCapacity(void *fullMesh, unsigned int maxTrianglesPerLeaf);
+	UNITYPLUGIN_API unsigned int Mesh_AutoTuneOctreeLeafCapacity(void *fullMesh);
+	UNITYPLUGIN_API void Mesh_SetSubMeshesMaxVertices(void *fullMesh, unsigned int maxVertices);
 
 	UNITYPLUGIN_API unsigned int SubMesh_GetID(void *subMesh);
 	UNITYPLUGIN_API unsigned int SubMesh_GetVersionNumber(void *subMesh);
@@ -60,6 +71,10 @@ extern "C"
 	UNITYPLUGIN_API void SubMesh_FillTriangles(void *subMesh, int* data);
 	UNITYPLUGIN_API void SubMesh_FillVertices(void *subMesh, float* data);
 	UNITYPLUGIN_API void SubMesh_FillNormals(void *subMesh, float* data);
+	UNITYPLUGIN_API int SubMesh_GetNbDirtyRanges(void *subMesh, unsigned int fromVersionNumber);	// Returns -1 if a partial update from the given version isn't possible
+	UNITYPLUGIN_API void SubMesh_GetDirtyRanges(void *subMesh, int* data);	// (first vertex, vertex count) pairs
+	UNITYPLUGIN_API void SubMesh_FillVerticesRange(void *subMesh, unsigned int firstVertex, unsigned int nbVertices, float* data);	// data is the whole vertex buffer, only the range is written
+	UNITYPLUGIN_API void SubMesh_FillNormalsRange(void *subMesh, unsigned int firstVertex, unsigned int nbVertices, float* data);	// data is the whole normal buffer, only the range is written
 
 	// CSG / Boolean meshes
 	UNITYPLUGIN_API bool CSGMerge(void *mesh, void *otherMesh, float* rotAndScale3x3Matrix, float* position);
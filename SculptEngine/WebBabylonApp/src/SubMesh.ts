@@ -47,8 +47,32 @@
         let curVersionNumber: number = this._subMesh.GetVersionNumber();
         if(this._versionNumber != curVersionNumber)  // Only update data if sub mesh has been updated
         {
+            if(this._subMesh.CanPartialUpdateFrom(this._versionNumber))
+                this.PatchMeshData();   // Only some vertices moved
+            else
+                this.UpdataMeshData();
             this._versionNumber = curVersionNumber;
-            this.UpdataMeshData();
+        }
+    }
+
+    public PatchMeshData()
+    {
+        let buf: Int8Array = this._subMesh.DirtyRanges();
+        let dirtyRanges: Uint32Array = new Uint32Array(buf.buffer, buf.byteOffset, buf.byteLength / 4);
+        buf = this._subMesh.Vertices();
+        let vertices: Float32Array = new Float32Array(buf.buffer, buf.byteOffset, buf.byteLength / 4);
+        buf = this._subMesh.Normals();
+        let normals: Float32Array = new Float32Array(buf.buffer, buf.byteOffset, buf.byteLength / 4);
+
+        // Upload modified vertices and normals ranges only, dirty ranges are (first vertex, vertex count) pairs
+        let positionBuffer: BABYLON.VertexBuffer = this._babylonsMesh.getVertexBuffer(BABYLON.VertexBuffer.PositionKind);
+        let normalBuffer: BABYLON.VertexBuffer = this._babylonsMesh.getVertexBuffer(BABYLON.VertexBuffer.NormalKind);
+        for(let i: number = 0; i < dirtyRanges.length; i += 2)
+        {
+            let start: number = dirtyRanges[i] * 3;
+            let end: number = start + dirtyRanges[i + 1] * 3;
+            positionBuffer.updateDirectly(vertices.subarray(start, end), start * 4);
+            normalBuffer.updateDirectly(normals.subarray(start, end), start * 4);
         }
     }
 
@@ -7,6 +7,32 @@ declare module Module
 		delete();
 	}
 
+    class RayVector
+	{
+		constructor();
+		push_back(ray: Ray);
+		size(): number;
+		get(index: number): Ray;
+		delete();
+	}
+
+    interface RayHit
+	{
+		hasHit: boolean;
+		triangle: number;
+		distance: number;
+		point: Vector3;
+		normal: Vector3;
+	}
+
+    class RayHitVector
+	{
+		constructor();
+		size(): number;
+		get(index: number): RayHit;
+		delete();
+	}
+
     class SubMesh
     {
         GetID(): number;
@@ -14,6 +40,11 @@ declare module Module
         Triangles(): Int8Array;
         Vertices(): Int8Array;
         Normals(): Int8Array;
+        GetDirtyRangesBaseVersion(): number;
+        CanPartialUpdateFrom(versionNumber: number): boolean;
+        IsSharingBuffers(): boolean;
+        GetSharedFirstVertex(): number;
+        DirtyRanges(): Int8Array;
         GetBBox(): BBox;
         delete();
     }
@@ -24,6 +55,7 @@ declare module Module
 		Vertices(): Int8Array;
 		Normals(): Int8Array;
         GetClosestIntersectionPoint(ray: Ray, intersection: Vector3, normal: Vector3, cullBackFace: boolean): boolean;
+        IntersectRays(rays: RayVector, hits: RayHitVector, cullBackFace: boolean);
         GetFragmentsBBox(): BBoxVector;
         GetBBox(): BBox;
         IsManifold(): boolean;
@@ -38,6 +70,17 @@ declare module Module
         GetSubMeshCount(): number;
         GetSubMesh(index: number): SubMesh;
         IsSubMeshExist(subMeshID: number): boolean;
+        SetSubMeshesShareBuffers(shareBuffers: boolean);
+        AreSubMeshesSharingBuffers(): boolean;
+        SetUseBVH(useBVH: boolean);
+        IsUsingBVH(): boolean;
+        SetOctreeLooseness(looseness: number);
+        GetOctreeLooseness(): number;
+        SetOctreeLeafCapacity(maxTrianglesPerLeaf: number);
+        GetOctreeLeafCapacity(): number;
+        AutoTuneOctreeLeafCapacity(): number;
+        SetSubMeshesMaxVertices(maxVertices: number);
+        GetSubMeshesMaxVertices(): number;
         delete();
     }
 
@@ -116,6 +159,8 @@ declare module Module
         StartStroke();
         UpdateStroke(ray: Ray, radius: number, strengthRatio: number);
         EndStroke();
+        SetBatchStrokeSamples(batchStrokeSamples: boolean);
+        IsBatchingStrokeSamples(): boolean;
     }
 
     class BrushDraw extends Brush
@@ -148,6 +193,16 @@ declare module Module
         delete();
     }
 
+    class BrushSmooth extends Brush
+    {
+        constructor(meshes: Mesh);
+        SetIterations(nbIterations: number);
+        GetIterations(): number;
+        SetTaubin(taubin: boolean);
+        IsTaubin(): boolean;
+        delete();
+    }
+
     class SculptEngine
     {
         static SetTriangleOrientationInverted(value: boolean);